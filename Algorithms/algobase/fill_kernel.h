@@ -0,0 +1,295 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define __STL_FILL_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#define __STL_TARGET_SSE2
+#define __STL_TARGET_AVX2
+#else
+#include <cpuid.h>
+#include <immintrin.h>
+#define __STL_TARGET_SSE2 __attribute__((target("sse2")))
+#define __STL_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace STL {
+
+	enum { __FILL_PATTERN = 64, __STREAM_MIN = 64, __DEFAULT_LLC = 8 * 1024 * 1024 };
+
+	// A kernel writes `bytes' bytes of the periodic stream held in `pattern'
+	// (__FILL_PATTERN bytes, period a power of two of at most 16) to dst.
+	// bytes is always a multiple of the period.
+	using __fill_kernel = void (*)(void* dst, size_t bytes, const unsigned char* pattern);
+
+	// [p, p + done) already holds a whole number of periods; repeat it up
+	// to `bytes' by doubling.
+	inline void __fill_doubling(unsigned char* p, size_t done, size_t bytes) {
+		while (done < bytes) {
+			size_t chunk = done < bytes - done ? done : bytes - done;
+			memcpy(p + done, p, chunk);
+			done += chunk;
+		}
+	}
+
+	inline void __fill_scalar(void* dst, size_t bytes, const unsigned char* pattern) {
+		size_t done = bytes < static_cast<size_t>(__FILL_PATTERN) ? bytes : static_cast<size_t>(__FILL_PATTERN);
+		memcpy(dst, pattern, done);
+		__fill_doubling(static_cast<unsigned char*>(dst), done, bytes);
+	}
+
+#if defined(__STL_FILL_X86)
+	__STL_TARGET_SSE2 inline void __fill_sse2(void* dst, size_t bytes, const unsigned char* pattern) {
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern));
+		char* p = static_cast<char*>(dst);
+		for (; bytes >= 64; bytes -= 64, p += 64) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p + 16), v);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p + 32), v);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p + 48), v);
+		}
+		for (; bytes >= 16; bytes -= 16, p += 16)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+		memcpy(p, pattern, bytes);
+	}
+
+	__STL_TARGET_AVX2 inline void __fill_avx2(void* dst, size_t bytes, const unsigned char* pattern) {
+		const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pattern));
+		char* p = static_cast<char*>(dst);
+		for (; bytes >= 128; bytes -= 128, p += 128) {
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 32), v);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 64), v);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p + 96), v);
+		}
+		for (; bytes >= 32; bytes -= 32, p += 32)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+		memcpy(p, pattern, bytes);
+	}
+
+	inline bool __cpu_has_avx2() {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+		__cpuid(info, 1);
+		// The OS must save the upper halves of the ymm registers.
+		if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 6) != 6)
+			return false;
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	inline bool __cpu_has_sse2() {
+#if defined(__x86_64__) || defined(_M_X64)
+		return true;
+#elif defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 1);
+		return (info[3] & (1 << 26)) != 0;
+#else
+		return __builtin_cpu_supports("sse2");
+#endif
+	}
+
+	inline void __cpuid_regs(unsigned leaf, unsigned sub, unsigned r[4]) {
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, static_cast<int>(leaf), static_cast<int>(sub));
+		for (int i = 0; i < 4; ++i)
+			r[i] = static_cast<unsigned>(info[i]);
+#else
+		__cpuid_count(leaf, sub, r[0], r[1], r[2], r[3]);
+#endif
+	}
+
+	// Largest data or unified cache reported by the deterministic cache
+	// leaves (4 on Intel, 0x8000001d on AMD); 0 when neither is available.
+	inline size_t __cpu_llc_bytes() {
+		const unsigned leaves[2] = { 4, 0x8000001d };
+		size_t llc = 0;
+		for (int i = 0; i < 2; ++i) {
+			unsigned r[4];
+			__cpuid_regs(leaves[i] & 0x80000000, 0, r);
+			if (r[0] < leaves[i])
+				continue;
+			for (unsigned sub = 0; sub < 16; ++sub) {
+				__cpuid_regs(leaves[i], sub, r);
+				unsigned type = r[0] & 0x1f;
+				if (type == 0)
+					break;
+				if (type == 2)
+					continue;
+				size_t bytes = static_cast<size_t>((r[1] >> 22) + 1) * (((r[1] >> 12) & 0x3ff) + 1)
+					* ((r[1] & 0xfff) + 1) * (static_cast<size_t>(r[2]) + 1);
+				if (bytes > llc)
+					llc = bytes;
+			}
+			if (llc != 0)
+				break;
+		}
+		return llc;
+	}
+
+	// Non-temporal variants for ranges far larger than the cache: the
+	// destination is written around the cache hierarchy, then fenced so the
+	// stores are visible before the caller's next ordinary store.
+	__STL_TARGET_SSE2 inline void __fill_stream(void* dst, size_t bytes, const unsigned char* pattern) {
+		char* p = static_cast<char*>(dst);
+		const size_t head = (16 - (reinterpret_cast<uintptr_t>(p) & 15)) & 15;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_loadu_si128(reinterpret_cast<const __m128i*>(pattern)));
+		// Past the head the stream is at phase `head'; the period divides 16.
+		const unsigned char* phase = pattern + head;
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(phase));
+		p += head;
+		bytes -= head;
+		for (; bytes >= 64; bytes -= 64, p += 64) {
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p), v);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p + 16), v);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p + 32), v);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p + 48), v);
+		}
+		for (; bytes >= 16; bytes -= 16, p += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p), v);
+		_mm_sfence();
+		if (bytes != 0)
+			memcpy(p, phase, bytes);
+	}
+
+	// dst and src must not overlap.
+	__STL_TARGET_SSE2 inline void __copy_stream(void* dst, const void* src, size_t bytes) {
+		char* p = static_cast<char*>(dst);
+		const char* q = static_cast<const char*>(src);
+		const size_t head = (16 - (reinterpret_cast<uintptr_t>(p) & 15)) & 15;
+		if (head != 0)
+			memcpy(p, q, head);
+		p += head;
+		q += head;
+		bytes -= head;
+		for (; bytes >= 64; bytes -= 64, p += 64, q += 64) {
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + 16));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + 32));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p + 48), d);
+		}
+		for (; bytes >= 16; bytes -= 16, p += 16, q += 16)
+			_mm_stream_si128(reinterpret_cast<__m128i*>(p), _mm_loadu_si128(reinterpret_cast<const __m128i*>(q)));
+		_mm_sfence();
+		if (bytes != 0)
+			memcpy(p, q, bytes);
+	}
+#endif
+
+	inline std::atomic<size_t>& __nontemporal_threshold_ref() {
+		static std::atomic<size_t> threshold(0);
+		return threshold;
+	}
+
+	// Fills and copies of at least this many bytes bypass the cache. The
+	// default is half the last-level cache, so the range could not have
+	// stayed resident next to the rest of the working set anyway.
+	inline size_t nontemporal_threshold() {
+		size_t bytes = __nontemporal_threshold_ref().load(std::memory_order_relaxed);
+		if (bytes != 0)
+			return bytes;
+#if defined(__STL_FILL_X86)
+		bytes = __cpu_llc_bytes();
+#endif
+		bytes = (bytes != 0 ? bytes : static_cast<size_t>(__DEFAULT_LLC)) / 2;
+		size_t expected = 0;
+		if (!__nontemporal_threshold_ref().compare_exchange_strong(expected, bytes, std::memory_order_relaxed))
+			return expected;
+		return bytes;
+	}
+
+	// Returns the previous threshold. SIZE_MAX turns streaming off, 0
+	// restores the detected default.
+	inline size_t set_nontemporal_threshold(size_t bytes) {
+		size_t old = nontemporal_threshold();
+		__nontemporal_threshold_ref().store(bytes, std::memory_order_relaxed);
+		return old;
+	}
+
+	inline bool __use_nontemporal(size_t bytes) {
+#if defined(__STL_FILL_X86)
+		return bytes >= static_cast<size_t>(__STREAM_MIN) && bytes >= nontemporal_threshold() && __cpu_has_sse2();
+#else
+		return false;
+#endif
+	}
+
+	// memmove, streamed when the range is large and the buffers are disjoint.
+	inline void __copy_bytes(void* dst, const void* src, size_t bytes) {
+		if (bytes == 0)
+			return;
+#if defined(__STL_FILL_X86)
+		const char* d = static_cast<const char*>(dst);
+		const char* s = static_cast<const char*>(src);
+		if (__use_nontemporal(bytes) && (d + bytes <= s || s + bytes <= d)) {
+			__copy_stream(dst, src, bytes);
+			return;
+		}
+#endif
+		memmove(dst, src, bytes);
+	}
+
+	// Picked once, on first use.
+	inline __fill_kernel __select_fill_kernel() {
+#if defined(__STL_FILL_X86)
+		static const __fill_kernel kernel = __cpu_has_avx2() ? __fill_avx2 : __cpu_has_sse2() ? __fill_sse2 : __fill_scalar;
+		return kernel;
+#else
+		return __fill_scalar;
+#endif
+	}
+
+	inline bool __is_byte_pattern(const unsigned char* p, size_t n) {
+		for (size_t i = 1; i < n; ++i)
+			if (p[i] != p[0])
+				return false;
+		return true;
+	}
+
+	// Fills n objects of `width' bytes at dst with copies of *value, which the
+	// caller guarantees may be copied bytewise.
+	inline void __fill_bytes(void* dst, size_t n, const void* value, size_t width) {
+		const unsigned char* bytes = static_cast<const unsigned char*>(value);
+		if (n == 0)
+			return;
+		const bool stream = width <= 16 && (width & (width - 1)) == 0 && __use_nontemporal(n * width);
+		if (__is_byte_pattern(bytes, width) && !stream) {
+			memset(dst, bytes[0], n * width);
+			return;
+		}
+		if (width > 16 || (width & (width - 1)) != 0) {
+			memmove(dst, bytes, width);
+			__fill_doubling(static_cast<unsigned char*>(dst), width, n * width);
+			return;
+		}
+		unsigned char pattern[__FILL_PATTERN];
+		for (size_t i = 0; i < static_cast<size_t>(__FILL_PATTERN); i += width)
+			memcpy(pattern + i, bytes, width);
+#if defined(__STL_FILL_X86)
+		if (stream) {
+			__fill_stream(dst, n * width, pattern);
+			return;
+		}
+#endif
+		__select_fill_kernel()(dst, n * width, pattern);
+	}
+}
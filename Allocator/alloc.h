@@ -1,8 +1,25 @@
 #pragma once
 
 #include <new>
+#include <mutex>
+#ifdef __STL_ALLOC_LOCKFREE
+#include <atomic>
+#endif
 #include <string>
 #include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#if defined(_WIN32)
+#include <malloc.h>
+#else
+#include <sys/mman.h>
+#endif
+#ifdef __STL_ALLOC_STATS
+#include "alloc_stats.h"
+#endif
+#ifdef __STL_ALLOC_HARDENED
+#include "alloc_guard.h"
+#endif
 
 namespace STL {
 
@@ -14,25 +31,75 @@ namespace STL {
 		static void* oom_realloc(void*, size_t);
 		static void(*__malloc_alloc_oom_handler)();
 
+		static void oom_handler() {
+			void(*my_malloc_handler)() = __malloc_alloc_oom_handler;
+			if (my_malloc_handler == nullptr)
+				throw std::bad_alloc();
+			(*my_malloc_handler)();
+		}
+
 	public:
 		static void* allocate(size_t n) {
 			void* result = malloc(n);
 			if (result == nullptr)
 				result = oom_malloc(n);
+#ifdef __STL_ALLOC_STATS
+			__alloc_stats<inst>::record_allocate(__STATS_LARGE, n, n, result);
+#endif
 			return result;
 		}	
 
-		static void deallocate(void* p, size_t /* n */) {
+		static void deallocate(void* p, size_t n) {
+#ifdef __STL_ALLOC_STATS
+			__alloc_stats<inst>::record_deallocate(__STATS_LARGE, n, n, p);
+#else
+			(void)n;
+#endif
 			free(p);
 		}
 
-		static void* reallocate(void* p, size_t /* old_sz */, size_t new_sz) {
+		static void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+#ifdef __STL_ALLOC_STATS
+			__alloc_stats<inst>::record_deallocate(__STATS_LARGE, old_sz, old_sz, p);
+#else
+			(void)old_sz;
+#endif
 			void* result = realloc(p, new_sz);
 			if (result == nullptr)
 				result = oom_realloc(p, new_sz);
+#ifdef __STL_ALLOC_STATS
+			__alloc_stats<inst>::record_allocate(__STATS_LARGE, new_sz, new_sz, result);
+#endif
 			return result;
 		}
 
+		static void* allocate(size_t n, size_t align) {
+			void* result;
+#if defined(_WIN32)
+			while ((result = _aligned_malloc(n, align)) == nullptr)
+#else
+			while (posix_memalign(&result, align < sizeof(void*) ? sizeof(void*) : align, n) != 0)
+#endif
+				oom_handler();
+#ifdef __STL_ALLOC_STATS
+			__alloc_stats<inst>::record_allocate(__STATS_LARGE, n, n, result);
+#endif
+			return result;
+		}
+
+		static void deallocate(void* p, size_t n, size_t /* align */) {
+#ifdef __STL_ALLOC_STATS
+			__alloc_stats<inst>::record_deallocate(__STATS_LARGE, n, n, p);
+#else
+			(void)n;
+#endif
+#if defined(_WIN32)
+			_aligned_free(p);
+#else
+			free(p);
+#endif
+		}
+
 		static void(*set_malloc_handler(void(*f)()))() {
 			void (*old)() = __malloc_alloc_oom_handler;
 			__malloc_alloc_oom_handler = f;
@@ -65,7 +132,7 @@ namespace STL {
 		void* result;
 
 		for (;;) {
-			my_malloc_handler = _malloc_alloc_oom_handler;
+			my_malloc_handler = __malloc_alloc_oom_handler;
 			if (my_malloc_handler == nullptr)
 				throw std::bad_alloc();
 			result = realloc(p, n);
@@ -76,22 +143,173 @@ namespace STL {
 
 	enum { __ALIGN = 8, __MAX_BYTES = 128, __NFREELISTS = __MAX_BYTES / __ALIGN };
 
-	template <bool threads, int inst>
+	template <size_t Align = __ALIGN, size_t MaxBytes = __MAX_BYTES>
+	struct __linear_size_classes {
+		static_assert((Align & (Align - 1)) == 0 && MaxBytes % Align == 0, "bad linear size classes");
+		enum { align = Align, max_bytes = MaxBytes, count = MaxBytes / Align };
+
+		static size_t index(size_t bytes) { return (bytes + Align - 1) / Align - 1; }
+		static size_t size(size_t index) { return (index + 1) * Align; }
+	};
+
+	constexpr size_t __floor_pow2(size_t n) {
+		return n < 2 ? n : 2 * __floor_pow2(n / 2);
+	}
+
+	constexpr size_t __geometric_class_next(size_t bytes, size_t align, size_t steps) {
+		return bytes < align * steps ? bytes + align : bytes + __floor_pow2(bytes) / steps;
+	}
+
+	constexpr size_t __geometric_class_count(size_t bytes, size_t align, size_t max_bytes, size_t steps) {
+		return bytes >= max_bytes ? 1 : 1 + __geometric_class_count(__geometric_class_next(bytes, align, steps), align, max_bytes, steps);
+	}
+
+	template <size_t Align = __ALIGN, size_t MaxBytes = 512, size_t Steps = 4>
+	struct __geometric_size_classes {
+		static_assert((Align & (Align - 1)) == 0 && (Steps & (Steps - 1)) == 0, "align and steps must be powers of two");
+		static_assert(MaxBytes % Align == 0, "max_bytes must be a multiple of align");
+		enum { align = Align, max_bytes = MaxBytes, count = __geometric_class_count(Align, Align, MaxBytes, Steps) };
+
+		struct table {
+			size_t size[count];
+			unsigned short index[MaxBytes / Align];
+
+			constexpr table() : size(), index() {
+				size_t bytes = Align;
+				for (size_t i = 0; i < count; ++i) {
+					size[i] = bytes < MaxBytes ? bytes : MaxBytes;
+					bytes = __geometric_class_next(bytes, Align, Steps);
+				}
+				for (size_t i = 0, c = 0; i < MaxBytes / Align; ++i) {
+					if ((i + 1) * Align > size[c])
+						++c;
+					index[i] = static_cast<unsigned short>(c);
+				}
+			}
+		};
+		static constexpr table classes = table();
+
+		static size_t index(size_t bytes) { return classes.index[(bytes + Align - 1) / Align - 1]; }
+		// Out-of-range indices read the last class rather than past the table.
+		static size_t size(size_t index) { return classes.size[index < count ? index : count - 1]; }
+	};
+
+	template <size_t Align, size_t MaxBytes, size_t Steps>
+	constexpr typename __geometric_size_classes<Align, MaxBytes, Steps>::table __geometric_size_classes<Align, MaxBytes, Steps>::classes;
+
+	using __default_size_classes = __linear_size_classes<>;
+	enum { __DEPOT_BATCH = 32, __DEPOT_SLOTS = 64 };
+	enum { __CHUNK_BYTES = 256 * 1024 };
+	enum { __REFILL_INITIAL = 20, __REFILL_MIN = 8 };
+
+	struct __pool_chunk {
+		__pool_chunk* next;
+		size_t carved;
+		size_t free_bytes;
+		size_t node;
+	};
+
+	inline __pool_chunk* __pool_chunk_of(const void* p, size_t chunk_bytes) {
+		return reinterpret_cast<__pool_chunk*>(reinterpret_cast<uintptr_t>(p) & ~(static_cast<uintptr_t>(chunk_bytes) - 1));
+	}
+
+	struct __chunk_source {
+		enum { chunk_bytes = __CHUNK_BYTES, node = 0 };
+
+		static void* allocate(size_t bytes) {
+#if defined(_WIN32)
+			return _aligned_malloc(bytes, bytes);
+#else
+			void* p = mmap(nullptr, 2 * bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+				return nullptr;
+			char* first = static_cast<char*>(p);
+			char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(first) + bytes - 1) & ~(static_cast<uintptr_t>(bytes) - 1));
+			if (aligned != first)
+				munmap(first, aligned - first);
+			munmap(aligned + bytes, first + bytes - aligned);
+			return aligned;
+#endif
+		}
+
+		static void deallocate(void* p, size_t bytes) {
+#if defined(_WIN32)
+			_aligned_free(p);
+#else
+			munmap(p, bytes);
+#endif
+		}
+	};
+
+	template <size_t Classes>
+	struct pool_occupancy {
+		size_t chunks;
+		size_t empty_chunks;
+		size_t heap_bytes;
+		size_t tail_bytes;
+		size_t class_bytes[Classes];
+		size_t carved_objects[Classes];
+		size_t free_objects[Classes];
+	};
+
+	template <size_t Classes>
+	struct pool_refill_stats {
+		size_t batch[Classes];
+		size_t refills[Classes];
+		size_t refilled_objects[Classes];
+		size_t tail_waste_bytes[Classes];
+	};
+
+	template <bool threads, int inst, class SizeClasses = __default_size_classes, class ChunkSource = __chunk_source>
 	class __default_alloc_template {
 
 	private:
+		enum { __ALIGN = SizeClasses::align, __MAX_BYTES = SizeClasses::max_bytes, __NFREELISTS = SizeClasses::count };
+		enum { __CHUNK_BYTES = ChunkSource::chunk_bytes };
+		static_assert(__MAX_BYTES * __DEPOT_BATCH <= __CHUNK_BYTES / 4, "size classes too large for a pool chunk");
+#ifdef __STL_ALLOC_STATS
+		static_assert(static_cast<int>(__NFREELISTS) < static_cast<int>(__STATS_LARGE), "too many size classes for alloc stats");
+#endif
+#ifdef __STL_ALLOC_HARDENED
+		using guard = __alloc_guard<inst, __ALIGN>;
+		enum { __HARDENED = 1, __MAX_SMALL = static_cast<int>(__MAX_BYTES) - static_cast<int>(guard::front) - static_cast<int>(guard::rear) };
+		static_assert(__MAX_SMALL > 0, "size classes too small for guarded blocks");
+#else
+		enum { __HARDENED = 0, __MAX_SMALL = __MAX_BYTES };
+#endif
+
 		static size_t ROUND_UP(size_t bytes) {
-			return (bytes + static_cast<size_t>(_ALIGN) - 1) & ~(static_cast<size_t>(_ALIGN) - 1);
+			return SizeClasses::size(SizeClasses::index(bytes));
 		}
 	private:
 		union obj {
 			union obj* free_list_link;
 			char client_data[1];
 		};
+
+		struct __thread_cache {
+			obj* free_list[__NFREELISTS];
+			size_t count[__NFREELISTS];
+
+			__thread_cache() : free_list(), count() { }
+			~__thread_cache() { release(); }
+			void release();
+		};
+
+		using __chunk = __pool_chunk;
+
+		struct __lock {
+			__lock() { if (threads) pool_mutex.lock(); }
+			~__lock() { if (threads) pool_mutex.unlock(); }
+		};
 	private:
-		static obj* volatile free_list[_NFREELISTS];
+		static obj* volatile free_list[__NFREELISTS];
 		static size_t FREE_LIST_INDEX(size_t bytes) {
-			return ((bytes + static_cast<size_t>(_ALIGN) - 1) / static_cast<size_t>(_ALIGN) - 1);
+			return SizeClasses::index(bytes);
+		}
+		static size_t FLOOR_LIST_INDEX(size_t bytes) {
+			size_t index = SizeClasses::index(bytes);
+			return SizeClasses::size(index) > bytes ? index - 1 : index;
 		}
 		static void* refill(size_t n);
 		static char* chunk_alloc(size_t size, int &nobjs);
@@ -100,52 +318,201 @@ namespace STL {
 		static char* end_free;
 		static size_t heap_size;
 
+		static __chunk* chunk_list;
+		static __chunk* current_chunk;
+		static size_t carved_objects[__NFREELISTS];
+
+		static size_t refill_clock;
+		static size_t refill_objs[__NFREELISTS];
+		static size_t last_refill[__NFREELISTS];
+		static size_t refills[__NFREELISTS];
+		static size_t refilled_objects[__NFREELISTS];
+		static size_t tail_waste_bytes[__NFREELISTS];
+
+		static int refill_batch(size_t index);
+
+		static __chunk* chunk_of(const void* p) {
+			return __pool_chunk_of(p, __CHUNK_BYTES);
+		}
+		static bool chunk_unused(const __chunk* chunk) { return chunk->free_bytes == chunk->carved; }
+		static void dissolve_depot();
+		static void scan_chunks();
+
+	private:
+		static obj* depot[__NFREELISTS][__DEPOT_SLOTS];
+		static size_t depot_size[__NFREELISTS];
+		static std::mutex pool_mutex;
+#ifdef __STL_ALLOC_LOCKFREE
+		// Objects released by the thread caches. Pushes are plain CAS and the
+		// only pop takes the whole stack with one exchange, so there is no ABA.
+		static std::atomic<obj*> returned[__NFREELISTS];
+
+		static void return_push(obj* first, obj* last, size_t index);
+		static void drain_returned(size_t index);
+#endif
+
+		static __thread_cache& local_cache() {
+			static thread_local __thread_cache cache;
+			return cache;
+		}
+		static void* cache_allocate(size_t n);
+		static void cache_deallocate(obj* q, size_t n);
+		static obj* depot_fetch(size_t n, size_t& count);
+		static void depot_release(obj* first, obj* last, size_t count, size_t n);
+		static void central_allocate_batch(size_t n, size_t count, void** out);
+
 	public:
 		static void* allocate(size_t n);
 		static void deallocate(void* p, size_t n);
 		static void* reallocate(void* p, size_t old_sz, size_t new_sz);
+		static void allocate_batch(size_t n, size_t count, void** out);
+		static void deallocate_batch(size_t n, size_t count, void** p);
+		static bool pooled(size_t n) { return n <= static_cast<size_t>(__MAX_SMALL); }
+
+		static void* allocate(size_t n, size_t align) {
+			if (align <= static_cast<size_t>(__ALIGN))
+				return allocate(n);
+			return __malloc_alloc_template<inst>::allocate(n, align);
+		}
+		static void deallocate(void* p, size_t n, size_t align) {
+			if (align <= static_cast<size_t>(__ALIGN))
+				deallocate(p, n);
+			else
+				__malloc_alloc_template<inst>::deallocate(p, n, align);
+		}
+
+		static size_t trim();
+		static pool_occupancy<__NFREELISTS> occupancy();
+		static pool_refill_stats<__NFREELISTS> refill_stats();
 	};
 
-	template <bool threads, int inst>
-	char * __default_alloc_template<threads, inst>::start_free = nullptr;
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	char * __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::start_free = nullptr;
 
-	template <bool threads, int inst>
-	char* __default_alloc_template<threads, inst>::end_free = nullptr;
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	char* __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::end_free = nullptr;
 
-	template <bool threads, int inst>
-	size_t __default_alloc_template<threads, inst>::heap_size = 0;
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::heap_size = 0;
 
-	template <bool threads, int inst>
-	__default_alloc_template<threads, inst>::obj* volatile
-		__default_alloc_template<threads, inst>::free_list[_NFREELISTS] = {
-		nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
-		nullptr, nullptr, nullptr, nullptr, nullptr, nullptr
-	};
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	typename __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::__chunk* __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::chunk_list = nullptr;
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	typename __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::__chunk* __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::current_chunk = nullptr;
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::carved_objects[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refill_clock = 0;
 
-	template <bool threads, int inst>
-	void * __default_alloc_template<threads, inst>::allocate(size_t n) {
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refill_objs[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::last_refill[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refills[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refilled_objects[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::tail_waste_bytes[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	typename __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::obj* volatile
+		__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::free_list[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	typename __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::obj*
+		__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::depot[__NFREELISTS][__DEPOT_SLOTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::depot_size[__NFREELISTS] = { };
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	std::mutex __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::pool_mutex;
+
+#ifdef __STL_ALLOC_LOCKFREE
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	std::atomic<typename __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::obj*>
+		__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::returned[__NFREELISTS];
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::return_push(obj* first, obj* last, size_t index) {
+		obj* head = returned[index].load(std::memory_order_relaxed);
+		do {
+			last->free_list_link = head;
+		} while (!returned[index].compare_exchange_weak(head, first, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// Caller holds pool_mutex.
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::drain_returned(size_t index) {
+		obj* first = returned[index].exchange(nullptr, std::memory_order_acquire);
+		if (first == nullptr)
+			return;
+		obj* last = first;
+		while (last->free_list_link != nullptr)
+			last = last->free_list_link;
+		last->free_list_link = free_list[index];
+		free_list[index] = first;
+	}
+#endif
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void * __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::allocate(size_t n) {
 		obj* volatile *my_free_list;
 		obj* result;
-		if (n > static_cast<size_t>(_MAX_BYTES)) {
-			return __malloc_alloc_template<0>::allocate(n);
+		if (n > static_cast<size_t>(__MAX_SMALL)) {
+			return __malloc_alloc_template<inst>::allocate(n);
 		}
-		my_free_list = free_list + FREE_LIST_INDEX(n);
-		result = *my_free_list;
-		if (result == nullptr) {
-			void* r = refill(ROUND_UP(n));
-			return r;
+#ifdef __STL_ALLOC_HARDENED
+		const size_t user_n = n;
+		n = guard::guarded(n);
+#endif
+		if (threads)
+			result = reinterpret_cast<obj*>(cache_allocate(n));
+		else {
+			my_free_list = free_list + FREE_LIST_INDEX(n);
+			result = *my_free_list;
+			if (result == nullptr)
+				result = reinterpret_cast<obj*>(refill(ROUND_UP(n)));
+			else
+				*my_free_list = result->free_list_link;
 		}
-		*my_free_list = result->free_list_link;
+#ifdef __STL_ALLOC_STATS
+		__alloc_stats<inst>::record_allocate(FREE_LIST_INDEX(n), ROUND_UP(n), n, result);
+#endif
+#ifdef __STL_ALLOC_HARDENED
+		return guard::on_allocate(result, ROUND_UP(n), user_n);
+#else
 		return result;
+#endif
 	}
 
-	template <bool threads, int inst>
-	void __default_alloc_template<threads, inst>::deallocate(void* p, size_t n) {
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::deallocate(void* p, size_t n) {
 		obj* q = reinterpret_cast<obj *>(p);
 		obj* volatile *my_free_list;
 
-		if (n > (size_t)_MAX_BYTES) {
-			__malloc_alloc_template<0>::deallocate(p, n);
+		if (n > static_cast<size_t>(__MAX_SMALL)) {
+			__malloc_alloc_template<inst>::deallocate(p, n);
+			return;
+		}
+#ifdef __STL_ALLOC_HARDENED
+		p = guard::on_deallocate(p, ROUND_UP(guard::guarded(n)), n);
+		q = reinterpret_cast<obj*>(p);
+		n = guard::guarded(n);
+#endif
+#ifdef __STL_ALLOC_STATS
+		__alloc_stats<inst>::record_deallocate(FREE_LIST_INDEX(n), ROUND_UP(n), n, p);
+#endif
+		if (threads) {
+			cache_deallocate(q, n);
 			return;
 		}
 
@@ -154,10 +521,138 @@ namespace STL {
 		*my_free_list = q;
 	}
 
-	template <bool threads, int inst>
-	void * __default_alloc_template<threads, inst>::refill(size_t n) {
-		int nobjs = 20;
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::allocate_batch(size_t n, size_t count, void** out) {
+		size_t i = 0;
+		// Guarded blocks must each pass the checks in allocate.
+		if (n > static_cast<size_t>(__MAX_SMALL) || __HARDENED) {
+			try {
+				for (; i < count; ++i)
+					out[i] = allocate(n);
+			}
+			catch (...) {
+				while (i != 0)
+					deallocate(out[--i], n);
+				throw;
+			}
+			return;
+		}
+		if (threads) {
+			__thread_cache& cache = local_cache();
+			size_t index = FREE_LIST_INDEX(n);
+			for (obj* p = cache.free_list[index]; i < count && p != nullptr; p = cache.free_list[index]) {
+				out[i++] = p;
+				cache.free_list[index] = p->free_list_link;
+				--cache.count[index];
+			}
+			if (i < count) {
+				try {
+					__lock guard;
+					central_allocate_batch(ROUND_UP(n), count - i, out + i);
+				}
+				catch (...) {
+					while (i != 0)
+						cache_deallocate(reinterpret_cast<obj*>(out[--i]), n);
+					throw;
+				}
+			}
+		}
+		else
+			central_allocate_batch(ROUND_UP(n), count, out);
+#ifdef __STL_ALLOC_STATS
+		for (i = 0; i < count; ++i)
+			__alloc_stats<inst>::record_allocate(FREE_LIST_INDEX(n), ROUND_UP(n), n, out[i]);
+#endif
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::deallocate_batch(size_t n, size_t count, void** p) {
+		if (count == 0)
+			return;
+		if (n > static_cast<size_t>(__MAX_SMALL) || __HARDENED) {
+			for (size_t i = 0; i < count; ++i)
+				deallocate(p[i], n);
+			return;
+		}
+#ifdef __STL_ALLOC_STATS
+		for (size_t i = 0; i < count; ++i)
+			__alloc_stats<inst>::record_deallocate(FREE_LIST_INDEX(n), ROUND_UP(n), n, p[i]);
+#endif
+		size_t index = FREE_LIST_INDEX(n);
+		obj* first = reinterpret_cast<obj*>(p[0]);
+		obj* last = first;
+		for (size_t i = 1; i < count; ++i) {
+			last->free_list_link = reinterpret_cast<obj*>(p[i]);
+			last = last->free_list_link;
+		}
+		last->free_list_link = nullptr;
+		if (!threads) {
+			last->free_list_link = free_list[index];
+			free_list[index] = first;
+			return;
+		}
+
+		// Keep one depot batch in the thread cache and hand the rest over under a single lock.
+		__thread_cache& cache = local_cache();
+		size_t keep = static_cast<size_t>(__DEPOT_BATCH) > cache.count[index] ? static_cast<size_t>(__DEPOT_BATCH) - cache.count[index] : 0;
+		obj* split = first;
+		if (keep >= count) {
+			last->free_list_link = cache.free_list[index];
+			cache.free_list[index] = first;
+			cache.count[index] += count;
+			return;
+		}
+		if (keep != 0) {
+			for (size_t i = 1; i < keep; ++i)
+				split = split->free_list_link;
+			obj* rest = split->free_list_link;
+			split->free_list_link = cache.free_list[index];
+			cache.free_list[index] = first;
+			cache.count[index] += keep;
+			first = rest;
+		}
+		depot_release(first, last, count - keep, n);
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::central_allocate_batch(size_t n, size_t count, void** out) {
+		size_t index = FREE_LIST_INDEX(n);
+		size_t i = 0;
+#ifdef __STL_ALLOC_LOCKFREE
+		drain_returned(index);
+#endif
+		while (threads && count - i >= static_cast<size_t>(__DEPOT_BATCH) && depot_size[index] != 0) {
+			for (obj* p = depot[index][--depot_size[index]]; p != nullptr; p = p->free_list_link)
+				out[i++] = p;
+		}
+		for (obj* p = free_list[index]; i < count && p != nullptr; p = free_list[index]) {
+			out[i++] = p;
+			free_list[index] = p->free_list_link;
+		}
+		try {
+			const size_t max_objs = static_cast<size_t>(__CHUNK_BYTES) / n;
+			while (i < count) {
+				int nobjs = static_cast<int>(count - i < max_objs ? count - i : max_objs);
+				char* chunk = chunk_alloc(n, nobjs);
+				for (int k = 0; k < nobjs; ++k)
+					out[i++] = chunk + k * n;
+			}
+		}
+		catch (...) {
+			while (i != 0) {
+				obj* q = reinterpret_cast<obj*>(out[--i]);
+				q->free_list_link = free_list[index];
+				free_list[index] = q;
+			}
+			throw;
+		}
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void * __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refill(size_t n) {
+		int nobjs = refill_batch(FREE_LIST_INDEX(n));
 		char* chunk = chunk_alloc(n, nobjs);
+		refilled_objects[FREE_LIST_INDEX(n)] += nobjs;
 		obj* volatile *my_free_list;
 		obj* result;
 		obj* current_obj, *next_obj;
@@ -183,8 +678,8 @@ namespace STL {
 		return result;
 	}
 
-	template <bool threads, int inst>
-	char * __default_alloc_template<threads, inst>::chunk_alloc(size_t size, int& nobjs) {
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	char * __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::chunk_alloc(size_t size, int& nobjs) {
 		char* result;
 		size_t total_bytes = size * nobjs;
 		size_t bytes_left = end_free - start_free;
@@ -192,58 +687,315 @@ namespace STL {
 		if (bytes_left >= total_bytes) {
 			result = start_free;
 			start_free += total_bytes;
-			return result;
 		}
-		else if (bytes_left > size) {
+		else if (bytes_left >= size) {
 			nobjs = static_cast<int>(bytes_left / size);
 			total_bytes = size * nobjs;
 			result = start_free;
 			start_free += total_bytes;
-			return result;
 		}
 		else {
-			size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);
-			if (bytes_left > 0) {
-				obj* volatile *my_free_list = free_list + FREE_LIST_INDEX(bytes_left);
+			tail_waste_bytes[FREE_LIST_INDEX(size)] += bytes_left;
+			if (bytes_left >= static_cast<size_t>(__ALIGN)) {
+				size_t index = FLOOR_LIST_INDEX(bytes_left);
+				tail_waste_bytes[FREE_LIST_INDEX(size)] -= SizeClasses::size(index);
+				obj* volatile *my_free_list = free_list + index;
 				(reinterpret_cast<obj*>(start_free))->free_list_link = *my_free_list;
 				*my_free_list = reinterpret_cast<obj*>(start_free);
+				++carved_objects[index];
+				if (current_chunk != nullptr)
+					current_chunk->carved += SizeClasses::size(index);
 			}
 
-			start_free = reinterpret_cast<char*>(malloc(bytes_to_get));
+			start_free = reinterpret_cast<char*>(ChunkSource::allocate(__CHUNK_BYTES));
 			if (start_free == nullptr) {
 				obj* volatile *my_free_list, *p;
-				for (size_t i = size; i <= static_cast<size_t>(_MAX_BYTES); i += static_cast<size_t>(_ALIGN)) {
-					my_free_list = free_list + FREE_LIST_INDEX(i);
+				current_chunk = nullptr;
+				for (size_t index = FREE_LIST_INDEX(size); index < static_cast<size_t>(__NFREELISTS); ++index) {
+					my_free_list = free_list + index;
 					p = *my_free_list;
 					if (p != nullptr) {
 						*my_free_list = p->free_list_link;
+						--carved_objects[index];
 						start_free = reinterpret_cast<char*>(p);
-						end_free = start_free + i;
+						end_free = start_free + SizeClasses::size(index);
 						return chunk_alloc(size, nobjs);
 					}
 				}
 				end_free = nullptr;
-				start_free = reinterpret_cast<char*>(__malloc_alloc_template<0>::allocate(bytes_to_get));
+				throw std::bad_alloc();
 			}
-			heap_size += bytes_to_get;
-			end_free = start_free + bytes_to_get;
+#ifdef __STL_ALLOC_HARDENED
+			guard::poison(start_free, __CHUNK_BYTES);
+#endif
+			current_chunk = reinterpret_cast<__chunk*>(start_free);
+			current_chunk->next = chunk_list;
+			current_chunk->carved = 0;
+			current_chunk->free_bytes = 0;
+			current_chunk->node = ChunkSource::node;
+			chunk_list = current_chunk;
+			heap_size += __CHUNK_BYTES;
+			end_free = start_free + __CHUNK_BYTES;
+			start_free += (sizeof(__chunk) + static_cast<size_t>(__ALIGN) - 1) & ~(static_cast<size_t>(__ALIGN) - 1);
 			return chunk_alloc(size, nobjs);
 		}
+
+		carved_objects[FREE_LIST_INDEX(size)] += nobjs;
+		if (current_chunk != nullptr)
+			current_chunk->carved += total_bytes;
+		return result;
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	int __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refill_batch(size_t index) {
+		const size_t max_objs = static_cast<size_t>(__CHUNK_BYTES) / 4 / SizeClasses::size(index);
+		const size_t now = ++refill_clock;
+		size_t objs = refill_objs[index];
+
+		if (objs == 0)
+			objs = __REFILL_INITIAL;
+		else if (now - last_refill[index] <= static_cast<size_t>(__NFREELISTS))
+			objs = objs * 2 < max_objs ? objs * 2 : max_objs;
+		else if (now - last_refill[index] > 8 * static_cast<size_t>(__NFREELISTS))
+			objs = objs / 2 > static_cast<size_t>(__REFILL_MIN) ? objs / 2 : static_cast<size_t>(__REFILL_MIN);
+
+		refill_objs[index] = objs;
+		last_refill[index] = now;
+		++refills[index];
+		return static_cast<int>(objs);
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void * __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::cache_allocate(size_t n) {
+		__thread_cache& cache = local_cache();
+		size_t index = FREE_LIST_INDEX(n);
+		obj* result = cache.free_list[index];
+		if (result == nullptr)
+			result = depot_fetch(ROUND_UP(n), cache.count[index]);
+		cache.free_list[index] = result->free_list_link;
+		--cache.count[index];
+		return result;
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::cache_deallocate(obj* q, size_t n) {
+		__thread_cache& cache = local_cache();
+		size_t index = FREE_LIST_INDEX(n);
+		q->free_list_link = cache.free_list[index];
+		cache.free_list[index] = q;
+		if (++cache.count[index] < 2 * static_cast<size_t>(__DEPOT_BATCH))
+			return;
+
+		obj* first = cache.free_list[index];
+		obj* last = first;
+		for (int i = 1; i < __DEPOT_BATCH; ++i)
+			last = last->free_list_link;
+		cache.free_list[index] = last->free_list_link;
+		cache.count[index] -= __DEPOT_BATCH;
+		last->free_list_link = nullptr;
+		depot_release(first, last, __DEPOT_BATCH, n);
 	}
 
-	template <bool threads, int inst>
-	void * __default_alloc_template<threads, inst>::reallocate(void* p, size_t old_sz, size_t new_sz) {
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	typename __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::obj*
+		__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::depot_fetch(size_t n, size_t& count) {
+		size_t index = FREE_LIST_INDEX(n);
+		int nobjs;
+		char* chunk;
+#ifdef __STL_ALLOC_LOCKFREE
+		obj* returned_first = returned[index].exchange(nullptr, std::memory_order_acquire);
+		if (returned_first != nullptr) {
+			count = 1;
+			for (obj* p = returned_first->free_list_link; p != nullptr; p = p->free_list_link)
+				++count;
+			return returned_first;
+		}
+#endif
+		{
+			__lock guard;
+			if (depot_size[index] != 0) {
+				count = __DEPOT_BATCH;
+				return depot[index][--depot_size[index]];
+			}
+			obj* result = free_list[index];
+			if (result != nullptr) {
+				obj* last = result;
+				for (count = 1; count < static_cast<size_t>(__DEPOT_BATCH) && last->free_list_link != nullptr; ++count)
+					last = last->free_list_link;
+				free_list[index] = last->free_list_link;
+				last->free_list_link = nullptr;
+				return result;
+			}
+			nobjs = refill_batch(index);
+			chunk = chunk_alloc(n, nobjs);
+			refilled_objects[index] += nobjs;
+		}
+
+		obj* current_obj = reinterpret_cast<obj*>(chunk);
+		for (int i = 1; i < nobjs; ++i) {
+			obj* next_obj = reinterpret_cast<obj*>(reinterpret_cast<char*>(current_obj) + n);
+			current_obj->free_list_link = next_obj;
+			current_obj = next_obj;
+		}
+		current_obj->free_list_link = nullptr;
+		count = static_cast<size_t>(nobjs);
+		return reinterpret_cast<obj*>(chunk);
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::depot_release(obj* first, obj* last, size_t count, size_t n) {
+		size_t index = FREE_LIST_INDEX(n);
+#ifdef __STL_ALLOC_LOCKFREE
+		(void)count;
+		return_push(first, last, index);
+		return;
+#endif
+		__lock guard;
+		if (count == static_cast<size_t>(__DEPOT_BATCH) && depot_size[index] < static_cast<size_t>(__DEPOT_SLOTS)) {
+			depot[index][depot_size[index]++] = first;
+			return;
+		}
+		last->free_list_link = free_list[index];
+		free_list[index] = first;
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::__thread_cache::release() {
+		for (size_t index = 0; index < static_cast<size_t>(__NFREELISTS); ++index) {
+			obj* first = free_list[index];
+			if (first == nullptr)
+				continue;
+			obj* last = first;
+			while (last->free_list_link != nullptr)
+				last = last->free_list_link;
+			depot_release(first, last, count[index], SizeClasses::size(index));
+			free_list[index] = nullptr;
+			count[index] = 0;
+		}
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::dissolve_depot() {
+		for (size_t index = 0; index < static_cast<size_t>(__NFREELISTS); ++index) {
+#ifdef __STL_ALLOC_LOCKFREE
+			drain_returned(index);
+#endif
+			while (depot_size[index] != 0) {
+				obj* first = depot[index][--depot_size[index]];
+				obj* last = first;
+				while (last->free_list_link != nullptr)
+					last = last->free_list_link;
+				last->free_list_link = free_list[index];
+				free_list[index] = first;
+			}
+		}
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::scan_chunks() {
+		for (__chunk* chunk = chunk_list; chunk != nullptr; chunk = chunk->next)
+			chunk->free_bytes = 0;
+		for (size_t index = 0; index < static_cast<size_t>(__NFREELISTS); ++index) {
+			size_t bytes = SizeClasses::size(index);
+			for (obj* p = free_list[index]; p != nullptr; p = p->free_list_link)
+				chunk_of(p)->free_bytes += bytes;
+		}
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	size_t __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::trim() {
+		if (threads)
+			local_cache().release();
+
+		__lock guard;
+		dissolve_depot();
+		scan_chunks();
+
+		for (size_t index = 0; index < static_cast<size_t>(__NFREELISTS); ++index) {
+			obj* volatile *link = free_list + index;
+			while (*link != nullptr) {
+				if (chunk_unused(chunk_of(*link))) {
+					*link = (*link)->free_list_link;
+					--carved_objects[index];
+				}
+				else
+					link = &(*link)->free_list_link;
+			}
+		}
+
+		size_t released = 0;
+		__chunk** link = &chunk_list;
+		while (*link != nullptr) {
+			__chunk* chunk = *link;
+			if (!chunk_unused(chunk)) {
+				link = &chunk->next;
+				continue;
+			}
+			if (chunk == current_chunk) {
+				start_free = end_free = nullptr;
+				current_chunk = nullptr;
+			}
+			*link = chunk->next;
+			ChunkSource::deallocate(chunk, __CHUNK_BYTES);
+			heap_size -= __CHUNK_BYTES;
+			released += __CHUNK_BYTES;
+		}
+		return released;
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	pool_occupancy<__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::__NFREELISTS> __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::occupancy() {
+		pool_occupancy<__NFREELISTS> result = { };
+		__lock guard;
+		dissolve_depot();
+		scan_chunks();
+
+		for (__chunk* chunk = chunk_list; chunk != nullptr; chunk = chunk->next) {
+			++result.chunks;
+			if (chunk_unused(chunk))
+				++result.empty_chunks;
+		}
+		for (size_t index = 0; index < static_cast<size_t>(__NFREELISTS); ++index) {
+			result.class_bytes[index] = SizeClasses::size(index);
+			result.carved_objects[index] = carved_objects[index];
+			for (obj* p = free_list[index]; p != nullptr; p = p->free_list_link)
+				++result.free_objects[index];
+		}
+		result.heap_bytes = heap_size;
+		result.tail_bytes = end_free - start_free;
+		return result;
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	pool_refill_stats<__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::__NFREELISTS>
+		__default_alloc_template<threads, inst, SizeClasses, ChunkSource>::refill_stats() {
+		pool_refill_stats<__NFREELISTS> result = { };
+		__lock guard;
+		for (size_t index = 0; index < static_cast<size_t>(__NFREELISTS); ++index) {
+			result.batch[index] = refill_objs[index] != 0 ? refill_objs[index] : static_cast<size_t>(__REFILL_INITIAL);
+			result.refills[index] = refills[index];
+			result.refilled_objects[index] = refilled_objects[index];
+			result.tail_waste_bytes[index] = tail_waste_bytes[index];
+		}
+		return result;
+	}
+
+	template <bool threads, int inst, class SizeClasses, class ChunkSource>
+	void * __default_alloc_template<threads, inst, SizeClasses, ChunkSource>::reallocate(void* p, size_t old_sz, size_t new_sz) {
 		void* result;
 		size_t copy_sz;
 
-		if (old_sz > static_cast<size_t>(_MAX_BYTES) && new_sz > static_cast<size_t>(_MAX_BYTES))
-			return realloc(p, new_sz);
-		if (ROUND_UP(old_sz) == ROUND_UP(new_sz))
+		if (old_sz > static_cast<size_t>(__MAX_SMALL) && new_sz > static_cast<size_t>(__MAX_SMALL))
+			return __malloc_alloc_template<inst>::reallocate(p, old_sz, new_sz);
+		if (!__HARDENED && old_sz <= static_cast<size_t>(__MAX_SMALL) && new_sz <= static_cast<size_t>(__MAX_SMALL) && ROUND_UP(old_sz) == ROUND_UP(new_sz))
 			return p;
 		result = allocate(new_sz);
-		copy_sz = old_sz > new_sz ? old_sz : new_sz;
+		copy_sz = old_sz < new_sz ? old_sz : new_sz;
 		memcpy(result, p, copy_sz);
 		deallocate(p, old_sz);
 		return result;
 	}
+
+	using malloc_alloc = __malloc_alloc_template<0>;
+	using alloc = __default_alloc_template<false, 0>;
 }
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace STL {
+
+	enum { __GUARD_POISON = 0xdd, __GUARD_CANARY = 0xa5, __GUARD_REAR = 8 };
+
+	using alloc_corruption_handler = void (*)(int inst, const char* what, const void* p);
+
+	template <int inst>
+	class __alloc_guard_handler {
+
+	private:
+		static alloc_corruption_handler handler;
+
+	public:
+		static alloc_corruption_handler set_corruption_handler(alloc_corruption_handler f) {
+			alloc_corruption_handler old = handler;
+			handler = f;
+			return old;
+		}
+
+		// The handler may throw or exit; if it returns, the process aborts.
+		static void report(const char* what, const void* p) {
+			if (handler != nullptr)
+				(*handler)(inst, what, p);
+			fprintf(stderr, "STL alloc<%d>: %s at %p\n", inst, what, p);
+			abort();
+		}
+	};
+
+	template <int inst>
+	alloc_corruption_handler __alloc_guard_handler<inst>::handler = nullptr;
+
+	// Layout of a guarded block of class size `bytes' holding n user bytes:
+	//   [ link or alloc tag | size tag | pad ]  front, Align-rounded, at least two words
+	//   [ n user bytes ][ __GUARD_REAR canary bytes ][ poison up to bytes ]
+	// A free block keeps its free-list link in the first word and poison everywhere else.
+	template <int inst, size_t Align>
+	class __alloc_guard {
+
+	private:
+		static const uintptr_t ALLOC_TAG = static_cast<uintptr_t>(0xa110c8eda110c8edULL);
+		static const uintptr_t SIZE_TAG = static_cast<uintptr_t>(0x512e0f512e0f512eULL);
+
+		static uintptr_t POISON_WORD() {
+			uintptr_t word;
+			memset(&word, __GUARD_POISON, sizeof(word));
+			return word;
+		}
+		static uintptr_t& word(char* block, size_t i) { return reinterpret_cast<uintptr_t*>(block)[i]; }
+
+		static bool poisoned(const char* p, size_t bytes) {
+			for (; bytes != 0; --bytes, ++p)
+				if (static_cast<unsigned char>(*p) != __GUARD_POISON)
+					return false;
+			return true;
+		}
+
+		static void check_link(char* block) {
+			uintptr_t link = word(block, 0);
+			if (link == 0 || link == POISON_WORD())
+				return;
+			if (link % Align != 0 || word(reinterpret_cast<char*>(link), 1) != POISON_WORD())
+				__alloc_guard_handler<inst>::report("corrupted free-list link", block);
+		}
+
+	public:
+		enum { front = 2 * sizeof(void*) > Align ? 2 * sizeof(void*) : Align, rear = __GUARD_REAR };
+
+		static size_t guarded(size_t n) { return n + front + rear; }
+
+		static void poison(void* p, size_t bytes) { memset(p, __GUARD_POISON, bytes); }
+
+		// `block' was just taken off a free list or carved from a poisoned chunk.
+		static void* on_allocate(void* p, size_t bytes, size_t n) {
+			char* block = static_cast<char*>(p);
+			if (word(block, 1) != POISON_WORD() || !poisoned(block + 2 * sizeof(void*), bytes - 2 * sizeof(void*)))
+				__alloc_guard_handler<inst>::report("write to freed block", block + front);
+			check_link(block);
+
+			word(block, 0) = ALLOC_TAG ^ reinterpret_cast<uintptr_t>(block);
+			word(block, 1) = SIZE_TAG ^ n;
+			memset(block + front + n, __GUARD_CANARY, rear);
+			return block + front;
+		}
+
+		// Returns the block to hand back to the free list, poisoned.
+		static void* on_deallocate(void* p, size_t bytes, size_t n) {
+			char* block = static_cast<char*>(p) - front;
+			if (word(block, 0) != (ALLOC_TAG ^ reinterpret_cast<uintptr_t>(block))) {
+				if (word(block, 1) == POISON_WORD())
+					__alloc_guard_handler<inst>::report("double free", p);
+				__alloc_guard_handler<inst>::report("corrupted block header", p);
+			}
+			if (word(block, 1) != (SIZE_TAG ^ n))
+				__alloc_guard_handler<inst>::report("size mismatch in deallocate", p);
+			for (size_t i = 0; i < static_cast<size_t>(rear); ++i)
+				if (static_cast<unsigned char>(block[front + n + i]) != __GUARD_CANARY)
+					__alloc_guard_handler<inst>::report("buffer overflow past end of block", p);
+
+			poison(block + sizeof(void*), bytes - sizeof(void*));
+			return block;
+		}
+	};
+}
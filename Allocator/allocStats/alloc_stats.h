@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+namespace STL {
+
+	enum { __STATS_CLASSES = 64, __STATS_LARGE = __STATS_CLASSES - 1, __STATS_HISTOGRAM = 48 };
+
+	struct alloc_class_stats {
+		size_t class_bytes;
+		size_t allocations;
+		size_t frees;
+		size_t live_bytes;
+		size_t peak_bytes;
+	};
+
+	struct alloc_stats_snapshot {
+		int inst;
+		alloc_class_stats total;
+		alloc_class_stats classes[__STATS_CLASSES];
+		size_t histogram[__STATS_HISTOGRAM];
+	};
+
+	using alloc_trace_hook = void (*)(int inst, const void* p, size_t n, bool allocated);
+
+	template <int inst>
+	class __alloc_stats {
+
+	private:
+		struct __counters {
+			std::atomic<size_t> class_bytes;
+			std::atomic<size_t> allocations;
+			std::atomic<size_t> frees;
+			std::atomic<size_t> live_bytes;
+			std::atomic<size_t> peak_bytes;
+		};
+
+		static __counters total;
+		static __counters classes[__STATS_CLASSES];
+		static std::atomic<size_t> histogram[__STATS_HISTOGRAM];
+		static std::atomic<alloc_trace_hook> trace_hook;
+
+		static size_t HISTOGRAM_INDEX(size_t n) {
+			size_t bucket = 0;
+			while (n >>= 1)
+				++bucket;
+			return bucket < static_cast<size_t>(__STATS_HISTOGRAM) ? bucket : static_cast<size_t>(__STATS_HISTOGRAM) - 1;
+		}
+
+		static void raise_peak(__counters& c, size_t live) {
+			size_t peak = c.peak_bytes.load(std::memory_order_relaxed);
+			while (live > peak && !c.peak_bytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) { }
+		}
+
+		static void copy(alloc_class_stats& to, const __counters& from) {
+			to.class_bytes = from.class_bytes.load(std::memory_order_relaxed);
+			to.allocations = from.allocations.load(std::memory_order_relaxed);
+			to.frees = from.frees.load(std::memory_order_relaxed);
+			to.live_bytes = from.live_bytes.load(std::memory_order_relaxed);
+			to.peak_bytes = from.peak_bytes.load(std::memory_order_relaxed);
+		}
+
+	public:
+		static void record_allocate(size_t index, size_t bytes, size_t n, const void* p) {
+			__counters& c = classes[index];
+			c.class_bytes.store(index == static_cast<size_t>(__STATS_LARGE) ? 0 : bytes, std::memory_order_relaxed);
+			c.allocations.fetch_add(1, std::memory_order_relaxed);
+			raise_peak(c, c.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+			total.allocations.fetch_add(1, std::memory_order_relaxed);
+			raise_peak(total, total.live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+			histogram[HISTOGRAM_INDEX(n)].fetch_add(1, std::memory_order_relaxed);
+
+			if (alloc_trace_hook hook = trace_hook.load(std::memory_order_relaxed))
+				hook(inst, p, n, true);
+		}
+
+		static void record_deallocate(size_t index, size_t bytes, size_t n, const void* p) {
+			__counters& c = classes[index];
+			c.frees.fetch_add(1, std::memory_order_relaxed);
+			c.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+			total.frees.fetch_add(1, std::memory_order_relaxed);
+			total.live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+
+			if (alloc_trace_hook hook = trace_hook.load(std::memory_order_relaxed))
+				hook(inst, p, n, false);
+		}
+
+		static alloc_trace_hook set_trace_hook(alloc_trace_hook hook) {
+			return trace_hook.exchange(hook);
+		}
+
+		static alloc_stats_snapshot snapshot() {
+			alloc_stats_snapshot result = { };
+			result.inst = inst;
+			copy(result.total, total);
+			for (size_t i = 0; i < static_cast<size_t>(__STATS_CLASSES); ++i)
+				copy(result.classes[i], classes[i]);
+			for (size_t i = 0; i < static_cast<size_t>(__STATS_HISTOGRAM); ++i)
+				result.histogram[i] = histogram[i].load(std::memory_order_relaxed);
+			return result;
+		}
+
+		static void dump(std::ostream& os) {
+			alloc_stats_snapshot s = snapshot();
+			os << "alloc inst " << s.inst << ": " << s.total.allocations << " allocations, " << s.total.frees
+				<< " frees, " << s.total.live_bytes << " live bytes, " << s.total.peak_bytes << " peak bytes\n";
+			for (size_t i = 0; i < static_cast<size_t>(__STATS_CLASSES); ++i) {
+				const alloc_class_stats& c = s.classes[i];
+				if (c.allocations == 0)
+					continue;
+				if (i == static_cast<size_t>(__STATS_LARGE))
+					os << "  large";
+				else
+					os << "  " << c.class_bytes << "B";
+				os << ": " << c.allocations << " allocations, " << c.frees << " frees, "
+					<< c.live_bytes << " live bytes, " << c.peak_bytes << " peak bytes\n";
+			}
+			for (size_t i = 0; i < static_cast<size_t>(__STATS_HISTOGRAM); ++i)
+				if (s.histogram[i] != 0)
+					os << "  [" << (size_t(1) << i) << ", " << (size_t(1) << (i + 1)) << "): " << s.histogram[i] << "\n";
+		}
+	};
+
+	template <int inst>
+	typename __alloc_stats<inst>::__counters __alloc_stats<inst>::total;
+
+	template <int inst>
+	typename __alloc_stats<inst>::__counters __alloc_stats<inst>::classes[__STATS_CLASSES];
+
+	template <int inst>
+	std::atomic<size_t> __alloc_stats<inst>::histogram[__STATS_HISTOGRAM];
+
+	template <int inst>
+	std::atomic<alloc_trace_hook> __alloc_stats<inst>::trace_hook;
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <new>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace STL {
+
+	template <bool threads, int inst>
+	class __arena_alloc_template {
+
+	private:
+		enum { __ALIGN = 8, __INITIAL_BLOCK = 64 * 1024 };
+
+		static size_t ROUND_UP(size_t bytes) {
+			return (bytes + static_cast<size_t>(__ALIGN) - 1) & ~(static_cast<size_t>(__ALIGN) - 1);
+		}
+
+		// A zero-byte request still takes one slot, so it gets a distinct,
+		// non-null address.
+		static size_t SLOT_SIZE(size_t bytes) {
+			return bytes == 0 ? static_cast<size_t>(__ALIGN) : ROUND_UP(bytes);
+		}
+
+		static char* ALIGN_UP(char* p, size_t align) {
+			return reinterpret_cast<char*>((reinterpret_cast<size_t>(p) + align - 1) & ~(align - 1));
+		}
+
+	private:
+		struct __block {
+			__block* next;
+			char* end;
+			bool owned;
+		};
+
+		struct __arena {
+			__block* first;
+			__block* current;
+			char* cur;
+			char* end;
+			size_t next_size;
+
+			__arena() : first(nullptr), current(nullptr), cur(nullptr), end(nullptr), next_size(__INITIAL_BLOCK) { }
+			~__arena() { release_owned(); }
+
+			void release_owned();
+			void rewind();
+			void append(__block* block);
+			void* grow(size_t n);
+		};
+
+		static __arena shared_arena;
+		static thread_local __arena local_arena;
+
+		// Only the flavour in use is instantiated, so the shared arena never
+		// drags in thread_local storage.
+		static __arena& arena() {
+			if constexpr (threads)
+				return local_arena;
+			else
+				return shared_arena;
+		}
+		static char* block_begin(__block* block) {
+			return reinterpret_cast<char*>(block) + ROUND_UP(sizeof(__block));
+		}
+
+	public:
+		static void* allocate(size_t n) {
+			__arena& a = arena();
+			n = SLOT_SIZE(n);
+			if (static_cast<size_t>(a.end - a.cur) < n)
+				return a.grow(n);
+			void* result = a.cur;
+			a.cur += n;
+			return result;
+		}
+
+		static void deallocate(void* /* p */, size_t /* n */) { }
+
+		static void* allocate(size_t n, size_t align) {
+			if (align <= static_cast<size_t>(__ALIGN))
+				return allocate(n);
+			__arena& a = arena();
+			n = SLOT_SIZE(n);
+			char* result = ALIGN_UP(a.cur, align);
+			if (a.cur == nullptr || result > a.end || static_cast<size_t>(a.end - result) < n) {
+				result = ALIGN_UP(static_cast<char*>(a.grow(n + align)), align);
+				a.cur = result + n;
+				return result;
+			}
+			a.cur = result + n;
+			return result;
+		}
+
+		static void deallocate(void* /* p */, size_t /* n */, size_t /* align */) { }
+
+		static void allocate_batch(size_t n, size_t count, void** out) {
+			n = ROUND_UP(n);
+			char* p = static_cast<char*>(allocate(n * count));
+			for (size_t i = 0; i < count; ++i)
+				out[i] = p + i * n;
+		}
+
+		static void deallocate_batch(size_t /* n */, size_t /* count */, void** /* p */) { }
+
+		static void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+			__arena& a = arena();
+			if (static_cast<char*>(p) + SLOT_SIZE(old_sz) == a.cur
+				&& static_cast<size_t>(a.end - static_cast<char*>(p)) >= SLOT_SIZE(new_sz)) {
+				a.cur = static_cast<char*>(p) + SLOT_SIZE(new_sz);
+				return p;
+			}
+			void* result = allocate(new_sz);
+			memcpy(result, p, old_sz < new_sz ? old_sz : new_sz);
+			return result;
+		}
+
+		static void add_buffer(void* buffer, size_t bytes);
+		static void reset();
+	};
+
+	template <bool threads, int inst>
+	typename __arena_alloc_template<threads, inst>::__arena __arena_alloc_template<threads, inst>::shared_arena;
+
+	template <bool threads, int inst>
+	thread_local typename __arena_alloc_template<threads, inst>::__arena __arena_alloc_template<threads, inst>::local_arena;
+
+	template <bool threads, int inst>
+	void __arena_alloc_template<threads, inst>::__arena::release_owned() {
+		__block** link = &first;
+		while (*link != nullptr) {
+			__block* block = *link;
+			if (block->owned) {
+				*link = block->next;
+				free(block);
+			}
+			else
+				link = &block->next;
+		}
+	}
+
+	template <bool threads, int inst>
+	void __arena_alloc_template<threads, inst>::__arena::rewind() {
+		current = first;
+		cur = first != nullptr ? block_begin(first) : nullptr;
+		end = first != nullptr ? first->end : nullptr;
+		next_size = __INITIAL_BLOCK;
+	}
+
+	template <bool threads, int inst>
+	void __arena_alloc_template<threads, inst>::__arena::append(__block* block) {
+		block->next = nullptr;
+		if (first == nullptr) {
+			first = block;
+			return;
+		}
+		__block* last = current != nullptr ? current : first;
+		while (last->next != nullptr)
+			last = last->next;
+		last->next = block;
+	}
+
+	template <bool threads, int inst>
+	void* __arena_alloc_template<threads, inst>::__arena::grow(size_t n) {
+		__block* block = current != nullptr ? current->next : first;
+		while (block != nullptr && static_cast<size_t>(block->end - block_begin(block)) < n)
+			block = block->next;
+
+		if (block == nullptr) {
+			size_t bytes = ROUND_UP(sizeof(__block)) + n;
+			if (bytes < next_size)
+				bytes = next_size;
+			block = static_cast<__block*>(malloc(bytes));
+			if (block == nullptr)
+				throw std::bad_alloc();
+			block->end = reinterpret_cast<char*>(block) + bytes;
+			block->owned = true;
+			append(block);
+			next_size = bytes * 2;
+		}
+
+		current = block;
+		cur = block_begin(block) + n;
+		end = block->end;
+		return block_begin(block);
+	}
+
+	template <bool threads, int inst>
+	void __arena_alloc_template<threads, inst>::add_buffer(void* buffer, size_t bytes) {
+		char* first = reinterpret_cast<char*>(ROUND_UP(reinterpret_cast<size_t>(buffer)));
+		char* last = static_cast<char*>(buffer) + bytes;
+		if (last - first < static_cast<ptrdiff_t>(ROUND_UP(sizeof(__block)) + __ALIGN))
+			return;
+		__block* block = reinterpret_cast<__block*>(first);
+		block->end = last;
+		block->owned = false;
+		arena().append(block);
+	}
+
+	template <bool threads, int inst>
+	void __arena_alloc_template<threads, inst>::reset() {
+		__arena& a = arena();
+		a.release_owned();
+		a.rewind();
+	}
+
+	using arena_alloc = __arena_alloc_template<false, 0>;
+	using thread_arena_alloc = __arena_alloc_template<true, 0>;
+}
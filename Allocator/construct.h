@@ -1,13 +1,15 @@
 #pragma once
 
 #include <new>
+#include <utility>
 #include "typeTraits.h"
+#include "stl_iterator.h"
 
 namespace STL {
 
-	template <class T1, class T2>
-	inline void construct(T1* p, const T2& value) {
-		new(p) T1(value);
+	template <class T1, class... Args>
+	inline void construct(T1* p, Args&&... args) {
+		new(p) T1(std::forward<Args>(args)...);
 	}
 
 	template<class T>
@@ -16,25 +18,20 @@ namespace STL {
 	}
 
 	template<class ForwardIterator>
-	inline void destroy(ForwardIterator first, ForwardIterator last) {
-		__destroy(first, last, value_type(first));
+	inline void __destroy_aux(ForwardIterator first, ForwardIterator last, __false_type) {
+		for (; first != last; ++first)
+			destroy(&*first);
 	}
 
 	template<class ForwardIterator>
-	inline void __destroy(ForwardIterator first, ForwardIterator last) {
-		using is_POD = typename __type_traits<ForwardIterator>::is_POD_type;
-		__destroy_aux(first, last, is_POD());
-	}
+	inline void __destroy_aux(ForwardIterator, ForwardIterator, __true_type) {}
 
 	template<class ForwardIterator>
-	inline void __destroy(ForwardIterator first, ForwardIterator last, __false_type) {
-		for (; first != last; ++first)
-			destory(&*first);
+	inline void destroy(ForwardIterator first, ForwardIterator last) {
+		using trivial_destructor = typename __type_traits<value_type_t<ForwardIterator> >::has_trivial_destructor_constructor;
+		__destroy_aux(first, last, trivial_destructor());
 	}
 
-	template<class ForwardIterator>
-	inline void __destroy_aux(ForwardIterator first, ForwardIterator last, __true_type) {}
-
 	inline void destroy(char*, char*) {}
 	inline void destroy(wchar_t*, wchar_t*) {}
 }
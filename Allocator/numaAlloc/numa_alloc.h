@@ -0,0 +1,232 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdio>
+#include <utility>
+#include "alloc.h"
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace STL {
+
+	enum { __HUGE_PAGE_BYTES = 2 * 1024 * 1024 };
+
+	struct __hugepage_chunk_source {
+		enum { chunk_bytes = __HUGE_PAGE_BYTES, node = 0 };
+
+		static void* allocate(size_t bytes) {
+#if defined(__linux__)
+			void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+				return p;
+			p = __chunk_source::allocate(bytes);
+			if (p != nullptr)
+				madvise(p, bytes, MADV_HUGEPAGE);
+			return p;
+#else
+			return __chunk_source::allocate(bytes);
+#endif
+		}
+
+		static void deallocate(void* p, size_t bytes) {
+			__chunk_source::deallocate(p, bytes);
+		}
+	};
+
+	template <size_t MaxNodes = 8>
+	struct __numa_node_policy {
+		enum { max_nodes = MaxNodes };
+
+	private:
+		enum { __REFRESH = 1024 };
+
+		static std::atomic<size_t>& simulated() {
+			static std::atomic<size_t> nodes(0);
+			return nodes;
+		}
+
+		static size_t detect_nodes() {
+			size_t n = 0;
+#if defined(__linux__)
+			char path[64];
+			for (; n < MaxNodes; ++n) {
+				snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu", n);
+				if (access(path, F_OK) != 0)
+					break;
+			}
+#endif
+			return n != 0 ? n : 1;
+		}
+
+		static size_t lookup() {
+#if defined(__linux__) && defined(SYS_getcpu)
+			unsigned cpu = 0, node = 0;
+			if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 && node < MaxNodes)
+				return node;
+#endif
+			return 0;
+		}
+
+	public:
+		static void simulate(size_t nodes) {
+			simulated() = nodes < MaxNodes ? nodes : MaxNodes;
+		}
+
+		static size_t nodes() {
+			static const size_t detected = detect_nodes();
+			size_t n = simulated();
+			return n != 0 ? n : detected;
+		}
+
+		// getcpu is a system call, so each thread keeps the node it last saw
+		// and asks again every __REFRESH calls, often enough to follow a
+		// thread the scheduler has moved.
+		static size_t current() {
+			size_t n = simulated();
+			if (n != 0) {
+				static std::atomic<size_t> next_thread(0);
+				static thread_local size_t assigned = next_thread++;
+				return assigned % n;
+			}
+			static thread_local size_t node = 0;
+			static thread_local size_t calls = 0;
+			if (calls++ % __REFRESH == 0)
+				node = lookup();
+			return node;
+		}
+
+		static void bind(void* p, size_t bytes, size_t node) {
+#if defined(__linux__) && defined(SYS_mbind)
+			if (simulated() != 0)
+				return;
+			const int mpol_preferred = 1;
+			unsigned long mask = 1UL << node;
+			syscall(SYS_mbind, p, bytes, mpol_preferred, &mask, sizeof(mask) * 8, 0);
+#endif
+		}
+	};
+
+	template <class Source, class NodePolicy, size_t Node>
+	struct __node_chunk_source {
+		enum { chunk_bytes = Source::chunk_bytes, node = Node };
+
+		static void* allocate(size_t bytes) {
+			void* p = Source::allocate(bytes);
+			if (p != nullptr)
+				NodePolicy::bind(p, bytes, Node);
+			return p;
+		}
+
+		static void deallocate(void* p, size_t bytes) {
+			Source::deallocate(p, bytes);
+		}
+	};
+
+	template <bool threads, int inst, class SizeClasses = __default_size_classes,
+		class ChunkSource = __chunk_source, class NodePolicy = __numa_node_policy<> >
+	class __numa_alloc_template {
+
+	private:
+		enum { __NODES = NodePolicy::max_nodes };
+
+		template <size_t Node>
+		using node_pool = __default_alloc_template<threads, inst, SizeClasses, __node_chunk_source<ChunkSource, NodePolicy, Node> >;
+
+		struct __pool_ops {
+			void* (*allocate)(size_t);
+			void (*deallocate)(void*, size_t);
+			void (*allocate_batch)(size_t, size_t, void**);
+			void (*deallocate_batch)(size_t, size_t, void**);
+			size_t (*trim)();
+		};
+
+		template <size_t... Nodes>
+		static const __pool_ops* pools(std::index_sequence<Nodes...>) {
+			static const __pool_ops table[] = {
+				{ &node_pool<Nodes>::allocate, &node_pool<Nodes>::deallocate,
+				  &node_pool<Nodes>::allocate_batch, &node_pool<Nodes>::deallocate_batch, &node_pool<Nodes>::trim }...
+			};
+			return table;
+		}
+
+		static const __pool_ops& pool(size_t node) {
+			return pools(std::make_index_sequence<__NODES>())[node];
+		}
+
+	public:
+		static void* allocate(size_t n) {
+			if (!node_pool<0>::pooled(n))
+				return __malloc_alloc_template<inst>::allocate(n);
+			return pool(NodePolicy::current()).allocate(n);
+		}
+
+		static void deallocate(void* p, size_t n) {
+			if (!node_pool<0>::pooled(n)) {
+				__malloc_alloc_template<inst>::deallocate(p, n);
+				return;
+			}
+			pool(__pool_chunk_of(p, ChunkSource::chunk_bytes)->node).deallocate(p, n);
+		}
+
+		static void* allocate(size_t n, size_t align) {
+			if (align <= static_cast<size_t>(SizeClasses::align))
+				return allocate(n);
+			return __malloc_alloc_template<inst>::allocate(n, align);
+		}
+
+		static void deallocate(void* p, size_t n, size_t align) {
+			if (align <= static_cast<size_t>(SizeClasses::align))
+				deallocate(p, n);
+			else
+				__malloc_alloc_template<inst>::deallocate(p, n, align);
+		}
+
+		static void allocate_batch(size_t n, size_t count, void** out) {
+			pool(!node_pool<0>::pooled(n) ? 0 : NodePolicy::current()).allocate_batch(n, count, out);
+		}
+
+		// Runs of objects from the same node go back to their pool together.
+		static void deallocate_batch(size_t n, size_t count, void** p) {
+			if (!node_pool<0>::pooled(n)) {
+				pool(0).deallocate_batch(n, count, p);
+				return;
+			}
+			size_t first = 0;
+			while (first < count) {
+				size_t node = node_of(p[first]);
+				size_t last = first + 1;
+				while (last < count && node_of(p[last]) == node)
+					++last;
+				pool(node).deallocate_batch(n, last - first, p + first);
+				first = last;
+			}
+		}
+
+		static void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+			if (!node_pool<0>::pooled(old_sz) && !node_pool<0>::pooled(new_sz))
+				return __malloc_alloc_template<inst>::reallocate(p, old_sz, new_sz);
+			void* result = allocate(new_sz);
+			memcpy(result, p, old_sz < new_sz ? old_sz : new_sz);
+			deallocate(p, old_sz);
+			return result;
+		}
+
+		static size_t node_of(const void* p) {
+			return __pool_chunk_of(p, ChunkSource::chunk_bytes)->node;
+		}
+
+		static size_t trim() {
+			size_t released = 0;
+			for (size_t node = 0; node < static_cast<size_t>(__NODES); ++node)
+				released += pool(node).trim();
+			return released;
+		}
+	};
+
+	using hugepage_alloc = __default_alloc_template<false, 0, __default_size_classes, __hugepage_chunk_source>;
+	using numa_alloc = __numa_alloc_template<true, 0>;
+}
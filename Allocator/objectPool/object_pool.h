@@ -0,0 +1,320 @@
+#pragma once
+
+#include <mutex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "allocator.h"
+
+namespace STL {
+
+	enum { __SLAB_BYTES = 4096, __SLAB_MIN_OBJECTS = 8 };
+
+	inline size_t __slab_lowest_bit(uint64_t word) {
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return index;
+#else
+		return static_cast<size_t>(__builtin_ctzll(word));
+#endif
+	}
+
+	constexpr size_t __slab_bytes(size_t object_bytes, size_t bytes = __SLAB_BYTES) {
+		return bytes / object_bytes >= 2 * static_cast<size_t>(__SLAB_MIN_OBJECTS) ? bytes : __slab_bytes(object_bytes, bytes * 2);
+	}
+
+	struct slab_occupancy {
+		size_t slab_bytes;
+		size_t objects_per_slab;
+		size_t slabs;
+		size_t full_slabs;
+		size_t partial_slabs;
+		size_t empty_slabs;
+		size_t live_objects;
+	};
+
+	// Per-type slab cache. Each slab is a SLAB-aligned block holding a header,
+	// a free bitmap and a packed array of T; the lowest free slot is always
+	// handed out first, so a freshly built container walks memory in order.
+	template <class T, bool threads = false, int inst = 0>
+	class object_pool {
+
+	private:
+		enum { __OBJECT = sizeof(T), __SLAB = __slab_bytes(sizeof(T)) };
+		enum { __WORDS = (__SLAB / __OBJECT + 63) / 64 };
+
+		struct __slab {
+			__slab* next;
+			__slab* prev;
+			size_t live;
+			size_t hint;
+			uint64_t free_bits[__WORDS];
+		};
+
+		enum { __HEADER = (sizeof(__slab) + alignof(T) - 1) & ~(alignof(T) - 1) };
+		enum { __CAPACITY = (__SLAB - __HEADER) / __OBJECT };
+		static_assert(static_cast<int>(__CAPACITY) >= static_cast<int>(__SLAB_MIN_OBJECTS), "slab too small for its objects");
+		static_assert(__CAPACITY <= __WORDS * 64, "slab bitmap too small");
+
+		struct __lock {
+			__lock() { if (threads) pool_mutex.lock(); }
+			~__lock() { if (threads) pool_mutex.unlock(); }
+		};
+
+	private:
+		static __slab* partial;
+		static __slab* partial_tail;
+		static __slab* spare;
+		static size_t slabs;
+		static size_t full_slabs;
+		static size_t partial_slabs;
+		static size_t live_objects;
+		static std::mutex pool_mutex;
+
+		static __slab* slab_of(const T* p) {
+			return reinterpret_cast<__slab*>(reinterpret_cast<uintptr_t>(p) & ~(static_cast<uintptr_t>(__SLAB) - 1));
+		}
+		static T* object(__slab* s, size_t index) {
+			return reinterpret_cast<T*>(reinterpret_cast<char*>(s) + __HEADER + index * __OBJECT);
+		}
+		static size_t index_of(__slab* s, const T* p) {
+			return static_cast<size_t>(reinterpret_cast<const char*>(p) - reinterpret_cast<char*>(s) - __HEADER) / __OBJECT;
+		}
+
+		static void link_front(__slab* s);
+		static void link_back(__slab* s);
+		static void unlink(__slab* s);
+		static __slab* new_slab();
+		static T* take();
+		static void give(T* p);
+
+	public:
+		static T* allocate();
+		static void deallocate(T* p);
+		static void allocate_batch(size_t n, T** out);
+		static void deallocate_batch(T** p, size_t n);
+
+		static size_t trim();
+		static slab_occupancy occupancy();
+	};
+
+	template <class T, bool threads, int inst>
+	typename object_pool<T, threads, inst>::__slab* object_pool<T, threads, inst>::partial = nullptr;
+
+	template <class T, bool threads, int inst>
+	typename object_pool<T, threads, inst>::__slab* object_pool<T, threads, inst>::partial_tail = nullptr;
+
+	template <class T, bool threads, int inst>
+	typename object_pool<T, threads, inst>::__slab* object_pool<T, threads, inst>::spare = nullptr;
+
+	template <class T, bool threads, int inst>
+	size_t object_pool<T, threads, inst>::slabs = 0;
+
+	template <class T, bool threads, int inst>
+	size_t object_pool<T, threads, inst>::full_slabs = 0;
+
+	template <class T, bool threads, int inst>
+	size_t object_pool<T, threads, inst>::partial_slabs = 0;
+
+	template <class T, bool threads, int inst>
+	size_t object_pool<T, threads, inst>::live_objects = 0;
+
+	template <class T, bool threads, int inst>
+	std::mutex object_pool<T, threads, inst>::pool_mutex;
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::link_front(__slab* s) {
+		s->prev = nullptr;
+		s->next = partial;
+		if (partial != nullptr)
+			partial->prev = s;
+		else
+			partial_tail = s;
+		partial = s;
+		++partial_slabs;
+	}
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::link_back(__slab* s) {
+		s->next = nullptr;
+		s->prev = partial_tail;
+		if (partial_tail != nullptr)
+			partial_tail->next = s;
+		else
+			partial = s;
+		partial_tail = s;
+		++partial_slabs;
+	}
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::unlink(__slab* s) {
+		if (s->prev != nullptr)
+			s->prev->next = s->next;
+		else
+			partial = s->next;
+		if (s->next != nullptr)
+			s->next->prev = s->prev;
+		else
+			partial_tail = s->prev;
+		--partial_slabs;
+	}
+
+	template <class T, bool threads, int inst>
+	typename object_pool<T, threads, inst>::__slab* object_pool<T, threads, inst>::new_slab() {
+		__slab* s = spare;
+		if (s != nullptr)
+			spare = nullptr;
+		else {
+			s = static_cast<__slab*>(__malloc_alloc_template<inst>::allocate(__SLAB, __SLAB));
+			++slabs;
+		}
+		s->live = 0;
+		s->hint = 0;
+		memset(s->free_bits, 0, sizeof(s->free_bits));
+		for (size_t i = 0; i < static_cast<size_t>(__CAPACITY); ++i)
+			s->free_bits[i / 64] |= uint64_t(1) << (i % 64);
+		link_front(s);
+		return s;
+	}
+
+	template <class T, bool threads, int inst>
+	T* object_pool<T, threads, inst>::take() {
+		__slab* s = partial != nullptr ? partial : new_slab();
+		while (s->free_bits[s->hint] == 0)
+			++s->hint;
+		size_t bit = __slab_lowest_bit(s->free_bits[s->hint]);
+		s->free_bits[s->hint] &= ~(uint64_t(1) << bit);
+		if (++s->live == static_cast<size_t>(__CAPACITY)) {
+			unlink(s);
+			++full_slabs;
+		}
+		++live_objects;
+		return object(s, s->hint * 64 + bit);
+	}
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::give(T* p) {
+		__slab* s = slab_of(p);
+		size_t index = index_of(s, p);
+		s->free_bits[index / 64] |= uint64_t(1) << (index % 64);
+		if (index / 64 < s->hint)
+			s->hint = index / 64;
+		--live_objects;
+		// A slab that fills up leaves the list; when it gets room again it
+		// queues behind the slab currently being filled.
+		if (s->live-- == static_cast<size_t>(__CAPACITY)) {
+			--full_slabs;
+			link_back(s);
+		}
+		if (s->live != 0)
+			return;
+		unlink(s);
+		if (spare == nullptr)
+			spare = s;
+		else {
+			__malloc_alloc_template<inst>::deallocate(s, __SLAB, __SLAB);
+			--slabs;
+		}
+	}
+
+	template <class T, bool threads, int inst>
+	T* object_pool<T, threads, inst>::allocate() {
+		__lock guard;
+		return take();
+	}
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::deallocate(T* p) {
+		__lock guard;
+		give(p);
+	}
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::allocate_batch(size_t n, T** out) {
+		__lock guard;
+		size_t i = 0;
+		try {
+			for (; i < n; ++i)
+				out[i] = take();
+		}
+		catch (...) {
+			while (i != 0)
+				give(out[--i]);
+			throw;
+		}
+	}
+
+	template <class T, bool threads, int inst>
+	void object_pool<T, threads, inst>::deallocate_batch(T** p, size_t n) {
+		__lock guard;
+		for (size_t i = 0; i < n; ++i)
+			give(p[i]);
+	}
+
+	template <class T, bool threads, int inst>
+	size_t object_pool<T, threads, inst>::trim() {
+		__lock guard;
+		if (spare == nullptr)
+			return 0;
+		__malloc_alloc_template<inst>::deallocate(spare, __SLAB, __SLAB);
+		spare = nullptr;
+		--slabs;
+		return __SLAB;
+	}
+
+	template <class T, bool threads, int inst>
+	slab_occupancy object_pool<T, threads, inst>::occupancy() {
+		__lock guard;
+		slab_occupancy result;
+		result.slab_bytes = __SLAB;
+		result.objects_per_slab = __CAPACITY;
+		result.slabs = slabs;
+		result.full_slabs = full_slabs;
+		result.partial_slabs = partial_slabs;
+		result.empty_slabs = spare != nullptr ? 1 : 0;
+		result.live_objects = live_objects;
+		return result;
+	}
+
+	// Raw allocator tag: single objects requested through simpleAlloc go to
+	// object_pool<T>, arrays and untyped requests to the underlying pool.
+	template <bool threads, int inst>
+	class __slab_alloc_template : public __default_alloc_template<threads, inst> { };
+
+	template <class T, bool threads, int inst>
+	class simpleAlloc<T, __slab_alloc_template<threads, inst> > : public simpleAlloc<T, __default_alloc_template<threads, inst> > {
+	private:
+		using pool = object_pool<T, threads, inst>;
+		using base = simpleAlloc<T, __default_alloc_template<threads, inst> >;
+
+	public:
+		static T* allocate() { return pool::allocate(); }
+		static T* allocate(size_t n) { return n == 1 ? pool::allocate() : base::allocate(n); }
+		static void deallocate(T* ptr) { pool::deallocate(ptr); }
+		static void deallocate(T* ptr, size_t n) {
+			if (n == 1)
+				pool::deallocate(ptr);
+			else
+				base::deallocate(ptr, n);
+		}
+		static T* reallocate(T* ptr, size_t old_n, size_t new_n) {
+			if (ptr == nullptr || old_n == 0)
+				return allocate(new_n);
+			if (old_n != 1 && new_n != 1)
+				return base::reallocate(ptr, old_n, new_n);
+			T* result = allocate(new_n);
+			if (result != nullptr)
+				memcpy(result, ptr, sizeof(T) * (old_n < new_n ? old_n : new_n));
+			deallocate(ptr, old_n);
+			return result;
+		}
+		static void allocate_batch(size_t n, T** out) { pool::allocate_batch(n, out); }
+		static void deallocate_batch(T** ptrs, size_t n) { pool::deallocate_batch(ptrs, n); }
+	};
+
+	using slab_alloc = __slab_alloc_template<false, 0>;
+}
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "construct.h"
+#include "uninitialized.h"
+
+namespace STL {
+
+	enum { __PARALLEL_MIN_BYTES = 32 * 1024 * 1024, __PARALLEL_GRAIN = 4 * 1024 * 1024 };
+
+	// Process-wide pool of hardware_concurrency() - 1 workers, started on
+	// first use; defining __STL_PARALLEL_THREADS fixes the thread count,
+	// caller included, instead. run() hands out chunk indices to the workers
+	// and the calling thread alike and returns when every chunk has
+	// finished. Jobs must not throw. A job that itself calls run() executes
+	// serially.
+	//
+	// The pool is a function-local static, so it is destroyed at exit before
+	// any static object constructed ahead of its first use. Its destructor
+	// joins the workers and marks the pool gone; available() then reports
+	// false and the parallel algorithms below run on the calling thread, so
+	// such an object may still build or destroy a large vector on its way
+	// out. Calling run() from another thread while exit is under way is not
+	// supported.
+	class __worker_pool {
+
+	private:
+		using job_type = void (*)(void* context, size_t chunk);
+
+		std::mutex pool_mutex;
+		std::mutex run_mutex;
+		std::condition_variable work_ready;
+		std::condition_variable work_done;
+		std::vector<std::thread> workers;
+
+		job_type job;
+		void* context;
+		size_t chunks;
+		std::atomic<size_t> next;
+		size_t generation;
+		size_t active;
+		bool stop;
+
+		static bool& destroyed() {
+			static bool flag = false;
+			return flag;
+		}
+
+		static bool& inside_job() {
+			static thread_local bool flag = false;
+			return flag;
+		}
+
+		void drain(job_type f, void* ctx, size_t n) {
+			inside_job() = true;
+			for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < n; )
+				f(ctx, i);
+			inside_job() = false;
+		}
+
+		void work() {
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			size_t seen = generation;
+			for (;;) {
+				work_ready.wait(lock, [&] { return stop || generation != seen; });
+				if (stop)
+					return;
+				seen = generation;
+				job_type f = job;
+				void* ctx = context;
+				size_t n = chunks;
+				++active;
+				lock.unlock();
+				drain(f, ctx, n);
+				lock.lock();
+				if (--active == 0)
+					work_done.notify_all();
+			}
+		}
+
+		__worker_pool() : job(nullptr), context(nullptr), chunks(0), next(0), generation(0), active(0), stop(false) {
+#if defined(__STL_PARALLEL_THREADS)
+			unsigned n = __STL_PARALLEL_THREADS;
+#else
+			unsigned n = std::thread::hardware_concurrency();
+#endif
+			for (unsigned i = 1; i < n; ++i)
+				workers.emplace_back(&__worker_pool::work, this);
+		}
+
+	public:
+		~__worker_pool() {
+			{
+				std::lock_guard<std::mutex> lock(pool_mutex);
+				stop = true;
+			}
+			work_ready.notify_all();
+			for (size_t i = 0; i < workers.size(); ++i)
+				workers[i].join();
+			destroyed() = true;
+		}
+
+		static bool available() noexcept { return !destroyed(); }
+
+		static __worker_pool& instance() {
+			static __worker_pool pool;
+			return pool;
+		}
+
+		size_t size() const noexcept { return workers.size() + 1; }
+
+		void run(size_t n, job_type f, void* ctx) {
+			if (workers.empty() || n < 2 || inside_job()) {
+				for (size_t i = 0; i < n; ++i)
+					f(ctx, i);
+				return;
+			}
+			std::lock_guard<std::mutex> serialize(run_mutex);
+			{
+				// A worker that woke late for the previous job may still be
+				// looking at its fields.
+				std::unique_lock<std::mutex> lock(pool_mutex);
+				work_done.wait(lock, [&] { return active == 0; });
+				job = f;
+				context = ctx;
+				chunks = n;
+				next.store(0, std::memory_order_relaxed);
+				++generation;
+				++active;
+			}
+			work_ready.notify_all();
+			drain(f, ctx, n);
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			--active;
+			work_done.wait(lock, [&] { return active == 0; });
+		}
+	};
+
+	// Checked before any bookkeeping is built, so small ranges cost nothing
+	// over the serial algorithms.
+	inline bool __parallel_worthwhile(size_t n, size_t element_bytes) noexcept {
+		return n * element_bytes >= static_cast<size_t>(__PARALLEL_MIN_BYTES);
+	}
+
+	// Shared bookkeeping for the parallel algorithms: chunk i covers
+	// [begin(i), begin(i + 1)) and records whether it completed.
+	struct __parallel_chunks {
+		size_t count;
+		size_t total;
+		std::unique_ptr<bool[]> done;
+		std::exception_ptr error;
+		std::mutex error_mutex;
+
+		__parallel_chunks(size_t total, size_t element_bytes) : count(1), total(total) {
+			if (__parallel_worthwhile(total, element_bytes) && __worker_pool::available()) {
+				size_t workers = __worker_pool::instance().size();
+				size_t grain = static_cast<size_t>(__PARALLEL_GRAIN) / element_bytes + 1;
+				count = total / grain < workers ? total / grain : workers;
+				if (count == 0)
+					count = 1;
+			}
+			done.reset(new bool[count]());
+		}
+
+		// Contiguous, equal-sized pieces: on a first touch each worker then
+		// places one run of pages on its own node.
+		size_t begin(size_t i) const noexcept { return total / count * i + (i < total % count ? i : total % count); }
+		size_t end(size_t i) const noexcept { return begin(i + 1); }
+
+		void fail() {
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error)
+				error = std::current_exception();
+		}
+	};
+
+	template <class RandomAccessIterator, class T>
+	struct __parallel_fill_job {
+		__parallel_chunks* chunks;
+		RandomAccessIterator first;
+		const T* value;
+
+		static void run(void* p, size_t i) {
+			__parallel_fill_job* job = static_cast<__parallel_fill_job*>(p);
+			try {
+				STL::uninitialized_fill_n(job->first + job->chunks->begin(i), job->chunks->end(i) - job->chunks->begin(i), *job->value);
+				job->chunks->done[i] = true;
+			}
+			catch (...) {
+				job->chunks->fail();
+			}
+		}
+	};
+
+	template <class RandomAccessIterator1, class RandomAccessIterator2>
+	struct __parallel_copy_job {
+		__parallel_chunks* chunks;
+		RandomAccessIterator1 first;
+		RandomAccessIterator2 result;
+
+		static void run(void* p, size_t i) {
+			__parallel_copy_job* job = static_cast<__parallel_copy_job*>(p);
+			const size_t b = job->chunks->begin(i);
+			const size_t e = job->chunks->end(i);
+			try {
+				STL::uninitialized_copy(job->first + b, job->first + e, job->result + b);
+				job->chunks->done[i] = true;
+			}
+			catch (...) {
+				job->chunks->fail();
+			}
+		}
+	};
+
+	template <class RandomAccessIterator>
+	struct __parallel_destroy_job {
+		__parallel_chunks* chunks;
+		RandomAccessIterator first;
+
+		static void run(void* p, size_t i) {
+			__parallel_destroy_job* job = static_cast<__parallel_destroy_job*>(p);
+			STL::destroy(job->first + job->chunks->begin(i), job->first + job->chunks->end(i));
+		}
+	};
+
+	// A failed chunk has already destroyed its own elements; the finished
+	// ones are destroyed here before the first exception is rethrown.
+	template <class RandomAccessIterator>
+	void __parallel_unwind(__parallel_chunks& chunks, RandomAccessIterator first) {
+		for (size_t i = 0; i < chunks.count; ++i)
+			if (chunks.done[i])
+				STL::destroy(first + chunks.begin(i), first + chunks.end(i));
+		std::rethrow_exception(chunks.error);
+	}
+
+	// Same contract as uninitialized_fill_n; ranges under
+	// __PARALLEL_MIN_BYTES are filled by the calling thread.
+	template <class RandomAccessIterator, class Size, class T>
+	RandomAccessIterator parallel_uninitialized_fill_n(RandomAccessIterator first, Size n, const T& x) {
+		using value_type = value_type_t<RandomAccessIterator>;
+		if (n <= 0)
+			return first;
+		if (!__parallel_worthwhile(static_cast<size_t>(n), sizeof(value_type)))
+			return STL::uninitialized_fill_n(first, n, x);
+		__parallel_chunks chunks(static_cast<size_t>(n), sizeof(value_type));
+		if (chunks.count == 1)
+			return STL::uninitialized_fill_n(first, n, x);
+		__parallel_fill_job<RandomAccessIterator, T> job = { &chunks, first, &x };
+		__worker_pool::instance().run(chunks.count, &__parallel_fill_job<RandomAccessIterator, T>::run, &job);
+		if (chunks.error)
+			__parallel_unwind(chunks, first);
+		return first + n;
+	}
+
+	template <class RandomAccessIterator1, class RandomAccessIterator2>
+	RandomAccessIterator2 parallel_uninitialized_copy(RandomAccessIterator1 first, RandomAccessIterator1 last, RandomAccessIterator2 result) {
+		using value_type = value_type_t<RandomAccessIterator2>;
+		const size_t n = static_cast<size_t>(last - first);
+		if (!__parallel_worthwhile(n, sizeof(value_type)))
+			return STL::uninitialized_copy(first, last, result);
+		__parallel_chunks chunks(n, sizeof(value_type));
+		if (chunks.count == 1)
+			return STL::uninitialized_copy(first, last, result);
+		__parallel_copy_job<RandomAccessIterator1, RandomAccessIterator2> job = { &chunks, first, result };
+		__worker_pool::instance().run(chunks.count, &__parallel_copy_job<RandomAccessIterator1, RandomAccessIterator2>::run, &job);
+		if (chunks.error)
+			__parallel_unwind(chunks, result);
+		return result + n;
+	}
+
+	template <class RandomAccessIterator>
+	inline void __parallel_destroy_aux(RandomAccessIterator, RandomAccessIterator, __true_type) { }
+
+	template <class RandomAccessIterator>
+	void __parallel_destroy_aux(RandomAccessIterator first, RandomAccessIterator last, __false_type) {
+		using value_type = value_type_t<RandomAccessIterator>;
+		if (!__parallel_worthwhile(static_cast<size_t>(last - first), sizeof(value_type))) {
+			STL::destroy(first, last);
+			return;
+		}
+		__parallel_chunks chunks(static_cast<size_t>(last - first), sizeof(value_type));
+		if (chunks.count == 1) {
+			STL::destroy(first, last);
+			return;
+		}
+		__parallel_destroy_job<RandomAccessIterator> job = { &chunks, first };
+		__worker_pool::instance().run(chunks.count, &__parallel_destroy_job<RandomAccessIterator>::run, &job);
+	}
+
+	template <class RandomAccessIterator>
+	inline void parallel_destroy(RandomAccessIterator first, RandomAccessIterator last) {
+		using trivial_destructor = typename __type_traits<value_type_t<RandomAccessIterator> >::has_trivial_destructor_constructor;
+		__parallel_destroy_aux(first, last, trivial_destructor());
+	}
+}
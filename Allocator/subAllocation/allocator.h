@@ -5,53 +5,200 @@
 
 namespace STL {
 
-	template <class T, class Alloc = __default_alloc_template>
+	template <class Alloc>
+	struct __has_aligned_allocate {
+		template <class A>
+		static auto test(int) -> decltype(A::allocate(size_t(), size_t()), __true_type());
+		template <class A>
+		static __false_type test(...);
+
+		using type = decltype(test<Alloc>(0));
+	};
+
+	template <class Alloc>
+	struct __has_reallocate {
+		template <class A>
+		static auto test(int) -> decltype(A::reallocate(nullptr, size_t(), size_t()), __true_type());
+		template <class A>
+		static __false_type test(...);
+
+		using type = decltype(test<Alloc>(0));
+	};
+
+	template <class Alloc>
+	struct __has_allocate_batch {
+		template <class A>
+		static auto test(int) -> decltype(A::allocate_batch(size_t(), size_t(), static_cast<void**>(nullptr)), __true_type());
+		template <class A>
+		static __false_type test(...);
+
+		using type = decltype(test<Alloc>(0));
+	};
+
+	template <class Alloc>
+	inline void* __allocate_aligned(size_t n, size_t align, __true_type) {
+		return Alloc::allocate(n, align);
+	}
+
+	template <class Alloc>
+	inline void* __allocate_aligned(size_t n, size_t /* align */, __false_type) {
+		return Alloc::allocate(n);
+	}
+
+	template <class Alloc>
+	inline void __deallocate_aligned(void* p, size_t n, size_t align, __true_type) {
+		Alloc::deallocate(p, n, align);
+	}
+
+	template <class Alloc>
+	inline void __deallocate_aligned(void* p, size_t n, size_t /* align */, __false_type) {
+		Alloc::deallocate(p, n);
+	}
+
+	template <class Alloc, size_t Align>
+	class __aligned_alloc {
+	private:
+		static_assert((Align & (Align - 1)) == 0, "alignment must be a power of two");
+		using has_aligned = typename __has_aligned_allocate<Alloc>::type;
+
+		static size_t ALIGN(size_t align) { return align > Align ? align : Align; }
+
+	public:
+		static void* allocate(size_t n) { return __allocate_aligned<Alloc>(n, Align, has_aligned()); }
+		static void deallocate(void* p, size_t n) { __deallocate_aligned<Alloc>(p, n, Align, has_aligned()); }
+		static void* allocate(size_t n, size_t align) { return __allocate_aligned<Alloc>(n, ALIGN(align), has_aligned()); }
+		static void deallocate(void* p, size_t n, size_t align) { __deallocate_aligned<Alloc>(p, n, ALIGN(align), has_aligned()); }
+	};
+
+	enum { __CACHE_LINE = 64 };
+
+	using cache_aligned_alloc = __aligned_alloc<alloc, __CACHE_LINE>;
+
+	template <class T, class Alloc = alloc>
 	class simpleAlloc {
 	public:
 		using value_type = T;
 		using pointer = T *;
 		using const_pointer = const T*;
 		using reference = T &;
-		using const_refernce = const T &
+		using const_refernce = const T &;
 		using size_type = size_t;
 		using difference_type = ptrdiff_t;
+	private:
+		using has_aligned = typename __has_aligned_allocate<Alloc>::type;
+		using has_reallocate = typename __has_reallocate<Alloc>::type;
+
+		static T* reallocate(T* ptr, size_t old_n, size_t new_n, __true_type);
+		static T* reallocate(T* ptr, size_t old_n, size_t new_n, __false_type);
+
+		using has_batch = typename __has_allocate_batch<Alloc>::type;
+
+		static void allocate_batch(size_t n, T** out, __true_type);
+		static void allocate_batch(size_t n, T** out, __false_type);
+		static void deallocate_batch(T** ptrs, size_t n, __true_type);
+		static void deallocate_batch(T** ptrs, size_t n, __false_type);
 	public:
 		static T* allocate();
 		static T* allocate(size_t n);
 		static void deallocate(T* ptr);
 		static void deallocate(T* ptr, size_t n);
-		static void construct(T* ptr);
-		static void construct(T* ptr, const T& value);
+		// Bitwise move of [ptr, ptr + old_n) into storage for new_n elements.
+		// Only valid for trivially copyable T; may grow the block in place.
+		static T* reallocate(T* ptr, size_t old_n, size_t new_n);
+		// n single objects, each released with deallocate(ptr) or deallocate_batch.
+		static void allocate_batch(size_t n, T** out);
+		static void deallocate_batch(T** ptrs, size_t n);
+		template <class... Args>
+		static void construct(T* ptr, Args&&... args);
 		static void destroy(T* ptr);
 		static void destroy(T* first, T* last);
 	};
 
 	template <class T, class Alloc> T* simpleAlloc<T, Alloc>::allocate() {
-		return reinterpret_cast<T*>(Alloc::allocate(sizeof(T)));
+		return reinterpret_cast<T*>(__allocate_aligned<Alloc>(sizeof(T), alignof(T), has_aligned()));
 	}
 
 	template <class T, class Alloc> T* simpleAlloc<T, Alloc>::allocate(size_t n) {
 		if (n == 0)
 			return 0;
-		return reinterpret_cast<T*>(Alloc::allocate(sizeof(T) * n));
+		return reinterpret_cast<T*>(__allocate_aligned<Alloc>(sizeof(T) * n, alignof(T), has_aligned()));
 	}
 
 	template <class T, class Alloc> void simpleAlloc<T, Alloc>::deallocate(T* ptr) {
-		Alloc::deallocate(reinterpret_cast<void*>(ptr), sizeof(T));
+		__deallocate_aligned<Alloc>(reinterpret_cast<void*>(ptr), sizeof(T), alignof(T), has_aligned());
 	}
 
 	template <class T, class Alloc> void simpleAlloc<T, Alloc>::deallocate(T* ptr, size_t n) {
 		if (n == 0)
 			return;
-		Alloc::deallocate(reinterpret_cast<void*>(ptr), sizeof(T) * n);
+		__deallocate_aligned<Alloc>(reinterpret_cast<void*>(ptr), sizeof(T) * n, alignof(T), has_aligned());
+	}
+
+	template <class T, class Alloc> T* simpleAlloc<T, Alloc>::reallocate(T* ptr, size_t old_n, size_t new_n) {
+		if (ptr == nullptr || old_n == 0)
+			return allocate(new_n);
+		if (new_n == 0) {
+			deallocate(ptr, old_n);
+			return 0;
+		}
+		// Over-aligned blocks may live outside the pools; Alloc::reallocate cannot tell.
+		if (alignof(T) > alignof(void*))
+			return reallocate(ptr, old_n, new_n, __false_type());
+		return reallocate(ptr, old_n, new_n, has_reallocate());
+	}
+
+	template <class T, class Alloc> T* simpleAlloc<T, Alloc>::reallocate(T* ptr, size_t old_n, size_t new_n, __true_type) {
+		return reinterpret_cast<T*>(Alloc::reallocate(reinterpret_cast<void*>(ptr), sizeof(T) * old_n, sizeof(T) * new_n));
+	}
+
+	template <class T, class Alloc> T* simpleAlloc<T, Alloc>::reallocate(T* ptr, size_t old_n, size_t new_n, __false_type) {
+		T* result = allocate(new_n);
+		memcpy(result, ptr, sizeof(T) * (old_n < new_n ? old_n : new_n));
+		deallocate(ptr, old_n);
+		return result;
+	}
+
+	template <class T, class Alloc> void simpleAlloc<T, Alloc>::allocate_batch(size_t n, T** out) {
+		if (alignof(T) > alignof(void*))
+			allocate_batch(n, out, __false_type());
+		else
+			allocate_batch(n, out, has_batch());
+	}
+
+	template <class T, class Alloc> void simpleAlloc<T, Alloc>::allocate_batch(size_t n, T** out, __true_type) {
+		Alloc::allocate_batch(sizeof(T), n, reinterpret_cast<void**>(out));
+	}
+
+	template <class T, class Alloc> void simpleAlloc<T, Alloc>::allocate_batch(size_t n, T** out, __false_type) {
+		size_t i = 0;
+		try {
+			for (; i < n; ++i)
+				out[i] = allocate();
+		}
+		catch (...) {
+			deallocate_batch(out, i, __false_type());
+			throw;
+		}
+	}
+
+	template <class T, class Alloc> void simpleAlloc<T, Alloc>::deallocate_batch(T** ptrs, size_t n) {
+		if (alignof(T) > alignof(void*))
+			deallocate_batch(ptrs, n, __false_type());
+		else
+			deallocate_batch(ptrs, n, has_batch());
+	}
+
+	template <class T, class Alloc> void simpleAlloc<T, Alloc>::deallocate_batch(T** ptrs, size_t n, __true_type) {
+		Alloc::deallocate_batch(sizeof(T), n, reinterpret_cast<void**>(ptrs));
 	}
 
-	template <class T, class Alloc> void simpleAlloc<T, Alloc>::construct(T* ptr) {
-		new (ptr) T();
+	template <class T, class Alloc> void simpleAlloc<T, Alloc>::deallocate_batch(T** ptrs, size_t n, __false_type) {
+		for (size_t i = 0; i < n; ++i)
+			deallocate(ptrs[i]);
 	}
 
-	template <class T, class Alloc> void simpleAlloc<T, Alloc>::construct(T* ptr, const T& value) {
-		new (ptr) T(value);
+	template <class T, class Alloc> template <class... Args> void simpleAlloc<T, Alloc>::construct(T* ptr, Args&&... args) {
+		new (ptr) T(std::forward<Args>(args)...);
 	}
 
 	template <class T, class Alloc> void simpleAlloc<T, Alloc>::destroy(T* ptr) {
@@ -62,4 +209,31 @@ namespace STL {
 		for (; first != last; ++first)
 			first->~T();
 	}
+
+	// Hands out raw nodes for a bulk insert, fetching them from Alloc in
+	// batches that double up to N; unused nodes go back when it dies.
+	template <class T, class Alloc, size_t N = 64>
+	class __node_batch {
+	private:
+		T* nodes[N];
+		size_t next;
+		size_t count;
+		size_t batch;
+
+	public:
+		__node_batch() : next(0), count(0), batch(4) { }
+		~__node_batch() { simpleAlloc<T, Alloc>::deallocate_batch(nodes + next, count - next); }
+		__node_batch(const __node_batch&) = delete;
+		__node_batch& operator=(const __node_batch&) = delete;
+
+		T* get() {
+			if (next == count) {
+				simpleAlloc<T, Alloc>::allocate_batch(batch, nodes);
+				next = 0;
+				count = batch;
+				batch = batch * 2 < N ? batch * 2 : N;
+			}
+			return nodes[next++];
+		}
+	};
 }
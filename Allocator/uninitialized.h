@@ -4,7 +4,7 @@
 #include "construct.h"
 #include "typeTraits.h"
 #include "stl_iterator.h"
-//#include "stl_algobase.h"
+#include "stl_algobase.h"
 
 namespace STL {
 
@@ -22,14 +22,54 @@ namespace STL {
 	template <class ForwardIterator, class Size, class T>
 	inline ForwardIterator __uninitialized_fill_n_aux(ForwardIterator first, Size n, const T& x, __false_type) {
 		ForwardIterator cur = first;
-		for (; n > 0; --n, ++cur)
-			construct(&*cur, x);
+		try {
+			for (; n > 0; --n, ++cur)
+				construct(&*cur, x);
+		}
+		catch (...) {
+			destroy(first, cur);
+			throw;
+		}
+		return cur;
+	}
+
+	// Tag for constructors that default-initialize instead of value-initializing.
+	struct default_init_t { };
+	constexpr default_init_t default_init = default_init_t();
+
+	// Like `new T[n]': objects with a trivial default constructor are left
+	// indeterminate and cost nothing, anything else is default-constructed.
+	template <class ForwardIterator, class Size>
+	inline ForwardIterator uninitialized_default_init_n(ForwardIterator first, Size n) {
+		using trivial = typename __type_traits<value_type_t<ForwardIterator> >::has_trivial_default_constructor;
+		return __uninitialized_default_init_n_aux(first, n, trivial());
+	}
+
+	template <class ForwardIterator, class Size>
+	inline ForwardIterator __uninitialized_default_init_n_aux(ForwardIterator first, Size n, __true_type) {
+		for (; n > 0; --n)
+			++first;
+		return first;
+	}
+
+	template <class ForwardIterator, class Size>
+	inline ForwardIterator __uninitialized_default_init_n_aux(ForwardIterator first, Size n, __false_type) {
+		using value_type = value_type_t<ForwardIterator>;
+		ForwardIterator cur = first;
+		try {
+			for (; n > 0; --n, ++cur)
+				::new (static_cast<void*>(&*cur)) value_type;
+		}
+		catch (...) {
+			destroy(first, cur);
+			throw;
+		}
 		return cur;
 	}
 
 	template <class InputIterator, class ForwardIterator>
 	inline ForwardIterator uninitialized_copy(InputIterator first, InputIterator last, ForwardIterator result) {
-		using isPODtype = typename __type_traits<value_type_t<InputIterator> >::is_POD_type;
+		using isPODtype = typename __type_traits<value_type_t<ForwardIterator> >::is_POD_type;
 		return __uninitialized_copy_aux(first, last, result, isPODtype());
 	}
 
@@ -41,8 +81,14 @@ namespace STL {
 	template <class InputIterator, class ForwardIterator>
 	inline ForwardIterator __uninitialized_copy_aux(InputIterator first, InputIterator last, ForwardIterator result, __false_type) {
 		ForwardIterator cur = result;
-		for (; first != last; ++first, ++cur)
-			construct(&*cur, *first);
+		try {
+			for (; first != last; ++first, ++cur)
+				construct(&*cur, *first);
+		}
+		catch (...) {
+			destroy(result, cur);
+			throw;
+		}
 		return cur;
 	}
 
@@ -56,6 +102,48 @@ namespace STL {
 		return result + (last - first);
 	}
 
+	// Moves when that cannot throw (or when T cannot be copied), copies
+	// otherwise, so a throwing constructor leaves [first, last) unchanged.
+	template <class T>
+	inline T* __uninitialized_move_if_noexcept(T* first, T* last, T* result) {
+		T* cur = result;
+		try {
+			for (; first != last; ++first, ++cur)
+				construct(cur, std::move_if_noexcept(*first));
+		}
+		catch (...) {
+			destroy(result, cur);
+			throw;
+		}
+		return cur;
+	}
+
+	// Moves [first, last) into raw storage at result and ends the lifetime of
+	// the originals. Relocatable types take a single memmove, so the ranges may
+	// overlap; anything else is moved or copied and then destroyed, and if a
+	// copy throws the originals are left untouched.
+	template <class T>
+	inline T* uninitialized_relocate(T* first, T* last, T* result) {
+		using relocatable = typename __is_trivially_relocatable<T>::type;
+		return __uninitialized_relocate_aux(first, last, result, relocatable());
+	}
+
+	template <class T>
+	inline T* __uninitialized_relocate_aux(T* first, T* last, T* result, __true_type) {
+		const ptrdiff_t n = last - first;
+		// An empty vector has no block yet; memmove must not see its null start.
+		if (n > 0 && first != nullptr)
+			memmove(static_cast<void*>(result), static_cast<const void*>(first), sizeof(T) * n);
+		return result + n;
+	}
+
+	template <class T>
+	inline T* __uninitialized_relocate_aux(T* first, T* last, T* result, __false_type) {
+		T* cur = __uninitialized_move_if_noexcept(first, last, result);
+		destroy(first, last);
+		return cur;
+	}
+
 	template <class ForwardIterator, class T>
 	inline void uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& x) {
 		using isPODtype = typename __type_traits<value_type_t<ForwardIterator> >::is_POD_type;
@@ -63,14 +151,20 @@ namespace STL {
 	}
 
 	template <class ForwardIterator, class T>
-	inline void __uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& x, __true_type) {
+	inline void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T& x, __true_type) {
 		STL::fill(first, last, x);
 	}
 
 	template <class ForwardIterator, class T>
-	inline void __uninitialized_fill(ForwardIterator first, ForwardIterator last, const T& x, __false_type) {
-		ForwardIterator cur;
-		for (; cur != last; ++cur)
-			construct(&*cur, x);
+	inline void __uninitialized_fill_aux(ForwardIterator first, ForwardIterator last, const T& x, __false_type) {
+		ForwardIterator cur = first;
+		try {
+			for (; cur != last; ++cur)
+				construct(&*cur, x);
+		}
+		catch (...) {
+			destroy(first, cur);
+			throw;
+		}
 	}
 }
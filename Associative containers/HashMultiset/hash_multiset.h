@@ -1,127 +1,115 @@
 #pragma once
 
-#include "rb_tree.h"
-#include "stl_function.h"
+#include "hash_func.h"
+#include "hashtable.h"
 
 namespace STL {
 
-	template <class Key, class T, class Compare = less<key>, class Alloc = alloc>
-	class map {
-		using key_type = Key;
-		using data_type = T;
-		using mapped_type = T;
-		using value_type = pair<const Key, T>;
-		using key_compare = Compare;
-
-		class value_compare : public binary_function<value_type, value_type, bool> {
-			friend class map<Key, T, Compare, Alloc>;
-		protected:
-			Compare comp;
-			value_compare(Compare c) : comp(c) { }
-		public:
-			bool operator()(const value_type& x, const value_type& y) const {
-				return comp(x.first, y.first);
-			}
-		};
-
+	template <class Value, class HashFcn = hash<Value>, class EqualKey = equal_to<Value>, class Alloc = alloc>
+	class hash_multiset {
 	private:
-		using rep_type = rb_tree<key_type, value_type, select1st<value_type>, key_compare, Alloc>;
-		rep_type t;
+		using ht = hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc>;
+		ht rep;
 
 	public:
-		using pointer = typename rep_type::pointer;
-		using const_pointer = typename rep_type::const_pointer;
-		using reference = typename rep_type::reference;
-		using const_reference = typename rep_type::const_reference;
-		using iterator = typename rep_type::iterator;
-		using const_iterator = typename rep_type::const_iterator;
-		using reverse_iterator = typename rep_type::reverse_iterator;
-		using const_reverse_iterator = typename rep_type::const_reverse_iterator;
-		using size_type = typename rep_type::size_type;
-		using difference_type = typename rep_type::difference_type;
-
-		map() : t(Compare()) { }
-		explicit map(const Compare& comp) : t(comp) { }
+		using key_type = typename ht::key_type;
+		using value_type = typename ht::value_type;
+		using hasher = typename ht::hasher;
+		using key_equal = typename ht::key_equal;
 
-		template <class InputIterator>
-		map(InputIterator first, InputIterator last) : t(Compare()) {
-			t.insert_unique(first, last);
-		}
+		using size_type = typename ht::size_type;
+		using difference_type = typename ht::difference_type;
+		using pointer = typename ht::const_pointer;
+		using const_pointer = typename ht::const_pointer;
+		using iterator = typename ht::const_iterator;
+		using const_iterator = typename ht::const_iterator;
+
+		hasher hash_funct() const noexcept { return rep.hash_funct(); }
+		key_equal key_eq() const noexcept { return rep.key_eq(); }
+
+	public:
+		hash_multiset() : rep(100, hasher(), key_equal()) { }
+		explicit hash_multiset(size_type n) : rep(n, hasher(), key_equal()) { }
+		hash_multiset(size_type n, const hasher& hf) : rep(n, hf, key_equal()) { }
+		hash_multiset(size_type n, const hasher& hf, const key_equal& eql) : rep(n, hf, eql) { }
 
 		template <class InputIterator>
-		map(InputIterator first, InputIterator last, const Compare& comp) : t(comp) {
-			t.insert_unique(first, last);
+		hash_multiset(InputIterator f, InputIterator l)
+			: rep(100, hasher(), key_equal()) {
+			rep.insert_equal(f, l);
 		}
-
-		map(const map<Key, T, Compare, Alloc>& x) : t(x.t) { }
-		map(const map<Key, T, Compare, Alloc>& operator=(const map(const map<Key, T, Compare, Alloc>& x) {
-			t = x.t;
-			return *this;
+		template <class InputIterator>
+		hash_multiset(InputIterator f, InputIterator l, size_type n)
+			: rep(n, hasher(), key_equal()) {
+			rep.insert_equal(f, l);
 		}
-
-		key_compare key_comp() const noexcept { return t.key_comp(); }
-		value_compare value_comp() const noexcept {
-			return value_compare(t.key_comp());
+		template <class InputIterator>
+		hash_multiset(InputIterator f, InputIterator l, size_type n, const hasher& hf)
+			: rep(n, hf, key_equal()) {
+			rep.insert_equal(f, l);
 		}
-		iterator begin() noexcept { return t.begin(); }
-		iterator end() noexcept { return t.end(); }
-		const_iterator begin() const noexcept { return t.cbegin(); }
-		const_iterator end() const noexcept { return t.cend(); }
-		const_reverse_iterator crbegin() const noexcept { return t.rbegin(); }
-		const_reverse_iterator crend() const noexcept { return t.rend(); }
-		bool empty() const noexcept { return t.empty(); }
-		size_type size() const noexcept { return t.size(); }
-		size_type max_size() const noexcept { return t.max_size(); }
-		T& operator[](const key_type& k) {
-			return (*(insert(value_type(k, T()))).first()).second;
+		template <class InputIterator>
+		hash_multiset(InputIterator f, InputIterator l, size_type n, const hasher& hf, const key_equal& eql)
+			: rep(n, hf, eql) {
+			rep.insert_equal(f, l);
 		}
-		void swap(map<Key, T, Compare, Alloc>& x) noexcept { t.swap(x.t); }
 
-		pair<iterator, bool> insert(const value_type& x) {
-			return t.insert_unique(x);
+	public:
+		size_type size() const noexcept { return rep.size(); }
+		size_type max_size() const noexcept { return rep.max_size(); }
+		bool empty() const noexcept { return rep.empty(); }
+		void swap(hash_multiset& ht) noexcept { rep.swap(ht.rep); }
+		template <class V, class HF, class EqK, class A>
+		friend bool operator==(const hash_multiset<V, HF, EqK, A>&, const hash_multiset<V, HF, EqK, A>&);
+		
+		iterator begin() const noexcept { return rep.begin(); }
+		iterator end() const noexcept { return rep.end(); }
+
+	public:
+		iterator insert(const value_type& obj) {
+			return rep.insert_equal(obj);
 		}
-		iterator insert(iterator position, const value_type& x) {
-			return t.insert_unique(position, x);
+		iterator insert(value_type&& obj) {
+			return rep.insert_equal(std::move(obj));
 		}
-		template <class InputIterator>
-		void insert(InputIterator first, InputIterator last) {
-			t.insert_unique(first, last);
+		template <class... Args>
+		iterator emplace(Args&&... args) {
+			return rep.emplace_equal(std::forward<Args>(args)...);
 		}
-
-		void erase(iterator position) { t.erase(position); }
-		size_type erase(const key_type& x) { return t.erase(x); }
-		void erase(iterator first, iterator last) { t.erase(first, last); }
-		void clear() { t.clear(); }
-
-		iterator find(const key_type& x) noexcept { return t.find(x); }
-		const_iterator find(const key_type& x) const noexcept { return t.find(x); }
-		size_type count(const key_type& x) const noexcept { return t.count(x); }
-		iterator lower_bound(const key_type& x) noexcept { return t.lower_bound(x); }
-		const_iterator lower_bound(const key_type& x) const noexcept {
-			return t.lower_bound(x);
+		template <class InputIterator>
+		void insert(InputIterator f, InputIterator l) {
+			rep.insert_equal(f, l);
 		}
-		iterator upper_bound(const key_type& x) noexcept { return t.upper_bound(x); }
-		const_iterator upper_bound(const key_type& x) const noexcept {
-			return t.upper_bound(x);
+		iterator insert_noresize(const value_type& obj) {
+			return rep.insert_equal_noresize(obj);
 		}
 
-		pair<iterator, iterator> equal_range(const key_type& x) noexcept {
-			return t.equal_range(x);
+		iterator find(const key_type& key) const { return rep.find(key); }
+
+		size_type count(const key_type& key) const { return rep.count(key); }
+
+		std::pair<iterator, iterator> equal_range(const key_type& key) const {
+			return rep.equal_range(key);
 		}
-		pair<const_iterator, const_iterator> equal_range(const key_type& x) const noexcept {
-			return t.equal_range(x);
+
+		size_type erase(const key_type& key) { return rep.erase(key); }
+		void erase(iterator it) { rep.erase(it); }
+		void erase(iterator first, iterator last) { rep.erase(first, last); }
+
+		void clear() { rep.clear(); }
+
+	public:
+		void resize(size_type n) { rep.resize(n); }
+		size_type bucket_count() const noexcept { return rep.bucket_count(); }
+		size_type max_bucket_count() const noexcept { return rep.max_bucket_count(); }
+		size_type elems_in_bucket(size_type n) const noexcept {
+			return rep.elems_in_bucket(n);
 		}
-		friend bool operator==(const map&, const map&);
-		friend bool operator<(const map&, const map&);
 	};
 
-	template <class Key, class Tp, class Compare, class Alloc>
-	inline bool operator==(const map<Key, Tp, Compare, Alloc>& x, const map<Key, Tp, Compare, Alloc>& y) {
-		return x.t == y.t;
-	}
-
-	template <class Key, class Tp, class Compare, class Alloc>
-	inline bool operator<(const map<Key, Tp, Compare, Alloc>& x, const map<Key, Tp, Compare, Alloc>& y) {
-		return x.t < y.t;
+	template <class Value, class HashFcn, class EqualKey, class Alloc>
+	inline bool operator==(const hash_multiset<Value, HashFcn, EqualKey, Alloc>& lhs,
+		const hash_multiset<Value, HashFcn, EqualKey, Alloc>& rhs) {
+		return lhs.rep == rhs.rep;
 	}
 }
@@ -5,10 +5,10 @@
 
 namespace STL {
 
-	template <class Key, class T, class HashFcn = hash<Key>, class EqualKey = equal_to<Key>, class Alloc = simpleAlloc<Key> >
+	template <class Key, class T, class HashFcn = hash<Key>, class EqualKey = equal_to<Key>, class Alloc = alloc>
 	class hash_map {
 	private:
-		using ht = hashtable<pair<const Key, T>, Key, HashFcn, select1st<pair<const Key, T> >, EqualKey, Alloc>;
+		using ht = hashtable<std::pair<const Key, T>, Key, HashFcn, select1st<std::pair<const Key, T> >, EqualKey, Alloc>;
 		ht rep;
 
 	public:
@@ -20,7 +20,7 @@ namespace STL {
 		using key_equal = typename ht::key_equal;
 
 		using size_type = typename ht::size_type;
-		using differece_type = typename ht::differece_type;
+		using difference_type = typename ht::difference_type;
 		using pointer = typename ht::pointer;
 		using const_pointer = typename ht::const_pointer;
 		using reference = typename ht::reference;
@@ -55,7 +55,7 @@ namespace STL {
 		}
 		template <class InputIterator>
 		hash_map(InputIterator f, InputIterator l, size_type n, const hasher& hf, const key_equal& eql)
-			: rep(n, hf, eql()) {
+			: rep(n, hf, eql) {
 			rep.insert_unique(f, l);
 		}
 
@@ -64,38 +64,46 @@ namespace STL {
 		size_type max_size() const noexcept { return rep.max_size(); }
 		bool empty() const noexcept { return rep.empty(); }
 		void swap(hash_map& ht) noexcept { rep.swap(ht.rep); }
-		friend bool operator==(const hash_map&, const hash_map&);
+		template <class K, class Tp, class HF, class EqK, class A>
+		friend bool operator==(const hash_map<K, Tp, HF, EqK, A>&, const hash_map<K, Tp, HF, EqK, A>&);
 
-		iterator begin() const noexcept { return rep.begin(); }
-		iterator end() const noexcept { return rep.end(); }
+		iterator begin() noexcept { return rep.begin(); }
+		iterator end() noexcept { return rep.end(); }
 		const_iterator begin() const noexcept { return rep.begin(); }
 		const_iterator end() const noexcept { return rep.end(); }
 
 	public:
-		pair<iterator, bool> insert(const value_type& obj) {
+		std::pair<iterator, bool> insert(const value_type& obj) {
 			return rep.insert_unique(obj);
 		}
+		std::pair<iterator, bool> insert(value_type&& obj) {
+			return rep.insert_unique(std::move(obj));
+		}
+		template <class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args) {
+			return rep.emplace_unique(std::forward<Args>(args)...);
+		}
 		template <class InputIterator>
 		void insert(InputIterator f, InputIterator l) {
 			rep.insert_unique(f, l);
 		}
-		pair<iterator, bool> insert_noresize(const value_type& obj) {
+		std::pair<iterator, bool> insert_noresize(const value_type& obj) {
 			return rep.insert_unique_noresize(obj);
 		}
 
-		iterator find(const key_type& key) const { return rep.find(key); }
+		iterator find(const key_type& key) { return rep.find(key); }
 		const_iterator find(const key_type& key) const { return rep.find(key); }
 
-		/*T& operator[](const key_type& key) {
+		T& operator[](const key_type& key) {
 			return rep.find_or_insert(value_type(key, T())).second;
-		}*/
+		}
 
 		size_type count(const key_type& key) const { return rep.count(key); }
 
-		pair<iterator, iterator> equal_range(const key_type& key) const {
+		std::pair<iterator, iterator> equal_range(const key_type& key) {
 			return rep.equal_range(key);
 		}
-		pair<const_iterator, iterator> equal_range(const key_type& key) const {
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
 			return rep.equal_range(key);
 		}
 
@@ -108,9 +116,9 @@ namespace STL {
 		void resize(size_type n) { rep.resize(n); }
 		size_type bucket_count() const noexcept { return rep.bucket_count(); }
 		size_type max_bucket_count() const noexcept { return rep.max_bucket_count(); }
-		/*size_type elems_in_bucket(size_type n) const noexcept {
+		size_type elems_in_bucket(size_type n) const noexcept {
 			return rep.elems_in_bucket(n);
-		}*/
+		}
 	};
 
 	template <class Key, class T, class HashFcn, class EqualKey, class Alloc>
@@ -5,7 +5,7 @@
 
 namespace STL {
 
-	template <class Value, class HashFcn = hash<Value>, class EqualKey = equal_to<Value>, class Alloc = simpleAlloc<Value> >
+	template <class Value, class HashFcn = hash<Value>, class EqualKey = equal_to<Value>, class Alloc = alloc>
 	class hash_set {
 	private:
 		using ht = hashtable<Value, Value, HashFcn, identity<Value>, EqualKey, Alloc>;
@@ -18,7 +18,7 @@ namespace STL {
 		using key_equal = typename ht::key_equal;
 
 		using size_type = typename ht::size_type;
-		using differece_type = typename ht::differece_type;
+		using difference_type = typename ht::difference_type;
 		using pointer = typename ht::const_pointer;
 		using const_pointer = typename ht::const_pointer;
 		using iterator = typename ht::const_iterator;
@@ -50,7 +50,7 @@ namespace STL {
 		}
 		template <class InputIterator>
 		hash_set(InputIterator f, InputIterator l, size_type n, const hasher& hf, const key_equal& eql)
-			: rep(n, hf, eql()) {
+			: rep(n, hf, eql) {
 			rep.insert_unique(f, l);
 		}
 
@@ -59,30 +59,40 @@ namespace STL {
 		size_type max_size() const noexcept { return rep.max_size(); }
 		bool empty() const noexcept { return rep.empty(); }
 		void swap(hash_set& ht) noexcept { rep.swap(ht.rep); }
-		friend bool operator==(const hash_set&, const hash_set&);
+		template <class V, class HF, class EqK, class A>
+		friend bool operator==(const hash_set<V, HF, EqK, A>&, const hash_set<V, HF, EqK, A>&);
 		
 		iterator begin() const noexcept { return rep.begin(); }
 		iterator end() const noexcept { return rep.end(); }
 
 	public:
-		pair<iterator, bool> insert(const value_type& obj) {
-			pair<typename ht::iterator, bool> p = rep.insert_unique(obj);
-			return pair<iterator, bool>(p.first, p.second);
+		std::pair<iterator, bool> insert(const value_type& obj) {
+			std::pair<typename ht::iterator, bool> p = rep.insert_unique(obj);
+			return std::pair<iterator, bool>(p.first, p.second);
+		}
+		std::pair<iterator, bool> insert(value_type&& obj) {
+			std::pair<typename ht::iterator, bool> p = rep.insert_unique(std::move(obj));
+			return std::pair<iterator, bool>(p.first, p.second);
+		}
+		template <class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args) {
+			std::pair<typename ht::iterator, bool> p = rep.emplace_unique(std::forward<Args>(args)...);
+			return std::pair<iterator, bool>(p.first, p.second);
 		}
 		template <class InputIterator>
 		void insert(InputIterator f, InputIterator l) {
 			rep.insert_unique(f, l);
 		}
-		pair<iterator, bool> insert_noresize(const value_type& obj) {
-			pair<typename ht::iterator, bool> p = rep.insert_unique_noresize(obj);
-			return pair<iterator, bool>(p.first, p.second);
+		std::pair<iterator, bool> insert_noresize(const value_type& obj) {
+			std::pair<typename ht::iterator, bool> p = rep.insert_unique_noresize(obj);
+			return std::pair<iterator, bool>(p.first, p.second);
 		}
 
 		iterator find(const key_type& key) const { return rep.find(key); }
 
 		size_type count(const key_type& key) const { return rep.count(key); }
 
-		pair<iterator, iterator> equal_range(const key_type& key) const {
+		std::pair<iterator, iterator> equal_range(const key_type& key) const {
 			return rep.equal_range(key);
 		}
 
@@ -96,9 +106,9 @@ namespace STL {
 		void resize(size_type n) { rep.resize(n); }
 		size_type bucket_count() const noexcept { return rep.bucket_count(); }
 		size_type max_bucket_count() const noexcept { return rep.max_bucket_count(); }
-		/*size_type elems_in_bucket(size_type n) const noexcept {
+		size_type elems_in_bucket(size_type n) const noexcept {
 			return rep.elems_in_bucket(n);
-		}*/
+		}
 	};
 
 	template <class Value, class HashFcn, class EqualKey, class Alloc>
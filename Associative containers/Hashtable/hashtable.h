@@ -1,7 +1,10 @@
 #pragma once
 
 #include <cstddef>
-#include "stl_algo.h"
+#include <utility>
+#include "allocator.h"
+#include "stl_algobase.h"
+#include "stl_function.h"
 #include "stl_vector.h"
 
 namespace STL {
@@ -12,9 +15,18 @@ namespace STL {
 		Value val;
 	};
 
+	template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
+	class hashtable;
+
+	template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
+	struct __hashtable_iterator;
+
+	template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
+	struct __hashtable_const_iterator;
+
 	template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
 	struct __hashtable_iterator {
-		using hashtable = hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+		using hashtable = STL::hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 		using iterator = __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 		using const_iterator = __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 		using node = __hashtable_node<Value>;
@@ -46,8 +58,8 @@ namespace STL {
 		cur = cur->next;
 		if (!cur) {
 			size_type bucket = ht->bkt_num(old->val);
-			while (!cur && ++bucket < ht->bucket.size())
-				cur = ht->buckets(bucket);
+			while (!cur && ++bucket < ht->buckets.size())
+				cur = ht->buckets[bucket];
 		}
 		return *this;
 	}
@@ -62,7 +74,7 @@ namespace STL {
 
 	template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
 	struct __hashtable_const_iterator {
-		using hashtable = hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+		using hashtable = STL::hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 		using iterator = __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 		using const_iterator = __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
 		using node = __hashtable_node<Value>;
@@ -71,13 +83,13 @@ namespace STL {
 		using value_type = Value;
 		using difference_type = ptrdiff_t;
 		using size_type = size_t;
-		using reference = Value &;
-		using pointer = Value *;
+		using reference = const Value &;
+		using pointer = const Value *;
 
-		node* cur;
-		hashtable* ht;
+		const node* cur;
+		const hashtable* ht;
 
-		__hashtable_const_iterator(const node* n,  const hashtable* tab) : cur(n), ht(tab) { }
+		__hashtable_const_iterator(const node* n, const hashtable* tab) : cur(n), ht(tab) { }
 		__hashtable_const_iterator() { };
 		__hashtable_const_iterator(const iterator& it) : cur(it.cur), ht(it.ht) { }
 		reference operator*() const noexcept { return cur->val; }
@@ -95,8 +107,8 @@ namespace STL {
 		cur = cur->next;
 		if (!cur) {
 			size_type bucket = ht->bkt_num(old->val);
-			while (!cur && ++bucket < ht->bucket.size())
-				cur = ht->buckets(bucket);
+			while (!cur && ++bucket < ht->buckets.size())
+				cur = ht->buckets[bucket];
 		}
 		return *this;
 	}
@@ -104,7 +116,7 @@ namespace STL {
 	template <class V, class K, class HF, class ExK, class EqK, class A>
 	__hashtable_const_iterator<V, K, HF, ExK, EqK, A>
 		__hashtable_const_iterator<V, K, HF, ExK, EqK, A>::operator++(int) noexcept {
-		iterator tmp = *this;
+		const_iterator tmp = *this;
 		++* this;
 		return tmp;
 	}
@@ -119,19 +131,35 @@ namespace STL {
 		1610612741ul, 3221225473ul, 4294967291ul
 	};
 
+	// The first listed prime not less than n, or the largest one.
 	inline unsigned long __stl_next_prime(unsigned long n) noexcept {
 		const unsigned long* first = __stl_prime_list;
 		const unsigned long* last = __stl_prime_list + __stl_num_primes;
-		const unsigned long* pos = lower_bound(first, last, n);
-		return pos == last ? *(last - 1) : *pos;
+		while (first != last - 1 && *first < n)
+			++first;
+		return *first;
 	}
 
 	template <class Value, class Key, class HashFcn, class ExtractKey, class EqualKey, class Alloc>
 	class hashtable {
 	public:
+		using key_type = Key;
+		using value_type = Value;
 		using hasher = HashFcn;
 		using key_equal = EqualKey;
+
 		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+		using pointer = value_type *;
+		using const_pointer = const value_type *;
+		using reference = value_type &;
+		using const_reference = const value_type &;
+
+		using iterator = __hashtable_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+		using const_iterator = __hashtable_const_iterator<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>;
+
+		friend iterator;
+		friend const_iterator;
 
 	private:
 		hasher hash;
@@ -145,26 +173,29 @@ namespace STL {
 		size_type num_elements;
 
 	private:
-		node* new_node(const value_type& obj) {
-			node* n = node_allocator::allocate();
+		template <class... Args>
+		node* new_node(Args&&... args) { return construct_node(node_allocator::allocate(), std::forward<Args>(args)...); }
+		template <class... Args>
+		node* construct_node(node* n, Args&&... args) {
 			n->next = nullptr;
 			try {
-				construct(&n->val, obj);
+				construct(&n->val, std::forward<Args>(args)...);
 				return n;
 			}
-			catch (std::exception&) {
+			catch (...) {
 				node_allocator::deallocate(n);
+				throw;
 			}
 		}
 
 		void delete_node(node* n) {
-			destroy(&n->val);
+			STL::destroy(&n->val);
 			node_allocator::deallocate(n);
 		}
 
 	private:
 		void initialize_buckets(size_type n) {
-			const size_type n_buckets = next_size();
+			const size_type n_buckets = next_size(n);
 			buckets.reserve(n_buckets);
 			buckets.insert(buckets.end(), n_buckets, static_cast<node*>(nullptr));
 			num_elements = 0;
@@ -187,21 +218,21 @@ namespace STL {
 		void erase_bucket(const size_type n, node* first, node* last);
 		void erase_bucket(const size_type n, node* last);
 
-	private:
-		pair<iterator, bool> insert_unique_noresize(const value_type& obj) {
+	public:
+		std::pair<iterator, bool> insert_unique_noresize(const value_type& obj) {
 			const size_type n = bkt_num(obj);
 			node* first = buckets[n];
 
 			for (node* cur = first; cur; cur = cur->next) {
 				if (equals(get_key(cur->val), get_key(obj)))
-					return pair<iterator, bool>(iterator(cur, this), false);
+					return std::pair<iterator, bool>(iterator(cur, this), false);
 			}
 
 			node* tmp = new_node(obj);
 			tmp->next = first;
 			buckets[n] = tmp;
 			++num_elements;
-			return pair<iterator, bool>(iterator(tmp, this), true);
+			return std::pair<iterator, bool>(iterator(tmp, this), true);
 		}
 		iterator insert_equal_noresize(const value_type& obj) {
 			const size_type n = bkt_num(obj);
@@ -222,6 +253,27 @@ namespace STL {
 			return iterator(tmp, this);
 		}
 
+	private:
+		node* bucket_find(size_type n, const key_type& key) const noexcept {
+			node* cur = buckets[n];
+			while (cur && !equals(get_key(cur->val), key))
+				cur = cur->next;
+			return cur;
+		}
+		// Equal keys stay adjacent: tmp goes right after prev, or heads bucket n.
+		iterator link_node(size_type n, node* prev, node* tmp) noexcept {
+			if (prev) {
+				tmp->next = prev->next;
+				prev->next = tmp;
+			}
+			else {
+				tmp->next = buckets[n];
+				buckets[n] = tmp;
+			}
+			++num_elements;
+			return iterator(tmp, this);
+		}
+
 	public:
 		size_type erase(const key_type& key) {
 			const size_type n = bkt_num_key(key);
@@ -294,19 +346,60 @@ namespace STL {
 					erase_bucket(l_bucket, last.cur);
 			}
 		}
+		void erase(const_iterator pos) {
+			erase(iterator(const_cast<node*>(pos.cur), this));
+		}
+		void erase(const_iterator first, const_iterator last) {
+			erase(iterator(const_cast<node*>(first.cur), this), iterator(const_cast<node*>(last.cur), this));
+		}
 		void clear();
 
 	public:
 		hashtable(size_type n, const hasher& hf, const key_equal& eql)
 			: hash(hf), equals(eql), get_key(ExtractKey()), num_elements(0) {
 			initialize_buckets(n);
-		}	
+		}
+		hashtable(const hashtable& ht)
+			: hash(ht.hash), equals(ht.equals), get_key(ht.get_key), num_elements(0) {
+			copy_from(ht);
+		}
+		hashtable& operator=(const hashtable& ht) {
+			if (&ht != this) {
+				clear();
+				hash = ht.hash;
+				equals = ht.equals;
+				get_key = ht.get_key;
+				copy_from(ht);
+			}
+			return *this;
+		}
+		~hashtable() { clear(); }
+
+	public:
+		size_type size() const noexcept { return num_elements; }
+		size_type max_size() const noexcept { return size_type(-1); }
+		bool empty() const noexcept { return size() == 0; }
+
+		iterator begin() noexcept {
+			for (size_type n = 0; n < buckets.size(); ++n)
+				if (buckets[n])
+					return iterator(buckets[n], this);
+			return end();
+		}
+		iterator end() noexcept { return iterator(nullptr, this); }
+		const_iterator begin() const noexcept {
+			for (size_type n = 0; n < buckets.size(); ++n)
+				if (buckets[n])
+					return const_iterator(buckets[n], this);
+			return end();
+		}
+		const_iterator end() const noexcept { return const_iterator(nullptr, this); }
 
 	public:
 		void resize(size_type);
 
 	public:
-		reference find_or_insert(const value_type&) {
+		reference find_or_insert(const value_type& obj) {
 			resize(num_elements + 1);
 			size_type n = bkt_num(obj);
 			node* first = buckets[n];
@@ -320,10 +413,10 @@ namespace STL {
 			return tmp->val;
 		}
 		iterator find(const key_type& key) {
-			size_type n = bkt_num_key(key);
-			node* first;
-			for (first = buckets[n]; first && !equals(get_key(first->val), key); first = first->next) { }
-			return iterator(first, this);
+			return iterator(bucket_find(bkt_num_key(key), key), this);
+		}
+		const_iterator find(const key_type& key) const {
+			return const_iterator(bucket_find(bkt_num_key(key), key), this);
 		}
 		size_type count(const key_type& key) const {
 			const size_type n = bkt_num_key(key);
@@ -333,8 +426,8 @@ namespace STL {
 					++result;
 			return result;
 		}
-		pair<iterator, iterator> equal_range(const key_type& key) {
-			using pii = pair<iterator, iterator>;
+		std::pair<iterator, iterator> equal_range(const key_type& key) {
+			using pii = std::pair<iterator, iterator>;
 			const size_type n = bkt_num_key(key);
 			for (node* first = buckets[n]; first; first = first->next)
 				if (equals(get_key(first->val), key)) {
@@ -348,16 +441,74 @@ namespace STL {
 				}
 			return pii(end(), end());
 		}
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& key) const {
+			using pii = std::pair<const_iterator, const_iterator>;
+			const size_type n = bkt_num_key(key);
+			for (const node* first = buckets[n]; first; first = first->next)
+				if (equals(get_key(first->val), key)) {
+					for (const node* cur = first->next; cur; cur = cur->next)
+						if (!equals(get_key(cur->val), key))
+							return pii(const_iterator(first, this), const_iterator(cur, this));
+					for (size_type m = n + 1; m < buckets.size(); ++m)
+						if (buckets[m])
+							return pii(const_iterator(first, this), const_iterator(buckets[m], this));
+					return pii(const_iterator(first, this), end());
+				}
+			return pii(end(), end());
+		}
 
 	public:
-		pair<iterator, bool> insert_unique(const value_type& obj) {
+		std::pair<iterator, bool> insert_unique(const value_type& obj) {
 			resize(num_elements + 1);
 			return insert_unique_noresize(obj);
 		}
-		iterator insert_equal(const value_type&) {
+		iterator insert_equal(const value_type& obj) {
 			resize(num_elements + 1);
 			return insert_equal_noresize(obj);
 		}
+		std::pair<iterator, bool> insert_unique(value_type&& obj) {
+			resize(num_elements + 1);
+			const size_type n = bkt_num(obj);
+			if (node* dup = bucket_find(n, get_key(obj)))
+				return std::pair<iterator, bool>(iterator(dup, this), false);
+			return std::pair<iterator, bool>(link_node(n, nullptr, new_node(std::move(obj))), true);
+		}
+		iterator insert_equal(value_type&& obj) {
+			resize(num_elements + 1);
+			const size_type n = bkt_num(obj);
+			node* prev = bucket_find(n, get_key(obj));
+			return link_node(n, prev, new_node(std::move(obj)));
+		}
+		template <class InputIterator>
+		void insert_unique(InputIterator first, InputIterator last) {
+			for (; first != last; ++first)
+				insert_unique(*first);
+		}
+		template <class InputIterator>
+		void insert_equal(InputIterator first, InputIterator last) {
+			for (; first != last; ++first)
+				insert_equal(*first);
+		}
+		// The node is built before the key is known, so a duplicate costs a
+		// construct and destroy; insert_unique avoids that when a value is at hand.
+		template <class... Args>
+		std::pair<iterator, bool> emplace_unique(Args&&... args) {
+			resize(num_elements + 1);
+			node* tmp = new_node(std::forward<Args>(args)...);
+			const size_type n = bkt_num(tmp->val);
+			if (node* dup = bucket_find(n, get_key(tmp->val))) {
+				delete_node(tmp);
+				return std::pair<iterator, bool>(iterator(dup, this), false);
+			}
+			return std::pair<iterator, bool>(link_node(n, nullptr, tmp), true);
+		}
+		template <class... Args>
+		iterator emplace_equal(Args&&... args) {
+			resize(num_elements + 1);
+			node* tmp = new_node(std::forward<Args>(args)...);
+			const size_type n = bkt_num(tmp->val);
+			return link_node(n, bucket_find(n, get_key(tmp->val)), tmp);
+		}
 		void copy_from(const hashtable&);
 
 	public:
@@ -367,13 +518,19 @@ namespace STL {
 		size_type max_bucket_count() const {
 			return __stl_prime_list[__stl_num_primes - 1];
 		}
+		size_type elems_in_bucket(size_type n) const {
+			size_type result = 0;
+			for (const node* cur = buckets[n]; cur; cur = cur->next)
+				++result;
+			return result;
+		}
 	public:
 		void swap(hashtable& rhs) noexcept {
-			std::swap(hash, rhs.hash);
-			std::swap(equals, rhs.equals);
-			std::swap(get_key, rhs.get_key);
+			STL::swap(hash, rhs.hash);
+			STL::swap(equals, rhs.equals);
+			STL::swap(get_key, rhs.get_key);
 			buckets.swap(rhs.buckets);
-			std::swap(num_elements, rhs.num_elements);
+			STL::swap(num_elements, rhs.num_elements);
 		}
 	};
 
@@ -407,13 +564,15 @@ namespace STL {
 		}
 	}
 
+	// A throwing hash leaves the nodes split between the two bucket arrays;
+	// both are emptied before the exception goes on.
 	template <class V, class K, class HF, class Ex, class Eq, class A>
 	void hashtable<V, K, HF, Ex, Eq, A>::resize(size_type num_elements_hint) {
 		const size_type old_n = buckets.size();
 		if (num_elements_hint > old_n) {
 			const size_type n = next_size(num_elements_hint);
 			if (n > old_n) {
-				vector<node*> tmp(n, static_cast<node*>(nullptr));
+				vector<node*, A> tmp(n, static_cast<node*>(nullptr));
 				try {
 					for (size_type bucket = 0; bucket < old_n; ++bucket) {
 						node* first = buckets[bucket];
@@ -427,8 +586,15 @@ namespace STL {
 					}
 					buckets.swap(tmp);
 				}
-				catch (std::exception&) {
+				catch (...) {
+					for (size_type bucket = 0; bucket < n; ++bucket) {
+						while (node* cur = tmp[bucket]) {
+							tmp[bucket] = cur->next;
+							delete_node(cur);
+						}
+					}
 					clear();
+					throw;
 				}
 			}
 		}
@@ -440,21 +606,23 @@ namespace STL {
 		buckets.reserve(ht.buckets.size());
 		buckets.insert(buckets.end(), ht.buckets.size(), static_cast<node*>(nullptr));
 		try {
+			__node_batch<node, A> nodes;
 			for (size_type i = 0; i < ht.buckets.size(); ++i) {
 				if (const node * cur = ht.buckets[i]) {
-					node* copy = new_node(cur->val);
+					node* copy = construct_node(nodes.get(), cur->val);
 					buckets[i] = copy;
 
-					for (node* next = cur->next; next; cur = next, next = next->next) {
-						copy->next = new_node(next->val);
+					for (const node* next = cur->next; next; cur = next, next = next->next) {
+						copy->next = construct_node(nodes.get(), next->val);
 						copy = copy->next;
 					}
 				}
 			}
 			num_elements = ht.num_elements;
 		}
-		catch (std::exception&) {
+		catch (...) {
 			clear();
+			throw;
 		}
 	}
 
@@ -462,7 +630,7 @@ namespace STL {
 	inline void hashtable<Value, Key, HashFcn, ExtractKey, EqualKey, Alloc>::clear() {
 		for (size_type i = 0; i != buckets.size(); ++i) {
 			node* cur = buckets[i];
-			while (cur != null) {
+			while (cur != nullptr) {
 				node* next = cur->next;
 				delete_node(cur);
 				cur = next;
@@ -471,4 +639,36 @@ namespace STL {
 		}
 		num_elements = 0;
 	}
-}	
+
+	// Equal when every run of equal keys in lhs has a run in rhs holding the
+	// same values, in any order.
+	template <class V, class K, class HF, class Ex, class Eq, class A>
+	bool operator==(const hashtable<V, K, HF, Ex, Eq, A>& lhs, const hashtable<V, K, HF, Ex, Eq, A>& rhs) {
+		using const_iterator = typename hashtable<V, K, HF, Ex, Eq, A>::const_iterator;
+		if (lhs.size() != rhs.size())
+			return false;
+		Ex get_key;
+		for (const_iterator it = lhs.begin(); it != lhs.end(); ) {
+			std::pair<const_iterator, const_iterator> l = lhs.equal_range(get_key(*it));
+			std::pair<const_iterator, const_iterator> r = rhs.equal_range(get_key(*it));
+			for (const_iterator x = l.first; x != l.second; ++x) {
+				size_t in_l = 0, in_r = 0;
+				for (const_iterator y = l.first; y != l.second; ++y)
+					in_l += *y == *x;
+				for (const_iterator y = r.first; y != r.second; ++y)
+					in_r += *y == *x;
+				if (in_l != in_r)
+					return false;
+			}
+			size_t l_len = 0, r_len = 0;
+			for (; l.first != l.second; ++l.first)
+				++l_len;
+			for (; r.first != r.second; ++r.first)
+				++r_len;
+			if (l_len != r_len)
+				return false;
+			it = l.second;
+		}
+		return true;
+	}
+}
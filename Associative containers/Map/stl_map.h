@@ -5,12 +5,13 @@
 
 namespace STL {
 
-	template <class Key, class T, class Compare = less<Key>, class Alloc = simpleAlloc<Key> >
+	template <class Key, class T, class Compare = less<Key>, class Alloc = slab_alloc>
 	class map {
+	public:
 		using key_type = Key;
 		using data_type = T;
 		using mapped_type = T;
-		using value_type = pair<const Key, T>;
+		using value_type = std::pair<const Key, T>;
 		using key_compare = Compare;
 
 		class value_compare : public binary_function<value_type, value_type, bool> {
@@ -54,7 +55,7 @@ namespace STL {
 		}
 
 		map(const map<Key, T, Compare, Alloc>& x) : t(x.t) { }
-		map(const map<Key, T, Compare, Alloc>& operator=(const map(const map<Key, T, Compare, Alloc>& x) {
+		map<Key, T, Compare, Alloc>& operator=(const map<Key, T, Compare, Alloc>& x) {
 			t = x.t;
 			return *this;
 		}
@@ -73,16 +74,27 @@ namespace STL {
 		size_type size() const noexcept { return t.size(); }
 		size_type max_size() const noexcept { return t.max_size(); }
 		T& operator[](const key_type& k) {
-			return (*(insert(value_type(k, T()))).first()).second;
+			return (*(insert(value_type(k, T())).first)).second;
 		}
 		void swap(map<Key, T, Compare, Alloc>& x) noexcept { t.swap(x.t); }
 
-		pair<iterator, bool> insert(const value_type& x) {
+		std::pair<iterator, bool> insert(const value_type& x) {
 			return t.insert_unique(x);
 		}
 		iterator insert(iterator position, const value_type& x) {
 			return t.insert_unique(position, x);
 		}
+		std::pair<iterator, bool> insert(value_type&& x) {
+			return t.insert_unique(std::move(x));
+		}
+		template <class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args) {
+			return t.emplace_unique(std::forward<Args>(args)...);
+		}
+		template <class... Args>
+		iterator emplace_hint(iterator position, Args&&... args) {
+			return t.emplace_hint_unique(position, std::forward<Args>(args)...);
+		}
 		template <class InputIterator>
 		void insert(InputIterator first, InputIterator last) {
 			t.insert_unique(first, last);
@@ -105,14 +117,16 @@ namespace STL {
 			return t.upper_bound(x);
 		}
 
-		pair<iterator, iterator> equal_range(const key_type& x) noexcept {
+		std::pair<iterator, iterator> equal_range(const key_type& x) noexcept {
 			return t.equal_range(x);
 		}
-		pair<const_iterator, const_iterator> equal_range(const key_type& x) const noexcept {
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& x) const noexcept {
 			return t.equal_range(x);
 		}
-		friend bool operator==(const map&, const map&);
-		friend bool operator<(const map&, const map&);
+		template <class K, class Tp, class C, class A>
+		friend bool operator==(const map<K, Tp, C, A>&, const map<K, Tp, C, A>&);
+		template <class K, class Tp, class C, class A>
+		friend bool operator<(const map<K, Tp, C, A>&, const map<K, Tp, C, A>&);
 	};
 
 	template <class Key, class Tp, class Compare, class Alloc>
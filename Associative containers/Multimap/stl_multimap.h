@@ -5,16 +5,17 @@
 
 namespace STL {
 
-	template <class Key, class T, class Compare = less<key>, class Alloc = alloc>
+	template <class Key, class T, class Compare = less<Key>, class Alloc = slab_alloc>
 	class multimap {
+	public:
 		using key_type = Key;
 		using data_type = T;
 		using mapped_type = T;
-		using value_type = pair<const Key, T>;
+		using value_type = std::pair<const Key, T>;
 		using key_compare = Compare;
 
 		class value_compare : public binary_function<value_type, value_type, bool> {
-			friend class map<Key, T, Compare, Alloc>;
+			friend class multimap<Key, T, Compare, Alloc>;
 		protected:
 			Compare comp;
 			value_compare(Compare c) : comp(c) { }
@@ -40,7 +41,7 @@ namespace STL {
 		using size_type = typename rep_type::size_type;
 		using difference_type = typename rep_type::difference_type;
 
-		map() : t(Compare()) { }
+		multimap() : t(Compare()) { }
 		explicit multimap(const Compare& comp) : t(comp) { }
 
 		template <class InputIterator>
@@ -53,8 +54,8 @@ namespace STL {
 			t.insert_equal(first, last);
 		}
 
-		multimap(const map<Key, T, Compare, Alloc>& x) : t(x.t) { }
-		multimap(const map<Key, T, Compare, Alloc>& operator=(const map(const map<Key, T, Compare, Alloc>& x) {
+		multimap(const multimap<Key, T, Compare, Alloc>& x) : t(x.t) { }
+		multimap<Key, T, Compare, Alloc>& operator=(const multimap<Key, T, Compare, Alloc>& x) {
 			t = x.t;
 			return *this;
 		}
@@ -72,17 +73,25 @@ namespace STL {
 		bool empty() const noexcept { return t.empty(); }
 		size_type size() const noexcept { return t.size(); }
 		size_type max_size() const noexcept { return t.max_size(); }
-		T& operator[](const key_type& k) {
-			return (*(insert(value_type(k, T()))).first()).second;
-		}
-		void swap(map<Key, T, Compare, Alloc>& x) noexcept { t.swap(x.t); }
+		void swap(multimap<Key, T, Compare, Alloc>& x) noexcept { t.swap(x.t); }
 
-		pair<iterator, bool> insert(const value_type& x) {
+		iterator insert(const value_type& x) {
 			return t.insert_equal(x);
 		}
 		iterator insert(iterator position, const value_type& x) {
 			return t.insert_equal(position, x);
 		}
+		iterator insert(value_type&& x) {
+			return t.insert_equal(std::move(x));
+		}
+		template <class... Args>
+		iterator emplace(Args&&... args) {
+			return t.emplace_equal(std::forward<Args>(args)...);
+		}
+		template <class... Args>
+		iterator emplace_hint(iterator position, Args&&... args) {
+			return t.emplace_hint_equal(position, std::forward<Args>(args)...);
+		}
 		template <class InputIterator>
 		void insert(InputIterator first, InputIterator last) {
 			t.insert_equal(first, last);
@@ -105,14 +114,16 @@ namespace STL {
 			return t.upper_bound(x);
 		}
 
-		pair<iterator, iterator> equal_range(const key_type& x) noexcept {
+		std::pair<iterator, iterator> equal_range(const key_type& x) noexcept {
 			return t.equal_range(x);
 		}
-		pair<const_iterator, const_iterator> equal_range(const key_type& x) const noexcept {
+		std::pair<const_iterator, const_iterator> equal_range(const key_type& x) const noexcept {
 			return t.equal_range(x);
 		}
-		friend bool operator==(const map&, const map&);
-		friend bool operator<(const map&, const map&);
+		template <class K, class Tp, class C, class A>
+		friend bool operator==(const multimap<K, Tp, C, A>&, const multimap<K, Tp, C, A>&);
+		template <class K, class Tp, class C, class A>
+		friend bool operator<(const multimap<K, Tp, C, A>&, const multimap<K, Tp, C, A>&);
 	};
 
 	template <class Key, class Tp, class Compare, class Alloc>
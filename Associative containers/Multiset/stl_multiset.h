@@ -4,7 +4,7 @@
 
 namespace STL {
 
-	template <class Key, class Compare = less<Key>, class Alloc = simpleAlloc<Key> >
+	template <class Key, class Compare = less<Key>, class Alloc = slab_alloc>
 	class multiset {
 	public:
 		using key_type = Key;
@@ -39,8 +39,8 @@ namespace STL {
 			t.insert_equal(first, last);
 		}
 
-		multiset(const set<Key, Compare, Alloc>& x) : t(x.t) { }
-		multisetn<Key, Compare, Alloc>& operator=(const set<Key, Compare, Alloc>& x) {
+		multiset(const multiset<Key, Compare, Alloc>& x) : t(x.t) { }
+		multiset<Key, Compare, Alloc>& operator=(const multiset<Key, Compare, Alloc>& x) {
 			t = x.t;
 			return *this;
 		}
@@ -54,35 +54,45 @@ namespace STL {
 		bool empty() const noexcept { return t.empty(); }
 		size_type size() const noexcept { return t.size(); }
 		size_type max_size() const noexcept { return t.max_size(); }
-		void swap(set<Key, Compare, Alloc>& x) { t.swap(x.t); }
+		void swap(multiset<Key, Compare, Alloc>& x) { t.swap(x.t); }
 
-		using pair_iterator_bool = pair<iterator, bool>;
-		pair<iterator, bool> insert(const value_type& x) {
-			pair<typename rep_type::iterator, bool> p = t.insert_equal(x);
-			return pair<iterator, bool>(p.first, p.second);
+		iterator insert(const value_type& x) {
+			return t.insert_equal(x);
 		}
 		iterator insert(iterator position, const value_type& x) {
 			using rep_iterator = typename rep_type::iterator;
 			return t.insert_equal(reinterpret_cast<rep_iterator&>(position), x);
 		}
+		iterator insert(value_type&& x) {
+			return t.insert_equal(std::move(x));
+		}
+		template <class... Args>
+		iterator emplace(Args&&... args) {
+			return t.emplace_equal(std::forward<Args>(args)...);
+		}
+		template <class... Args>
+		iterator emplace_hint(iterator position, Args&&... args) {
+			using rep_iterator = typename rep_type::iterator;
+			return t.emplace_hint_equal(reinterpret_cast<rep_iterator&>(position), std::forward<Args>(args)...);
+		}
 		template <class InputIterator>
 		void insert(InputIterator first, InputIterator last) {
 			t.insert_equal(first, last);
 		}
 		void erase(iterator position) {
 			using rep_iterator = typename rep_type::iterator;
-			t.erase(reinterpret_cast<rep_iterator>(position));
+			t.erase(reinterpret_cast<rep_iterator&>(position));
 		}
 		size_type erase(const key_type& x) {
 			return t.erase(x);
 		}
 		void erase(iterator first, iterator last) {
 			using rep_iterator = typename rep_type::iterator;
-			t.erase(reinterpret_cast<rep_iterator>(first), reinterpret_cast<rep_iterator>(last));
+			t.erase(reinterpret_cast<rep_iterator&>(first), reinterpret_cast<rep_iterator&>(last));
 		}
 		void clear() noexcept { t.clear(); }
 
-		iterator find(const key_type& x) noexcept { return t.find(x); }
+		iterator find(const key_type& x) const noexcept { return t.find(x); }
 		size_type count(const key_type& x) const noexcept { return t.count(x); }
 		iterator lower_bound(const key_type& x) const noexcept {
 			return t.lower_bound(x);
@@ -90,12 +100,14 @@ namespace STL {
 		iterator upper_bound(const key_type& x)  const noexcept {
 			return t.upper_bound(x);
 		}
-		pair<iterator, iterator> equal_range(const key_type& x) {
+		std::pair<iterator, iterator> equal_range(const key_type& x) const noexcept {
 			return t.equal_range(x);
 		}
 
-		friend bool operator==(const set&, const set&);
-		friend bool operator<(const set&, const set&);
+		template <class K, class C, class A>
+		friend bool operator==(const multiset<K, C, A>&, const multiset<K, C, A>&);
+		template <class K, class C, class A>
+		friend bool operator<(const multiset<K, C, A>&, const multiset<K, C, A>&);
 	};
 
 	template <class Key, class Compare, class Alloc>
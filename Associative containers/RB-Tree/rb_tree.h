@@ -1,20 +1,24 @@
 #pragma once
 
+#include <utility>
 #include "allocator.h"
+#include "object_pool.h"
 #include "stl_algobase.h"
 #include "stl_function.h"
 #include "rb_tree_iterator.h"
 
 namespace STL {
 
-	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = simpleAlloc<Value> >
+	// The tree containers default to slab_alloc, which keeps each tree's
+	// nodes packed in per-type slabs (object_pool.h).
+	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc = slab_alloc>
 		class rb_tree {
 
 		private:
 			using void_pointer = void*;
 			using base_ptr = __rb_tree_node_base *;
 			using rb_tree_node = __rb_tree_node<Value>;
-			using rb_tree_node_allocator = simpleAlloc<rb_tree_node>;
+			using rb_tree_node_allocator = simpleAlloc<rb_tree_node, Alloc>;
 			using color_type = __rb_tree_color_type;
 
 		public:
@@ -30,21 +34,24 @@ namespace STL {
 
 		private:
 			link_type get_node() { return rb_tree_node_allocator::allocate(); }
-			void put_node(link_type) { rb_tree_node_allocator::deallocate(p); }
-
-			link_type create_node(const value_type& x) {
-				link_type tmp = get_node();
-				try{
-					construct(&tmp->value_field, x);
+			void put_node(link_type p) { rb_tree_node_allocator::deallocate(p); }
+
+			template <class... Args>
+			link_type create_node(Args&&... args) { return construct_node(get_node(), std::forward<Args>(args)...); }
+			template <class... Args>
+			link_type construct_node(link_type tmp, Args&&... args) {
+				try {
+					construct(&tmp->value_field, std::forward<Args>(args)...);
 				}
-				throw {
+				catch (...) {
 					put_node(tmp);
+					throw;
 				}
 				return tmp;
 			}
 
-			link_type clone_node(link_type x) {
-				link_type tmp = create_node(x->value_field);
+			link_type clone_node(base_ptr x) {
+				link_type tmp = create_node(value(x));
 				tmp->color = x->color;
 				tmp->left = nullptr;
 				tmp->right = nullptr;
@@ -52,7 +59,7 @@ namespace STL {
 			}
 
 			void destroy_node(link_type p) {
-				destroy(&p->value_field);
+				STL::destroy(&p->value_field);
 				put_node(p);
 			}
 
@@ -62,66 +69,55 @@ namespace STL {
 			Compare key_compare;
 
 		private:
-			link_type& root() const noexcept { return reinterpret_cast<link_type&>(header->parent); }
-			link_type& leftmost() const noexcept { return reinterpret_cast<link_type&>(header->left); }
-			link_type& rightmost() const noexcept { return reinterpret_cast<link_type&>(header->right); }
-
-			static link_type& left(link_type x) {
-				return reinterpret_cast<link_type&>(x->left);
-			}
-			static link_type& right(link_type x) {
-				return reinterpret_cast<link_type&>(x->right);
-			}
-			static link_type& parent(link_type x) {
-				return reinterpret_cast<link_type&>(x->parent);
-			}
-			static reference& value(link_type x) {
-				return x->value_field;
-			}
-			static const Key& key(link_type x) {
-				return KeyOfValue()(value(x));
-			}
-			static color_type& color(link_type x) {
-				return reinterpret_cast<color_type&>(x->color);
-			}
+			base_ptr& root() const noexcept { return header->parent; }
+			base_ptr& leftmost() const noexcept { return header->left; }
+			base_ptr& rightmost() const noexcept { return header->right; }
 
-			static link_type& left(base_ptr x) {
-				return reinterpret_cast<link_type&>(x->left);
-			}
-			static link_type& right(base_ptr x) {
-				return reinterpret_cast<link_type&>(x->right);
-			}
-			static link_type& parent(base_ptr x){
-				return reinterpret_cast<link_type&>(x->parent);
-			}
-			static reference& value(base_ptr x) {
-				return reinterpret_cast<link_type>(x)->value_field;
-			}
-			static const Key& key(base_ptr x) {
-				return KeyOfValue()(value(reinterpret_cast<link_type>(x)));
-			}
-			static color_type& color(base_ptr x) {
-				return reinterpret_cast<color_type&>(reinterpret_cast<link_type>(x)->color);
-			}
+			static base_ptr& left(base_ptr x) { return x->left; }
+			static base_ptr& right(base_ptr x) { return x->right; }
+			static base_ptr& parent(base_ptr x) { return x->parent; }
+			static color_type& color(base_ptr x) { return x->color; }
+			static reference value(base_ptr x) { return static_cast<link_type>(x)->value_field; }
+			static const Key& key(base_ptr x) { return KeyOfValue()(value(x)); }
 
-			static link_type minimum(link_type x) {
-				return reinterpret_cast<link_type>(__rb_tree_node_base::minimum(x));
+			static link_type minimum(base_ptr x) {
+				return static_cast<link_type>(__rb_tree_node_base::minimum(x));
 			}
-			static link_type maximum(link_type x) {
-				return reinterpret_cast<link_type>(__rb_tree_node_base::maximum(x));
+			static link_type maximum(base_ptr x) {
+				return static_cast<link_type>(__rb_tree_node_base::maximum(x));
 			}
 
 		public:
 			using iterator = __rb_tree_iterator<value_type, reference, pointer>;
 			using const_iterator = __rb_tree_iterator<value_type, const_reference, const_pointer>;
-			using reverse_iterator = __reverse_iterator<iterator>;
-			using const_reverse_iterator = __reverse_iterator<const_iterator>;
+			using reverse_iterator = STL::reverse_iterator<iterator>;
+			using const_reverse_iterator = STL::reverse_iterator<const_iterator>;
 
 		private:
-			iterator __insert(base_ptr x, base_ptr y, const value_type& v);
+			iterator __insert(base_ptr x, base_ptr y, const value_type& v) { return __insert(x, y, create_node(v)); }
+			iterator __insert(base_ptr x, base_ptr y, link_type z);
+			bool unique_position(const key_type& k, base_ptr& x, base_ptr& y, iterator& j);
+			// Link an already built node; a duplicate key destroys it.
+			std::pair<iterator, bool> insert_node_unique(link_type z) {
+				base_ptr x, y;
+				iterator j;
+				if (unique_position(key(z), x, y, j))
+					return std::pair<iterator, bool>(__insert(x, y, z), true);
+				destroy_node(z);
+				return std::pair<iterator, bool>(j, false);
+			}
+			iterator insert_node_equal(link_type z) {
+				base_ptr y = header;
+				base_ptr x = root();
+				while (x != nullptr) {
+					y = x;
+					x = key_compare(key(z), key(x)) ? left(x) : right(x);
+				}
+				return __insert(x, y, z);
+			}
 			void init() {
 				header = get_node();
-				color(header) = __rb_tree_color_red;
+				color(header) = __rb_tree_red;
 
 				root() = nullptr;
 				leftmost() = header;
@@ -152,7 +148,7 @@ namespace STL {
 				y->parent = x->parent;
 				if (x == root)
 					root = y;
-				else if (x == x->parent->left)
+				else if (x == x->parent->right)
 					x->parent->right = y;
 				else
 					x->parent->left = y;
@@ -236,7 +232,7 @@ namespace STL {
 					else
 						z->parent->right = y;
 					y->parent = z->parent;
-					MiniSTL::swap(y->color, z->color);
+					STL::swap(y->color, z->color);
 					y = z;
 				}
 				else {
@@ -248,87 +244,108 @@ namespace STL {
 						z->parent->left = x;
 					else
 						z->parent->right = x;
-					if (leftmost == z)
+					if (leftmost == z) {
 						if (!z->right)
 							leftmost = z->parent;
 						else
 							leftmost = __rb_tree_node_base::minimum(x);
-					if (rightmost == z)
+					}
+					if (rightmost == z) {
 						if (!z->left)
 							rightmost = z->parent;
 						else
 							rightmost = __rb_tree_node_base::maximum(x);
+					}
 				}
-				if (y->color != rb_tree_red) {
-					while (x != root && (!x || x->color == rb_tree_black))
-						if (x == x->parent->left) {
+				if (y->color != __rb_tree_red) {
+					while (x != root && (!x || x->color == __rb_tree_black))
+						if (x == x_parent->left) {
 							base_ptr w = x_parent->right;
-							if (w->color == rb_tree_red) {
-								w->color = rb_tree_black;
-								x_parent->color = rb_tree_red;
-								rb_tree_rotate_left(x_parent, root);
+							if (w->color == __rb_tree_red) {
+								w->color = __rb_tree_black;
+								x_parent->color = __rb_tree_red;
+								__rb_tree_rotate_left(x_parent, root);
 								w = x_parent->right;
 							}
-							if ((!w->left || w->left->color == rb_tree_black) &&
-								(!w->right || w->right->color == rb_tree_black)) {
-								w->color = rb_tree_red;
+							if ((!w->left || w->left->color == __rb_tree_black) &&
+								(!w->right || w->right->color == __rb_tree_black)) {
+								w->color = __rb_tree_red;
 								x = x_parent;
 								x_parent = x_parent->parent;
 							}
 							else {
-								if (!w->right || w->right->color == rb_tree_black) {
-									if (w->left) w->left->color = rb_tree_black;
-									w->color = rb_tree_red;
-									rb_tree_rotate_right(w, root);
+								if (!w->right || w->right->color == __rb_tree_black) {
+									if (w->left) w->left->color = __rb_tree_black;
+									w->color = __rb_tree_red;
+									__rb_tree_rotate_right(w, root);
 									w = x_parent->right;
 								}
 								w->color = x_parent->color;
-								x_parent->color = rb_tree_black;
-								if (x->right) w->right->color = rb_tree_black;
-								rb_tree_rotate_left(x_parent, root);
+								x_parent->color = __rb_tree_black;
+								if (w->right) w->right->color = __rb_tree_black;
+								__rb_tree_rotate_left(x_parent, root);
 								break;
 							}
 						}
 						else {
 							base_ptr w = x_parent->left;
-							if (w->color == rb_tree_red) {
-								w->color = rb_tree_black;
-								x_parent->color = rb_tree_red;
-								rb_tree_rotate_right(x_parent, root);
+							if (w->color == __rb_tree_red) {
+								w->color = __rb_tree_black;
+								x_parent->color = __rb_tree_red;
+								__rb_tree_rotate_right(x_parent, root);
 								w = x_parent->left;
 							}
-							if ((!w->right || w->right->color == rb_tree_black) &&
-								(!w->left || w->left->color == rb_tree_black)) {
-								w->color = rb_tree_red;
+							if ((!w->right || w->right->color == __rb_tree_black) &&
+								(!w->left || w->left->color == __rb_tree_black)) {
+								w->color = __rb_tree_red;
 								x = x_parent;
 								x_parent = x_parent->parent;
 							}
 							else {
-								if (!w->left || w->left->color == rb_tree_black) {
-									if (w->right) w->right->color = rb_tree_black;
-									w->color = rb_tree_red;
-									rb_tree_rotate_left(w, root);
+								if (!w->left || w->left->color == __rb_tree_black) {
+									if (w->right) w->right->color = __rb_tree_black;
+									w->color = __rb_tree_red;
+									__rb_tree_rotate_left(w, root);
 									w = x_parent->left;
 								}
 								w->color = x_parent->color;
-								x_parent->color = rb_tree_black;
-								if (w->left) w->left->color = rb_tree_black;
-								rb_tree_rotate_right(x_parent, root);
+								x_parent->color = __rb_tree_black;
+								if (w->left) w->left->color = __rb_tree_black;
+								__rb_tree_rotate_right(x_parent, root);
 								break;
 							}
 						}
-					if (x) x->color = rb_tree_black;
+					if (x) x->color = __rb_tree_black;
 				}
 				return y;
 			}
 		public:
 			rb_tree(const Compare& comp = Compare())
 				: node_count(0), key_compare(comp) { init(); }
+			rb_tree(const rb_tree& x)
+				: node_count(0), key_compare(x.key_compare) {
+				init();
+				if (x.root()) {
+					root() = __copy(x.root(), header);
+					leftmost() = minimum(root());
+					rightmost() = maximum(root());
+					node_count = x.node_count;
+				}
+			}
+			rb_tree(rb_tree&& x)
+				: node_count(0), key_compare(x.key_compare) {
+				init();
+				swap(x);
+			}
 			~rb_tree() {
 				clear();
 				put_node(header);
 			}
-			rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& operator=(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& x) {
+			rb_tree& operator=(rb_tree&& x) noexcept {
+				swap(x);
+				return *this;
+			}
+			rb_tree& operator=(const rb_tree& x) {
 				if (this != &x) {
 					clear();
 					node_count = 0;
@@ -339,7 +356,7 @@ namespace STL {
 						rightmost() = header;
 					}
 					else {
-						root() = copy(x.root(), header);
+						root() = __copy(x.root(), header);
 						leftmost() = minimum(root());
 						rightmost() = maximum(root());
 						node_count = x.node_count;
@@ -349,14 +366,16 @@ namespace STL {
 			}
 
 		public:
-			const_iterator begin() const noexcept { return leftmost(); }
+			const_iterator begin() const noexcept { return static_cast<link_type>(leftmost()); }
 			const_iterator end() const noexcept { return header; }
-			const_iterator cbegin() const noexcept { return leftmost(); }
+			const_iterator cbegin() const noexcept { return static_cast<link_type>(leftmost()); }
 			const_iterator cend() const noexcept { return header; }
+			const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+			const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
 
 		public:
 			Compare key_comp() const { return key_compare; }
-			iterator begin() noexcept { return leftmost(); }
+			iterator begin() noexcept { return static_cast<link_type>(leftmost()); }
 			iterator end() noexcept { return header; }
 			reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
 			reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
@@ -365,25 +384,19 @@ namespace STL {
 			size_type max_size() const noexcept { return size_type(-1); }
 
 		public:
-			pair<iterator, bool> insert_unique(const value_type& x) {
-				link_type y = header;
-				link_type x = root();
-				bool comp = true;
-				while (x != nullptr) {
-					y = x;
-					comp = key_compare(KeyOfValue()(v), key(x));
-					x = comp ? left(x) : right(x);
-				}
-
-				iterator j(y);
-				if (comp)
-					if (j == begin())
-						return pair<iterator, bool>(insert_aux(x, y, v), true);
-					else
-						--j;
-				if (key_compare(key(j.node), KeyOfValue()(v)))
-					return pair<iterator, bool>(insert_aux(x, y, v), true);
-				return pair<iterator, bool>(j, false);
+			std::pair<iterator, bool> insert_unique(const value_type& v) {
+				base_ptr x, y;
+				iterator j;
+				if (unique_position(KeyOfValue()(v), x, y, j))
+					return std::pair<iterator, bool>(__insert(x, y, v), true);
+				return std::pair<iterator, bool>(j, false);
+			}
+			std::pair<iterator, bool> insert_unique(value_type&& v) {
+				base_ptr x, y;
+				iterator j;
+				if (unique_position(KeyOfValue()(v), x, y, j))
+					return std::pair<iterator, bool>(__insert(x, y, create_node(std::move(v))), true);
+				return std::pair<iterator, bool>(j, false);
 			}
 
 			iterator insert_unique(iterator pos, const value_type& val) {
@@ -404,9 +417,9 @@ namespace STL {
 					--before;
 					if (key_compare(key(before.node), KeyOfValue()(val)) && key_compare(KeyOfValue()(val), key(pos.node))) {
 						if (!right(before.node))
-							return insert_aux(nullptr, before.node, val);
+							return __insert(nullptr, before.node, val);
 						else
-							return insert_aux(pos.node, pos.node, val);
+							return __insert(pos.node, pos.node, val);
 					}
 					else
 						return insert_unique(val).first;
@@ -415,31 +428,91 @@ namespace STL {
 
 			template <class InputIterator>
 			void insert_unique(InputIterator first, InputIterator last) {
+				__node_batch<rb_tree_node, Alloc> nodes;
+				base_ptr x, y;
+				iterator j;
 				for (; first != last; ++first)
-					insert_unique(*first);
+					if (unique_position(KeyOfValue()(*first), x, y, j))
+						__insert(x, y, construct_node(nodes.get(), *first));
 			}
 
-			iterator insert_equal(const value_type& x) {
-				link_type y = header;
-				link_type x = root();
-				while (x != nullptr) {
-					y = x;
-					x = key_compare(KeyOfValue()(v), key(x)) ? left(x) : right(x);
+			iterator insert_equal(const value_type& v) { return insert_node_equal(create_node(v)); }
+			iterator insert_equal(value_type&& v) { return insert_node_equal(create_node(std::move(v))); }
+			iterator insert_equal(iterator pos, const value_type& v) { return emplace_hint_equal(pos, v); }
+
+			template <class InputIterator>
+			void insert_equal(InputIterator first, InputIterator last) {
+				__node_batch<rb_tree_node, Alloc> nodes;
+				for (; first != last; ++first)
+					insert_node_equal(construct_node(nodes.get(), *first));
+			}
+
+			// The emplace family builds the node first and takes the key from it.
+			template <class... Args>
+			std::pair<iterator, bool> emplace_unique(Args&&... args) {
+				return insert_node_unique(create_node(std::forward<Args>(args)...));
+			}
+			template <class... Args>
+			iterator emplace_equal(Args&&... args) {
+				return insert_node_equal(create_node(std::forward<Args>(args)...));
+			}
+			template <class... Args>
+			iterator emplace_hint_unique(iterator pos, Args&&... args) {
+				link_type z = create_node(std::forward<Args>(args)...);
+				if (pos.node == header) {
+					if (size() > 0 && key_compare(key(rightmost()), key(z)))
+						return __insert(nullptr, rightmost(), z);
+				}
+				else if (pos.node == header->left) {
+					if (key_compare(key(z), key(pos.node)))
+						return __insert(pos.node, pos.node, z);
+				}
+				else {
+					iterator before = pos;
+					--before;
+					if (key_compare(key(before.node), key(z)) && key_compare(key(z), key(pos.node))) {
+						if (!right(before.node))
+							return __insert(nullptr, before.node, z);
+						else
+							return __insert(pos.node, pos.node, z);
+					}
+				}
+				return insert_node_unique(z).first;
+			}
+			template <class... Args>
+			iterator emplace_hint_equal(iterator pos, Args&&... args) {
+				link_type z = create_node(std::forward<Args>(args)...);
+				if (pos.node == header) {
+					if (size() > 0 && !key_compare(key(z), key(rightmost())))
+						return __insert(nullptr, rightmost(), z);
 				}
-				return __insert(x, y, v);
+				else if (!key_compare(key(pos.node), key(z))) {
+					if (pos.node == header->left)
+						return __insert(pos.node, pos.node, z);
+					iterator before = pos;
+					--before;
+					if (!key_compare(key(z), key(before.node))) {
+						if (!right(before.node))
+							return __insert(nullptr, before.node, z);
+						else
+							return __insert(pos.node, pos.node, z);
+					}
+				}
+				return insert_node_equal(z);
 			}
 
 		private:
-			void erase_aux(link_type) noexcept;
+			void erase_aux(base_ptr) noexcept;
+			link_type __copy(base_ptr x, base_ptr p);
 
 		public:
 			void erase(iterator pos) {
-				link_type y = reinterpret_cast<link_type>(rb_tree_rebalance_for_erase(pos.node, header->parent, header->left, header->right));
+				link_type y = static_cast<link_type>(rb_tree_rebalance_for_erase(pos.node, header->parent, header->left, header->right));
 				destroy_node(y);
 				--node_count;
 			}
 			size_type erase(const key_type& k) {
-				pair<iterator, iterator> p = equal_range(k);
+				std::pair<iterator, iterator> p = equal_range(k);
 				size_type n = STL::distance(p.first, p.second);
 				erase(p.first, p.second);
 				return n;
@@ -454,7 +527,7 @@ namespace STL {
 			void clear() noexcept {
 				if (node_count) {
 					erase_aux(root());
-					leftmost() = nheader;
+					leftmost() = header;
 					root() = nullptr;
 					rightmost() = header;
 					node_count = 0;
@@ -462,56 +535,60 @@ namespace STL {
 			}
 
 		public:
-			iterator find(const key_type&) noexcept;
+			iterator find(const key_type& k) noexcept {
+				const_iterator j = static_cast<const rb_tree&>(*this).find(k);
+				return iterator(static_cast<link_type>(j.node));
+			}
+			const_iterator find(const key_type&) const noexcept;
 			size_type count(const key_type& k) const noexcept {
-				pair<const_iterator, const_iterator> p = equal_range(k);
+				std::pair<const_iterator, const_iterator> p = equal_range(k);
 				return STL::distance(p.first, p.second);
 			}
 			iterator lower_bound(const key_type& k) noexcept {
-				link_type y = header;
-				link_type x = root();
+				base_ptr y = header;
+				base_ptr x = root();
 				while (x)
 					if (!key_compare(key(x), k))
 						y = x, x = left(x);
 					else
 						x = right(x);
-				return iterator(y);
+				return iterator(static_cast<link_type>(y));
 			}
 			const_iterator lower_bound(const key_type& k) const noexcept {
-				link_type y = header;
-				link_type x = root();
+				base_ptr y = header;
+				base_ptr x = root();
 				while (x)
 					if (!key_compare(key(x), k))
 						y = x, x = left(x);
 					else
 						x = right(x);
-				return const_iterator(y);
+				return const_iterator(static_cast<link_type>(y));
 			}
 			iterator upper_bound(const key_type& k) noexcept {
-				link_type y = header;
-				link_type x = root();
+				base_ptr y = header;
+				base_ptr x = root();
 				while (x)
 					if (key_compare(k, key(x)))
 						y = x, x = left(x);
 					else
 						x = right(x);
-				return iterator(y);
+				return iterator(static_cast<link_type>(y));
 			}
 			const_iterator upper_bound(const key_type& k) const noexcept {
-				link_type y = header;
-				link_type x = root();
+				base_ptr y = header;
+				base_ptr x = root();
 				while (x)
 					if (key_compare(k, key(x)))
 						y = x, x = left(x);
 					else
 						x = right(x);
-				return const_iterator(y);
+				return const_iterator(static_cast<link_type>(y));
 			}
-			pair<iterator, iterator> equal_range(const key_type& k) noexcept {
-				return pair<iterator, iterator>(lower_bound(k), upper_bound(k));
+			std::pair<iterator, iterator> equal_range(const key_type& k) noexcept {
+				return std::pair<iterator, iterator>(lower_bound(k), upper_bound(k));
 			}
-			pair<const_iterator, const_iterator> equal_range(const key_type& k) const noexcept {
-				return pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
+			std::pair<const_iterator, const_iterator> equal_range(const key_type& k) const noexcept {
+				return std::pair<const_iterator, const_iterator>(lower_bound(k), upper_bound(k));
 			}
 
 		public:
@@ -520,24 +597,43 @@ namespace STL {
 				STL::swap(node_count, lhs.node_count);
 				STL::swap(key_compare, lhs.key_compare);
 			}
-
-			bool operator==(const rb_tree& lhs, const rb_tree<& rhs) {
-				return lhs.size() == rhs.size() && STL::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin());
-			}
-			bool operator<(const rb_tree& lhs, const rb_tree& rhs) {
-				return STL::lexicographical_compare(lhs.cbegin(), lhs.cend(),rhs.cbegin(), rhs.cend());
-			}
 	};
 
+	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+	inline bool operator==(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs, const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+		return lhs.size() == rhs.size() && STL::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend());
+	}
+
+	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+	inline bool operator<(const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& lhs, const rb_tree<Key, Value, KeyOfValue, Compare, Alloc>& rhs) {
+		return STL::lexicographical_compare(lhs.cbegin(), lhs.cend(), rhs.cbegin(), rhs.cend());
+	}
+
+	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+	bool rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::unique_position(const key_type& k, base_ptr& x, base_ptr& y, iterator& j) {
+		y = header;
+		x = root();
+		bool comp = true;
+		while (x != nullptr) {
+			y = x;
+			comp = key_compare(k, key(x));
+			x = comp ? left(x) : right(x);
+		}
+
+		j = iterator(static_cast<link_type>(y));
+		if (comp) {
+			if (j == begin())
+				return true;
+			--j;
+		}
+		return key_compare(key(j.node), k);
+	}
+
 	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
 	typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-		rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(base_ptr x_, base_ptr y_, const value_type& v) {
-		link_type x = reinterpret_cast<link_type>(x_);
-		link_type y = reinterpret_cast<link_type>(y_);
-		link_type z;
+		rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__insert(base_ptr x, base_ptr y, link_type z) {
 
-		if (y == header || x || key_compare(KeyOfValue()(v), key(y))) {
-			z = create_node(v);
+		if (y == header || x || key_compare(key(z), key(y))) {
 			left(y) = z;
 			if (y == header) {
 				root() = z;
@@ -548,7 +644,6 @@ namespace STL {
 			}
 		}
 		else {
-			z = create_node(v);
 			right(y) = z;
 			if (y == rightmost())
 				rightmost() = z;
@@ -563,27 +658,55 @@ namespace STL {
 	}
 
 	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-	void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase_aux(link_type x) noexcept {
+	void rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::erase_aux(base_ptr x) noexcept {
 		while (x) {
 			erase_aux(right(x));
-			link_type y = left(x);
-			destroy_node(x);
+			base_ptr y = left(x);
+			destroy_node(static_cast<link_type>(x));
 			x = y;
 		}
 	}
 
+	// Clones the subtree at x under p: right subtrees recursively, the left
+	// spine in a loop. A throw frees whatever was already cloned.
 	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
-	typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::iterator
-		rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const key_type& k) noexcept {
-		link_type y = header;
-		link_type x = root();
+	typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::link_type
+		rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::__copy(base_ptr x, base_ptr p) {
+		link_type top = clone_node(x);
+		top->parent = p;
+		try {
+			if (x->right)
+				top->right = __copy(right(x), top);
+			p = top;
+			x = left(x);
+			while (x != nullptr) {
+				link_type y = clone_node(x);
+				p->left = y;
+				y->parent = p;
+				if (x->right)
+					y->right = __copy(right(x), y);
+				p = y;
+				x = left(x);
+			}
+		}
+		catch (...) {
+			erase_aux(top);
+			throw;
+		}
+		return top;
+	}
+
+	template <class Key, class Value, class KeyOfValue, class Compare, class Alloc>
+	typename rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::const_iterator
+		rb_tree<Key, Value, KeyOfValue, Compare, Alloc>::find(const key_type& k) const noexcept {
+		base_ptr y = header;
+		base_ptr x = root();
 		while (x != nullptr)
 			if (!key_compare(key(x), k))
 				y = x, x = left(x);
 			else
 				x = right(x);
-		iterator j = iterator(y);
+		const_iterator j = const_iterator(static_cast<link_type>(y));
 		return (j == end() || key_compare(k, key(j.node))) ? end() : j;
-
 	}
 }
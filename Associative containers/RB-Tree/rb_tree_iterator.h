@@ -12,6 +12,9 @@ namespace STL {
 
 		base_ptr node;
 
+		bool operator==(const __rb_tree_base_iterator& x) const { return node == x.node; }
+		bool operator!=(const __rb_tree_base_iterator& x) const { return node != x.node; }
+
 		void increment() {
 			if (node->right != nullptr) {
 				node = node->right;
@@ -57,14 +60,15 @@ namespace STL {
 		using pointer = Ptr;
 		using iterator = __rb_tree_iterator<T, T&, T*>;
 		using const_iterator = __rb_tree_iterator<T, const T&, const T*>;
-		using self = __rb_tree_iterator<Value, Ref, Ptr>;
-		using link_type = __rb_tree_node<Value>*;
+		using self = __rb_tree_iterator<T, Ref, Ptr>;
+		using link_type = __rb_tree_node<T>*;
 
 		__rb_tree_iterator() { }
 		__rb_tree_iterator(link_type x) { node = x; }
 		__rb_tree_iterator(const iterator& it) { node = it.node; }
+		self& operator=(const self&) = default;
 
-		reference operator*() const { return reinterpret_cast<link_type>(node)->value_field; }
+		reference operator*() const { return static_cast<link_type>(node)->value_field; }
 		#ifndef __SGI_STL_NO_ARROW_OPERATOR
 		pointer operator->() const { return &(operator*()); }
 		#endif /* __SGI_STL_NO_ARROW_OPERATOR */
@@ -80,7 +84,7 @@ namespace STL {
 		self operator--(int) {
 			self tmp = *this;
 			decrement();
-			return temp;
+			return tmp;
 		}
 	};
 }
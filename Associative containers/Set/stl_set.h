@@ -4,7 +4,7 @@
 
 namespace STL {
 
-	template <class Key, class Compare = less<Key>, class Alloc = simpleAlloc<Key> >
+	template <class Key, class Compare = less<Key>, class Alloc = slab_alloc>
 	class set {
 	public:
 		using key_type = Key;
@@ -56,33 +56,47 @@ namespace STL {
 		size_type max_size() const noexcept { return t.max_size(); }
 		void swap(set<Key, Compare, Alloc>& x) { t.swap(x.t); }
 
-		using pair_iterator_bool = pair<iterator, bool>;
-		pair<iterator, bool> insert(const value_type& x) {
-			pair<typename rep_type::iterator, bool> p = t.insert_unique(x);
-			return pair<iterator, bool>(p.first, p.second);
+		using pair_iterator_bool = std::pair<iterator, bool>;
+		std::pair<iterator, bool> insert(const value_type& x) {
+			std::pair<typename rep_type::iterator, bool> p = t.insert_unique(x);
+			return std::pair<iterator, bool>(p.first, p.second);
 		}
 		iterator insert(iterator position, const value_type& x) {
 			using rep_iterator = typename rep_type::iterator;
 			return t.insert_unique(reinterpret_cast<rep_iterator&>(position), x);
 		}
+		std::pair<iterator, bool> insert(value_type&& x) {
+			std::pair<typename rep_type::iterator, bool> p = t.insert_unique(std::move(x));
+			return std::pair<iterator, bool>(p.first, p.second);
+		}
+		template <class... Args>
+		std::pair<iterator, bool> emplace(Args&&... args) {
+			std::pair<typename rep_type::iterator, bool> p = t.emplace_unique(std::forward<Args>(args)...);
+			return std::pair<iterator, bool>(p.first, p.second);
+		}
+		template <class... Args>
+		iterator emplace_hint(iterator position, Args&&... args) {
+			using rep_iterator = typename rep_type::iterator;
+			return t.emplace_hint_unique(reinterpret_cast<rep_iterator&>(position), std::forward<Args>(args)...);
+		}
 		template <class InputIterator>
 		void insert(InputIterator first, InputIterator last) {
 			t.insert_unique(first, last);
 		}
 		void erase(iterator position) {
 			using rep_iterator = typename rep_type::iterator;
-			t.erase(reinterpret_cast<rep_iterator>(position));
+			t.erase(reinterpret_cast<rep_iterator&>(position));
 		}
 		size_type erase(const key_type& x) {
 			return t.erase(x);
 		}
 		void erase(iterator first, iterator last) {
 			using rep_iterator = typename rep_type::iterator;
-			t.erase(reinterpret_cast<rep_iterator>(first), reinterpret_cast<rep_iterator>(last));
+			t.erase(reinterpret_cast<rep_iterator&>(first), reinterpret_cast<rep_iterator&>(last));
 		}
 		void clear() noexcept { t.clear(); }
 
-		iterator find(const key_type& x) noexcept { return t.find(x); }
+		iterator find(const key_type& x) const noexcept { return t.find(x); }
 		size_type count(const key_type& x) const noexcept { return t.count(x); }
 		iterator lower_bound(const key_type& x) const noexcept {
 			return t.lower_bound(x);
@@ -90,12 +104,14 @@ namespace STL {
 		iterator upper_bound(const key_type& x)  const noexcept {
 			return t.upper_bound(x);
 		}
-		pair<iterator, iterator> equal_range(const key_type& x) {
+		std::pair<iterator, iterator> equal_range(const key_type& x) const noexcept {
 			return t.equal_range(x);
 		}
 
-		friend bool operator==(const set&, const set&);
-		friend bool operator<(const set&, const set&);
+		template <class K, class C, class A>
+		friend bool operator==(const set<K, C, A>&, const set<K, C, A>&);
+		template <class K, class C, class A>
+		friend bool operator<(const set<K, C, A>&, const set<K, C, A>&);
 	};
 
 	template <class Key, class Compare, class Alloc>
@@ -134,7 +134,7 @@ namespace STL {
 	protected:
 		Predicate pred;
 	public:
-		explicit unary_function(const Predicate& x) : pred(x) { }
+		explicit unary_negate(const Predicate& x) : pred(x) { }
 		bool operator()(const typename Predicate::argument_type& x) const {
 			return !pred(x);
 		}
@@ -176,7 +176,7 @@ namespace STL {
 
 	template <class Operation, class T>
 	inline binder1st<Operation> bind1st(const Operation& op, const T& x) {
-		using arg1_type = Operation::first_argument_type;
+		using arg1_type = typename Operation::first_argument_type;
 		return binder1st<Operation>(op, arg1_type(x));
 	}
 
@@ -195,7 +195,7 @@ namespace STL {
 
 	template <class Operation, class T>
 	inline binder2nd<Operation> bind2nd(const Operation& op, const T& x) {
-		using arg2_type = Operation::second_argument_type;
+		using arg2_type = typename Operation::second_argument_type;
 		return binder2nd<Operation>(op, arg2_type(x));
 	}
 
@@ -305,7 +305,7 @@ namespace STL {
 	};
 
 	template <class S, class T, class A>
-	class mem_fun1_t : public unary_function<T*, A, S> {
+	class mem_fun1_t : public binary_function<T*, A, S> {
 	public:
 		explicit mem_fun1_t(S (T::*pf)(A)) : f(pf) { }
 		S operator()(T* p, A x) const { return (p->*f)(x); }
@@ -314,7 +314,7 @@ namespace STL {
 	};
 
 	template <class S, class T, class A>
-	class const_mem_fun1_t : public unary_function<const T*, A, S> {
+	class const_mem_fun1_t : public binary_function<const T*, A, S> {
 	public:
 		explicit const_mem_fun1_t(S (T::*pf)(A) const) : f(pf) { }
 		S operator()(const T* p, A x) const { return (p->*f)(x); }
@@ -323,7 +323,7 @@ namespace STL {
 	};
 
 	template <class S, class T, class A>
-	class mem_fun1_ref_t : public unary_function<T, A, S> {
+	class mem_fun1_ref_t : public binary_function<T, A, S> {
 	public:
 		explicit mem_fun1_ref_t(S (T::*pf)(A)) : f(pf) { }
 		S operator()(T& r, A x) const { return (r.*f)(x); }
@@ -332,7 +332,7 @@ namespace STL {
 	};
 
 	template <class S, class T, class A>
-	class const_mem_fun1_ref_t : public unary_function<T, S> {
+	class const_mem_fun1_ref_t : public binary_function<T, A, S> {
 	public:
 		explicit const_mem_fun1_ref_t(S (T::*pf)(A) const) : f(pf) { }
 		S operator()(T& r, A x) const { return (r.*f)(x); }
@@ -351,32 +351,32 @@ namespace STL {
 	}
 
 	template <class S, class T>
-	inline mem_fun_ref_t<S, T> mem_fun(S (T::*f)()) {
+	inline mem_fun_ref_t<S, T> mem_fun_ref(S (T::*f)()) {
 		return mem_fun_ref_t<S, T>(f);
 	}
 
 	template <class S, class T>
-	inline const_mem_fun_ref_t<S, T> mem_fun(S (T::*f)() const) {
+	inline const_mem_fun_ref_t<S, T> mem_fun_ref(S (T::*f)() const) {
 		return const_mem_fun_ref_t<S, T>(f);
 	}
 
 	template <class S, class T, class A>
-	inline mem_fun1_t<S, T, A> mem_fun(S (T::*bfsf)()) {
+	inline mem_fun1_t<S, T, A> mem_fun(S (T::*f)(A)) {
 		return mem_fun1_t<S, T, A>(f);
 	}
 
 	template <class S, class T, class A>
-	inline const_mem_fun1_t<S, T, A> mem_fun(S (T::*f)() const) {
+	inline const_mem_fun1_t<S, T, A> mem_fun(S (T::*f)(A) const) {
 		return const_mem_fun1_t<S, T, A>(f);
 	}
 
 	template <class S, class T, class A>
-	inline mem_fun1_ref_t<S, T, A> mem_fun(S (T::*f)()) {
+	inline mem_fun1_ref_t<S, T, A> mem_fun_ref(S (T::*f)(A)) {
 		return mem_fun1_ref_t<S, T, A>(f);
 	}
 
 	template <class S, class T, class A>
-	inline const_mem_fun1_ref_t<S, T, A> mem_fun(S (T::*f)() const) {
+	inline const_mem_fun1_ref_t<S, T, A> mem_fun_ref(S (T::*f)(A) const) {
 		return const_mem_fun1_ref_t<S, T, A>(f);
 	}
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <cstddef>
+#include <istream>
+#include <ostream>
 
 namespace STL {
 
@@ -46,9 +48,12 @@ namespace STL {
 		using reference = const T &;
 	};
 
+	template <class Iterator>
+	using value_type_t = typename iterator_traits<Iterator>::value_type;
+
 	template <class Iterator>
 	inline typename iterator_traits<Iterator>::iterator_category iterator_category(const Iterator&) {
-		using iterator_category_t = typename iterator_traits<Iterator>::iterator_category;
+		using category = typename iterator_traits<Iterator>::iterator_category;
 		return category();
 	}
 
@@ -57,6 +62,11 @@ namespace STL {
 		return static_cast<typename iterator_traits<Iterator>::difference_type*>(0);
 	}
 
+	template <class Iterator>
+	inline typename iterator_traits<Iterator>::difference_type* distance_type(const Iterator&) {
+		return static_cast<typename iterator_traits<Iterator>::difference_type*>(0);
+	}
+
 	template <class Iterator>
 	inline typename iterator_traits<Iterator>::value_type* value_type(const Iterator&) {
 		return static_cast<typename iterator_traits<Iterator>::value_type*>(0);
@@ -64,7 +74,7 @@ namespace STL {
 
 	template <class InputIterator>
 	inline typename iterator_traits<InputIterator>::difference_type __distance(InputIterator first, InputIterator last, input_iterator_tag) {
-		iterator_traits<InputIterator>::difference_type n = 0;
+		typename iterator_traits<InputIterator>::difference_type n = 0;
 		while (first != last) {
 			++first, ++n;
 		}
@@ -81,7 +91,7 @@ namespace STL {
 	template <class InputIterator>
 	inline typename iterator_traits<InputIterator>::difference_type distance(InputIterator first, InputIterator last) {
 		using iterator_category = typename iterator_traits<InputIterator>::iterator_category;
-		return __distance(first, last, iterator_category);
+		return __distance(first, last, iterator_category());
 	}
 
 	template <class InputIterator, class Distance>
@@ -104,7 +114,7 @@ namespace STL {
 
 	template <class InputIterator, class Distance>
 	inline void advance(InputIterator& i, Distance n) {
-		__advance(i, n, iteraotr_category(i));
+		__advance(i, n, iterator_category(i));
 	}
 
 	template <class Container>
@@ -190,10 +200,10 @@ namespace STL {
 
 	template <class Iterator>
 	class reverse_iterator {
-	protect:
+	protected:
 		Iterator current;
 	public:
-		using iterator_category = typename iterator_traits<Iterator>::iterator_catogory;
+		using iterator_category = typename iterator_traits<Iterator>::iterator_category;
 		using value_type = typename iterator_traits<Iterator>::value_type;
 		using difference_type = typename iterator_traits<Iterator>::difference_type;
 		using pointer = typename iterator_traits<Iterator>::pointer;
@@ -235,14 +245,14 @@ namespace STL {
 		self operator+(difference_type n) const {
 			return self(current - n);
 		}
-		self& operator+=(difference_type n) const {
+		self& operator+=(difference_type n) {
 			current -= n;
 			return *this;
 		}
 		self operator-(difference_type n) const {
 			return self(current + n);
 		}
-		self& operator-=(difference_type n) const {
+		self& operator-=(difference_type n) {
 			current += n;
 			return *this;
 		}
@@ -253,7 +263,7 @@ namespace STL {
 	class istream_iterator {
 		//friend bool operator==(const istream_iterator<T, Distance> x, const istream_iterator<T, Distance> y);
 	protected:
-		istream* stream;
+		std::istream* stream;
 		T value;
 		bool end_marker;
 		void read() {
@@ -268,8 +278,8 @@ namespace STL {
 		using pointer = const T*;
 		using reference = const T &;
 
-		istream_iterator() : stream(&cin), end_marker(false) { }
-		istream_iterator(istream& s) : stream(&s) { read(); }
+		istream_iterator() : stream(nullptr), end_marker(false) { }
+		istream_iterator(std::istream& s) : stream(&s) { read(); }
 
 		reference operator*() const { return value; }
 		pointer operator->() const { return &(operator*()); }
@@ -288,7 +298,7 @@ namespace STL {
 	template <class T>
 	class ostream_iterator {
 	protected:
-		ostream* stream;
+		std::ostream* stream;
 		const char* string;
 
 	public:
@@ -298,8 +308,8 @@ namespace STL {
 		using pointer = void;
 		using reference = void;
 
-		ostream_iterator(ostream& s) : stream(&s), string(0) { }
-		ostream_iterator(ostream& s, const char* c) : stream(&s), string(c) { }
+		ostream_iterator(std::ostream& s) : stream(&s), string(0) { }
+		ostream_iterator(std::ostream& s, const char* c) : stream(&s), string(c) { }
 
 		ostream_iterator<T>& operator=(const T& value) {
 			*stream << value;
@@ -1,133 +1,53 @@
 #pragma once
 
+#include <type_traits>
+
 namespace STL {
 
 	struct __true_type { };
 	struct __false_type { };
 
-	template <class T>
-	struct __type_traits {
-		using has_trivial_default_constructor = __false_type;
-		using has_trivial_copy_constructor = __false_type;
-		using has_trivial_assignment_constructor = __false_type;
-		using has_trivial_destructor_constructor = __false_type;
-		using is_POD_type = __false_type;
-	};
-
-	template <>
-	struct __type_traits<signed char> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<short> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
+	template <bool>
+	struct __bool_type {
+		using type = __false_type;
 	};
 
 	template <>
-	struct __type_traits<unsigned short> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
+	struct __bool_type<true> {
+		using type = __true_type;
 	};
 
-	template <>
-	struct __type_traits<int> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<unsigned int> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<long> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<unsigned long> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<float> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<double> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<long double> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
-
-	template <>
-	struct __type_traits<char> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
-	};
+	// What the compiler knows about T. is_POD_type means the bulk paths may
+	// copy with memcpy/memmove, fill by assignment into raw storage and skip
+	// destructors.
+	template <class T>
+	struct __type_traits_default {
+		using has_trivial_default_constructor = typename __bool_type<std::is_trivially_default_constructible<T>::value>::type;
+		using has_trivial_copy_constructor = typename __bool_type<std::is_trivially_copy_constructible<T>::value>::type;
+		using has_trivial_assignment_constructor = typename __bool_type<std::is_trivially_copy_assignable<T>::value>::type;
+		using has_trivial_assignment_operator = has_trivial_assignment_constructor;
+		using has_trivial_destructor_constructor = typename __bool_type<std::is_trivially_destructible<T>::value>::type;
+		using is_POD_type = typename __bool_type<std::is_trivially_copyable<T>::value
+			&& std::is_trivially_copy_assignable<T>::value
+			&& std::is_trivially_destructible<T>::value>::type;
+	};
+
+	// Builtins, pointers and plain structs are all picked up here. To
+	// override a class, specialize __type_traits and derive from
+	// __type_traits_default to keep the members you do not restate.
+	template <class T>
+	struct __type_traits : __type_traits_default<T> { };
 
-	template <>
-	struct __type_traits<char> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
+	// Objects that can be moved to new storage with a plain memcpy, after
+	// which the old storage is released without running destructors. POD
+	// types qualify; specialize for classes that merely own heap pointers.
+	template <class T>
+	struct __is_trivially_relocatable {
+		using type = typename __type_traits<T>::is_POD_type;
 	};
 
-	template <>
-	struct __type_traits<char> {
-		using has_trivial_default_constructor = __true_type;
-		using has_trivial_copy_constructor = __true_type;
-		using has_trivial_assignment_constructor = __true_type;
-		using has_trivial_destructor_constructor = __true_type;
-		using is_POD_type = __true_type;
+	template <class T>
+	struct __is_trivially_relocatable<T*> {
+		using type = __true_type;
 	};
 }
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include "deque_iterator.h"
+#include "numa_alloc.h"
+
+namespace STL {
+
+	// Block policies for deque. elements() gives the node size in elements
+	// for sizeof(T) == sz; node_alloc<Alloc> is the allocator the nodes come
+	// from. A nonzero Bufsiz still overrides elements().
+
+	enum { __DEQUE_PAGE_BYTES = 4096 };
+
+	constexpr size_t __deque_round_up(size_t n, size_t to) {
+		return (n + to - 1) / to * to;
+	}
+
+	constexpr size_t __deque_ceil_pow2(size_t n, size_t p) {
+		return p >= n ? p : __deque_ceil_pow2(n, 2 * p);
+	}
+
+	// 512-byte nodes, one element per node from 512 bytes up.
+	struct __deque_classic_block {
+		static constexpr size_t elements(size_t sz) { return __deque_buf_size(0, sz); }
+
+		template <class Alloc>
+		using node_alloc = Alloc;
+	};
+
+	// Nodes of BlockBytes, rounded up to whole 4KiB pages, holding at least
+	// MinElements; big elements no longer cost an allocation each and small
+	// ones are walked a page at a time.
+	template <size_t BlockBytes = __DEQUE_PAGE_BYTES, size_t MinElements = 8>
+	struct __deque_paged_block {
+		static_assert(BlockBytes > 0 && MinElements > 0, "empty deque blocks");
+
+		static constexpr size_t elements(size_t sz) {
+			return __deque_round_up(BlockBytes > MinElements * sz ? BlockBytes : MinElements * sz, __DEQUE_PAGE_BYTES) / sz;
+		}
+
+		template <class Alloc>
+		using node_alloc = Alloc;
+	};
+
+	// Nodes straight from the huge-page chunk source: MAP_HUGETLB when the
+	// system has huge pages reserved, else an aligned mapping marked
+	// MADV_HUGEPAGE. The chunk source wants power-of-two sizes; a node
+	// never fills its block exactly, so the request is rounded back up.
+	template <size_t HugeBytes>
+	struct __deque_huge_node_alloc {
+		static void* allocate(size_t n) {
+			void* p = __hugepage_chunk_source::allocate(__deque_ceil_pow2(n, HugeBytes));
+			if (p == nullptr)
+				throw std::bad_alloc();
+			return p;
+		}
+		static void deallocate(void* p, size_t n) { __hugepage_chunk_source::deallocate(p, __deque_ceil_pow2(n, HugeBytes)); }
+	};
+
+	// For deques of hundreds of megabytes and up, where 4KiB pages make
+	// every walk a string of TLB misses. Small deques still pay a huge page.
+	template <size_t HugeBytes = __HUGE_PAGE_BYTES, size_t MinElements = 8>
+	struct __deque_huge_block {
+		static_assert((HugeBytes & (HugeBytes - 1)) == 0, "huge page size must be a power of two");
+
+		static constexpr size_t elements(size_t sz) {
+			return __deque_ceil_pow2(MinElements * sz, HugeBytes) / sz;
+		}
+
+		template <class Alloc>
+		using node_alloc = __deque_huge_node_alloc<HugeBytes>;
+	};
+
+	template <class Block>
+	constexpr size_t __deque_block_size(size_t n, size_t sz) {
+		return n != 0 ? n : Block::elements(sz);
+	}
+}
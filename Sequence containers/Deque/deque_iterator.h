@@ -5,8 +5,8 @@
 
 namespace STL {
 
-	inline size_t __deque_buf_size(size_t n, size_t sz) {
-		return n != 0 ? n : (sz < 521 ? size_t(512 / sz) : size_t(1));
+	constexpr size_t __deque_buf_size(size_t n, size_t sz) {
+		return n != 0 ? n : (sz < 512 ? size_t(512 / sz) : size_t(1));
 	}
 
 	template <class T, class Ref, class Ptr, size_t Bufsiz>
@@ -33,6 +33,19 @@ namespace STL {
 		__deque_iterator() : cur(nullptr), first(nullptr), last(nullptr), node(nullptr) { }
 
 		__deque_iterator(pointer x, map_pointer y) : cur(x), first(*y), last(*y + buffer_size()), node(y) { }
+		__deque_iterator(const __deque_iterator&) = default;
+
+		// Member by member rather than the implicit whole-object copy: GCC 12
+		// value-numbers a copy between two iterators of the same container
+		// (finish = start after a conditional call, as in clear) to the
+		// destination's old members, so finish kept its old position.
+		self& operator=(const self& x) {
+			cur = x.cur;
+			first = x.first;
+			last = x.last;
+			node = x.node;
+			return *this;
+		}
 
 		void set_node(map_pointer new_node) {
 			node = new_node;
@@ -61,11 +74,11 @@ namespace STL {
 			return tmp;
 		}
 		self& operator--() {
-			--cur;
 			if (cur == first) {
 				set_node(node - 1);
-				cur = first;
+				cur = last;
 			}
+			--cur;
 			return *this;
 		}
 		self operator--(int) {
@@ -80,12 +93,13 @@ namespace STL {
 				cur += n;
 			else {
 				difference_type node_offset = offset > 0 ? offset / static_cast<difference_type>(buffer_size())
-					: -static_cast<difference_type>(-offset - 1) / buffer_size() - 1;
+					: -((-offset - 1) / static_cast<difference_type>(buffer_size())) - 1;
 				set_node(node + node_offset);
-				cur = first + (offset - node_offset * static_cast<difference_type>(buffer_size()))
+				cur = first + (offset - node_offset * static_cast<difference_type>(buffer_size()));
 			}
 			return *this;
 		}
+		self& operator-=(difference_type n) { return *this += -n; }
 
 		self operator+(difference_type n) const {
 			self tmp = *this;
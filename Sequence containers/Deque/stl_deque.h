@@ -1,25 +1,30 @@
 #pragma once
 
+#include <utility>
 #include "allocator.h"
 #include "uninitialized.h"
 #include "deque_iterator.h"
+#include "deque_block.h"
 
 namespace STL {
 
-	template <class T, class Alloc = simpleAlloc<T>, size_t Bufsiz = 0>
+	template <class T, class Alloc = alloc, size_t Bufsiz = 0, class Block = __deque_classic_block>
 	class deque {
 
 	public:
 		using value_type = T;
 		using pointer = value_type *;
+		using reference = value_type &;
+		using const_reference = const value_type &;
 		using size_type = size_t;
+		using difference_type = ptrdiff_t;
 	
 	public:
-		using iterator = __deque_iterator<T, T&, Bufsiz>;
+		using iterator = __deque_iterator<T, T&, T*, __deque_block_size<Block>(Bufsiz, sizeof(T))>;
 
 	private:
 		using map_pointer = pointer *;
-		using node_allocator = simpleAlloc<value_type, Alloc>;
+		using node_allocator = simpleAlloc<value_type, typename Block::template node_alloc<Alloc> >;
 		using map_allocator = simpleAlloc<pointer, Alloc>;
 
 	private:
@@ -32,10 +37,10 @@ namespace STL {
 
 	private:
 		value_type* allocate_node() {
-			return node_allocator::allocate(__deque_buf_size(sizeof(value_type)));
+			return node_allocator::allocate(buffer_size());
 		}
 		void deallocate_node(value_type* p) {
-			node_allocator::deallocate(p, __deque_buf_size(sizeof(value_type)));
+			node_allocator::deallocate(p, buffer_size());
 		}
 		void destroy_nodes(map_pointer, map_pointer);
 
@@ -43,17 +48,27 @@ namespace STL {
 		size_type initial_map_size() const noexcept { return 8U; }
 		size_type buffer_size() const noexcept { return iterator::buffer_size(); }
 		void fill_initialize(size_type n, const value_type value);
+		void default_initialize(size_type n);
 		void create_map_and_nodes(size_type num_elements);
 
 	private:
 		void reallocate_map(size_type nodes_to_add, bool add_at_front);
 		void reserve_map_at_back(size_type nodes_to_add = 1);
 		void reserve_map_at_front(size_type nodes_to_add = 1);
+		void new_elements_at_back(size_type new_elements);
 
 	public:
+		deque() : start(), finish(), map(0), map_size(0) {
+			create_map_and_nodes(0);
+		}
 		deque(int n, const value_type& value) : start(), finish(), map(0), map_size(0) {
 			fill_initialize(n, value);
 		}
+		// For buffers about to be overwritten: trivial T is left uninitialized.
+		deque(size_type n, default_init_t) : start(), finish(), map(0), map_size(0) {
+			default_initialize(n);
+		}
+		~deque();
 
 	public:
 		const_reference front() const noexcept { return *start; }
@@ -76,41 +91,53 @@ namespace STL {
 		size_type size() const noexcept { return finish - start; }
 		size_type max_size() const noexcept { return size_type(-1); }
 		bool empty() const noexcept { return finish == start; }
+		void resize_default_init(size_type new_size);
 
 	private:
-		void push_back_aux(const value_type&);
-		void push_front_aux(const value_type&);
+		template <class... Args>
+		void push_back_aux(Args&&... args);
+		template <class... Args>
+		void push_front_aux(Args&&... args);
 		void pop_back_aux();
 		void pop_front_aux();
 
 	public:
-		inline void push_back(const value_type& t) {
+		void push_back(const value_type& t) { emplace_back(t); }
+		void push_back(value_type&& t) { emplace_back(std::move(t)); }
+		void push_front(const value_type& t) { emplace_front(t); }
+		void push_front(value_type&& t) { emplace_front(std::move(t)); }
+
+		template <class... Args>
+		reference emplace_back(Args&&... args) {
 			if (finish.cur != finish.last - 1) {
-				construct(finish.cur, t);
+				construct(finish.cur, std::forward<Args>(args)...);
 				++finish.cur;
 			}
 			else
-				push_back_aux(t);
+				push_back_aux(std::forward<Args>(args)...);
+			return back();
 		}
-		inline void push_front(const value_type& t) {
+		template <class... Args>
+		reference emplace_front(Args&&... args) {
 			if (start.cur != start.first) {
-				construct(start.cur - 1, t);
+				construct(start.cur - 1, std::forward<Args>(args)...);
 				--start.cur;
 			}
 			else
-				push_front_aux(t);
+				push_front_aux(std::forward<Args>(args)...);
+			return *start;
 		}
 		inline void pop_back() {
 			if (finish.cur != finish.first) {
 				--finish.cur;
-				destroy(finish.cur);
+				STL::destroy(finish.cur);
 			}
 			else
 				pop_back_aux();
 		}
 		inline void pop_front() {
 			if (start.cur != start.last - 1) {
-				destroy(start.cur);
+				STL::destroy(start.cur);
 				++start.cur;
 			}
 			else
@@ -118,10 +145,14 @@ namespace STL {
 		}
 
 	private:
-		iterator insert_aux(iterator pos, const value_type& x);
+		template <class... Args>
+		iterator insert_aux(iterator pos, Args&&... args);
 
 	public:
-		iterator insert(iterator position, const value_type& x);
+		template <class... Args>
+		iterator emplace(iterator position, Args&&... args);
+		iterator insert(iterator position, const value_type& x) { return emplace(position, x); }
+		iterator insert(iterator position, value_type&& x) { return emplace(position, std::move(x)); }
 
 	public:
 		iterator erase(iterator pos);
@@ -129,8 +160,8 @@ namespace STL {
 		void clear();
 	};
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::reallocate_map(size_type nodes_to_add,
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	inline void deque<T, Alloc, Bufsiz, Block>::reallocate_map(size_type nodes_to_add,
 		bool add_at_front) {
 		size_type old_num_nodes = finish.node - start.node + 1;
 		size_type new_num_nodes = old_num_nodes + nodes_to_add;
@@ -139,61 +170,64 @@ namespace STL {
 		if (map_size > 2 * new_num_nodes) {
 			new_nstart = map + (map_size - new_num_nodes) / 2
 				+ (add_at_front ? nodes_to_add : 0);
-			if (new_nstart < start.node)
-				STL::copy(start.node, finish.node + 1, new_nstart);
-			else
-				STL::copy_backward(start.node, finish.node + 1, new_nstart + old_num_nodes);
+			STL::uninitialized_relocate(start.node, finish.node + 1, new_nstart);
 		}
 		else {
 			size_type new_map_size = map_size + STL::max(map_size, nodes_to_add) + 2;
 			map_pointer new_map = map_allocator::allocate(new_map_size);
 			new_nstart = new_map + (new_map_size - new_num_nodes) / 2
 				+ (add_at_front ? nodes_to_add : 0);
-			STL::copy(start.node, finish.node + 1, new_nstart);
+			STL::uninitialized_relocate(start.node, finish.node + 1, new_nstart);
 			map_allocator::deallocate(map, map_size);
-			map = new_nstart;
+			map = new_map;
 			map_size = new_map_size;
 		}
 
 		start.set_node(new_nstart);
-		finish.set_node(new_nstart + old_num_nodes);
+		finish.set_node(new_nstart + old_num_nodes - 1);
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::reserve_map_at_back(size_type nodes_to_add) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	inline void deque<T, Alloc, Bufsiz, Block>::reserve_map_at_back(size_type nodes_to_add) {
 		if (nodes_to_add + 1 > map_size - (finish.node - map))
 			reallocate_map(nodes_to_add, false);
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::reserve_map_at_front(size_type nodes_to_add) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	inline void deque<T, Alloc, Bufsiz, Block>::reserve_map_at_front(size_type nodes_to_add) {
 		if (nodes_to_add > static_cast<size_type>(start.node - map))
 			reallocate_map(nodes_to_add, true);
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::push_back_aux(const value_type& t) {
-		value_type t_copy = t;
+	// Growing the map only moves node pointers, so args that refer into the
+	// deque stay valid and the element can be built in place.
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	template <class... Args>
+	inline void deque<T, Alloc, Bufsiz, Block>::push_back_aux(Args&&... args) {
 		reserve_map_at_back();
 		*(finish.node + 1) = allocate_node();
-		__STL_TRY{
-			construct(finish.cur, t_copy);
+		try {
+			construct(finish.cur, std::forward<Args>(args)...);
 			finish.set_node(finish.node + 1);
+			finish.cur = finish.first;
+		}
+		catch (...) {
+			deallocate_node(*(finish.node + 1));
+			throw;
 		}
-		__STL_UNWIND(deallocate_node(*(finish.node + 1)));
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::push_front_aux(const value_type& t) {
-		value_type t_copy = t;
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	template <class... Args>
+	inline void deque<T, Alloc, Bufsiz, Block>::push_front_aux(Args&&... args) {
 		reserve_map_at_front();
 		*(start.node - 1) = allocate_node();
 		try {
 			start.set_node(start.node - 1);
 			start.cur = start.last - 1;
-			construct(start.cur, t_copy);
+			construct(start.cur, std::forward<Args>(args)...);
 		}
-		catch (std::exception&) {
+		catch (...) {
 			start.set_node(start.node + 1);
 			start.cur = start.first;
 			deallocate_node(*(start.node - 1));
@@ -201,31 +235,31 @@ namespace STL {
 		}
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::pop_back_aux() {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	inline void deque<T, Alloc, Bufsiz, Block>::pop_back_aux() {
 		deallocate_node(finish.first);
 		finish.set_node(finish.node - 1);
 		finish.cur = finish.last - 1;
-		destroy(finish.cur);
+		STL::destroy(finish.cur);
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	inline void deque<T, Alloc, Bufsiz>::pop_front_aux() {
-		destroy(start.cur);
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	inline void deque<T, Alloc, Bufsiz, Block>::pop_front_aux() {
+		STL::destroy(start.cur);
 
 		deallocate_node(start.first);
 		start.set_node(start.node + 1);
 		start.cur = start.first;
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	void deque<T, Alloc, Bufsiz>::destroy_nodes(map_pointer nstart, map_pointer nfinish) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::destroy_nodes(map_pointer nstart, map_pointer nfinish) {
 		for (map_pointer n = nstart; n < nfinish; ++n)
 			deallocate_node(*n);
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	void deque<T, Alloc, Bufsiz>::create_map_and_nodes(size_type num_elementes) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::create_map_and_nodes(size_type num_elementes) {
 		size_type num_nodes = num_elementes / buffer_size() + 1;
 
 		map_size = STL::max(initial_map_size(), num_nodes + 2);
@@ -235,11 +269,11 @@ namespace STL {
 		map_pointer nfinish = nstart + num_nodes - 1;
 
 		map_pointer cur;
-		__STL_TRY {
+		try {
 			for (cur = nstart; cur <= nfinish; ++cur)
 				* cur = allocate_node();
 		}
-		catch (std::exception&) {
+		catch (...) {
 			destroy_nodes(nstart, cur);
 			throw;
 		}
@@ -250,27 +284,88 @@ namespace STL {
 		finish.cur = finish.first + num_elementes % buffer_size();
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	void deque<T, Alloc, Bufsiz>::fill_initialize(size_type n, const value_type value) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::fill_initialize(size_type n, const value_type value) {
 		create_map_and_nodes(n);
 		map_pointer cur;
-		__STL_TRY {
+		try {
 			for (cur = start.node; cur < finish.node; ++cur)
 				STL::uninitialized_fill(*cur, *cur + buffer_size(), value);
 			STL::uninitialized_fill(finish.first, finish.cur, value);
 		}
-		catch (std::exception&) {
-			destroy(start, iterator(*cur, cur));
+		catch (...) {
+			STL::destroy(start, iterator(*cur, cur));
 			throw;
 		}
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	typename deque<T, Alloc, Bufsiz>::iterator deque<T, Alloc, Bufsiz>::insert_aux(iterator pos, const value_type& x) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::default_initialize(size_type n) {
+		create_map_and_nodes(n);
+		map_pointer cur;
+		try {
+			for (cur = start.node; cur < finish.node; ++cur)
+				STL::uninitialized_default_init_n(*cur, buffer_size());
+			STL::uninitialized_default_init_n(finish.first, finish.cur - finish.first);
+		}
+		catch (...) {
+			STL::destroy(start, iterator(*cur, cur));
+			throw;
+		}
+	}
+
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::new_elements_at_back(size_type new_elements) {
+		size_type new_nodes = (new_elements + buffer_size() - 1) / buffer_size();
+		reserve_map_at_back(new_nodes);
+		size_type i;
+		try {
+			for (i = 1; i <= new_nodes; ++i)
+				*(finish.node + i) = allocate_node();
+		}
+		catch (...) {
+			for (size_type j = 1; j < i; ++j)
+				deallocate_node(*(finish.node + j));
+			throw;
+		}
+	}
+
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::resize_default_init(size_type new_size) {
+		const size_type old_size = size();
+		if (new_size <= old_size) {
+			iterator new_finish = start + difference_type(new_size);
+			STL::destroy(new_finish, finish);
+			destroy_nodes(new_finish.node + 1, finish.node + 1);
+			finish = new_finish;
+			return;
+		}
+		const size_type n = new_size - old_size;
+		const size_type vacancies = (finish.last - finish.cur) - 1;
+		if (n > vacancies)
+			new_elements_at_back(n - vacancies);
+		iterator new_finish = finish + difference_type(n);
+		iterator cur = finish;
+		try {
+			for (; cur.node != new_finish.node; cur.set_node(cur.node + 1), cur.cur = cur.first)
+				STL::uninitialized_default_init_n(cur.cur, cur.last - cur.cur);
+			STL::uninitialized_default_init_n(cur.cur, new_finish.cur - cur.cur);
+		}
+		catch (...) {
+			STL::destroy(finish, cur);
+			destroy_nodes(finish.node + 1, new_finish.node + 1);
+			throw;
+		}
+		finish = new_finish;
+	}
+
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	template <class... Args>
+	typename deque<T, Alloc, Bufsiz, Block>::iterator deque<T, Alloc, Bufsiz, Block>::insert_aux(iterator pos, Args&&... args) {
 		difference_type index = pos - start;
-		value_type x_copy = x;
-		if (index < size() / 2) {
-			push_front(front());
+		value_type x_copy(std::forward<Args>(args)...);
+		if (index < difference_type(size() / 2)) {
+			emplace_front(std::move(front()));
 			iterator front1 = start;
 			++front1;
 			iterator front2 = front1;
@@ -278,74 +373,75 @@ namespace STL {
 			pos = start + index;
 			iterator pos1 = pos;
 			++pos1;
-			STL::copy(front2, pos1, front1);
+			STL::move(front2, pos1, front1);
 		}
 		else {
-			push_back(back());
+			emplace_back(std::move(back()));
 			iterator back1 = finish;
 			--back1;
 			iterator back2 = back1;
 			--back2;
 			pos = start + index;
-			STL::copy(pos, back2, back1);
+			STL::move_backward(pos, back2, back1);
 		}
-		*pos = x_copy;
+		*pos = std::move(x_copy);
 		return pos;
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	typename deque<T, Alloc, Bufsiz>::iterator deque<T, Alloc, Bufsiz>::insert(iterator position, const value_type& x) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	template <class... Args>
+	typename deque<T, Alloc, Bufsiz, Block>::iterator deque<T, Alloc, Bufsiz, Block>::emplace(iterator position, Args&&... args) {
 		if (position.cur == start.cur) {
-			push_front(x);
+			emplace_front(std::forward<Args>(args)...);
 			return start;
 		}
 		else if (position.cur == finish.cur) {
-			push_back(x);
+			emplace_back(std::forward<Args>(args)...);
 			iterator tmp = finish;
 			--tmp;
 			return tmp;
 		}
 		else
-			return insert_aux(position, x);
+			return insert_aux(position, std::forward<Args>(args)...);
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	typename deque<T, Alloc, Bufsiz>::iterator deque<T, Alloc, Bufsiz>::erase(iterator pos) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	typename deque<T, Alloc, Bufsiz, Block>::iterator deque<T, Alloc, Bufsiz, Block>::erase(iterator pos) {
 		iterator next = pos;
 		++next;
 		difference_type index = pos - start;
-		if (index < (size() >> 1)) {
-			STL::copy_backward(start, pos, next);
+		if (index < difference_type(size() >> 1)) {
+			STL::move_backward(start, pos, next);
 			pop_front();
 		}
 		else {
-			STL::copy(next, finish, pos);
+			STL::move(next, finish, pos);
 			pop_back();
 		}
 		return start + index;
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	typename deque<T, Alloc, Bufsiz>::iterator deque<T, Alloc, Bufsiz>::erase(iterator first, iterator last) {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	typename deque<T, Alloc, Bufsiz, Block>::iterator deque<T, Alloc, Bufsiz, Block>::erase(iterator first, iterator last) {
 		if (first == start && last == finish) {
 			clear();
 			return finish;
 		}
 		else {
 			difference_type n = last - first;
-			difference_type elems_before = first = start;
-			if (elems_before < (size() - n) / 2) {
-				STL::copy_backward(start, first, last);
+			difference_type elems_before = first - start;
+			if (elems_before < (difference_type(size()) - n) / 2) {
+				STL::move_backward(start, first, last);
 				iterator new_start = start + n;
-				destroy(start, new_start);
+				STL::destroy(start, new_start);
 				for (map_pointer cur = start.node; cur < new_start.node; ++cur)
 					node_allocator::deallocate(*cur, buffer_size());
 				start = new_start;
 			}
 			else {
-				STL::copy_backward(last, finish, first);
+				STL::move(last, finish, first);
 				iterator new_finish = finish - n;
-				destroy(new_finish, finish);
+				STL::destroy(new_finish, finish);
 				for (map_pointer cur = new_finish.node + 1; cur <= finish.node; ++cur)
 					node_allocator::deallocate(*cur, buffer_size());
 				finish = new_finish;
@@ -354,20 +450,29 @@ namespace STL {
 		}
 	}
 
-	template <class T, class Alloc, size_t Bufsiz>
-	void deque<T, Alloc, Bufsiz>::clear() {
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	void deque<T, Alloc, Bufsiz, Block>::clear() {
 		for (map_pointer node = start.node + 1; node < finish.node; ++node) {
-			destroy(*node, *node + buffer_size());
+			STL::destroy(*node, *node + buffer_size());
 			node_allocator::deallocate(*node, buffer_size());
 		}
 
 		if (start.node != finish.node) {
-			destroy(start.cur, start.last);
-			destroy(finish.first, finish.cur);
+			STL::destroy(start.cur, start.last);
+			STL::destroy(finish.first, finish.cur);
 			node_allocator::deallocate(finish.first, buffer_size());
 		}
 		else
-			destroy(start.cur, start.last);
+			STL::destroy(start.cur, finish.cur);
 		finish = start;
 	}
+
+	template <class T, class Alloc, size_t Bufsiz, class Block>
+	deque<T, Alloc, Bufsiz, Block>::~deque() {
+		if (!map)
+			return;
+		STL::destroy(start, finish);
+		destroy_nodes(start.node, finish.node + 1);
+		map_allocator::deallocate(map, map_size);
+	}
 }
@@ -1,38 +1,53 @@
 #pragma once
 
+#include <utility>
 #include "allocator.h"
+#include "object_pool.h"
 #include "uninitialized.h"
 #include "stl_list_iterator.h"
 
 namespace STL {
 
-	template <class T, class Alloc = simpleAlloc<T> >
+	// Nodes come from the per-type slab cache in object_pool.h unless another
+	// allocator is given, so a freshly built list walks memory in order.
+	template <class T, class Alloc = slab_alloc>
 	class list {
 
 	private:
 		using list_node = __list_node<T>;
-		using list_node_allocator = simpleAlloc<list_node>;
+		using list_node_allocator = simpleAlloc<list_node, Alloc>;
 
 	public:
 		using link_type = list_node *;
 		using size_type = size_t;
 		using value_type = T;
 		using reference = value_type &;
+		using const_reference = const value_type &;
+		using difference_type = ptrdiff_t;
 
-		using iterator = __list_iterator<T>;
+		using iterator = __list_iterator<T, T&, T*>;
+		using const_iterator = __list_iterator<T, const T&, const T*>;
 
 	private:
 		link_type node;
 		link_type get_node() { return list_node_allocator::allocate(); }
-		void put_node(link_type p) { list_node_allocator::deallocate(); }
+		void put_node(link_type p) { list_node_allocator::deallocate(p); }
 
-		link_type create_node(const& T x) {
-			link_type p = get_node();
-			construct(&p->data, x);
+		template <class... Args>
+		link_type create_node(Args&&... args) { return construct_node(get_node(), std::forward<Args>(args)...); }
+		template <class... Args>
+		link_type construct_node(link_type p, Args&&... args) {
+			try {
+				construct(&p->data, std::forward<Args>(args)...);
+			}
+			catch (...) {
+				put_node(p);
+				throw;
+			}
 			return p;
 		}
 		void destroy_node(link_type p) {
-			destroy(&p->data);
+			STL::destroy(&p->data);
 			put_node(p);
 		}
 
@@ -53,44 +68,102 @@ namespace STL {
 				first.node->prev = tmp;
 			}
 		}
+		iterator link_before(iterator position, link_type tmp) {
+			tmp->next = position.node;
+			tmp->prev = position.node->prev;
+			position.node->prev->next = tmp;
+			position.node->prev = tmp;
+			return tmp;
+		}
+		template <class InputIterator>
+		void range_initialize(InputIterator first, InputIterator last) {
+			empty_initialize();
+			try {
+				insert(begin(), first, last);
+			}
+			catch (...) {
+				clear();
+				put_node(node);
+				throw;
+			}
+		}
+		void fill_initialize(size_type n, const T& value) {
+			empty_initialize();
+			try {
+				insert(begin(), n, value);
+			}
+			catch (...) {
+				clear();
+				put_node(node);
+				throw;
+			}
+		}
 
 	public:
 		list() { empty_initialize(); }
+		list(size_type n, const T& value) { fill_initialize(n, value); }
+		list(int n, const T& value) { fill_initialize(n, value); }
+		list(long n, const T& value) { fill_initialize(n, value); }
+		explicit list(size_type n) { fill_initialize(n, T()); }
+		template <class InputIterator>
+		list(InputIterator first, InputIterator last) { range_initialize(first, last); }
+		list(const list& x) { range_initialize(x.begin(), x.end()); }
+		list(list&& x) {
+			empty_initialize();
+			swap(x);
+		}
+		list& operator=(list x) noexcept {
+			swap(x);
+			return *this;
+		}
+		~list() {
+			clear();
+			put_node(node);
+		}
 
 	public:
 		void swap(list& x) noexcept { STL::swap(node, x.node); }
 
 	public:
-		iterator begin() noexcept { return static_cast<link_type>((*node).next); }
+		iterator begin() noexcept { return node->next; }
 		iterator end() noexcept { return node; }
+		const_iterator begin() const noexcept { return node->next; }
+		const_iterator end() const noexcept { return node; }
 		bool empty() const noexcept { return node->next == node; }
-		size_type size() const noexcept {
-			size_type result = 0;
-			distance(begin(), end(), result);
-			return result;
-		}
+		size_type size() const noexcept { return STL::distance(begin(), end()); }
 		reference front() noexcept { return *begin(); }
-		reference back() noexcept { return *end(); }
+		reference back() noexcept { return *--end(); }
+		const_reference front() const noexcept { return *begin(); }
+		const_reference back() const noexcept { return *--end(); }
 
-		iterator insert(iterator position, const T& x) {
-			link_type tmp = create_node(x);
-			tmp->next = position.node;
-			tmp->prev = position.node->prev;
-			static_cast<link_type>(position.node->prev)->next = tmp;
-			position.node->prev = tmp;
-			return tmp;
+		template <class... Args>
+		iterator emplace(iterator position, Args&&... args) {
+			return link_before(position, create_node(std::forward<Args>(args)...));
 		}
+		iterator insert(iterator position, const T& x) { return emplace(position, x); }
+		iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+		void insert(iterator position, size_type n, const T& x);
+		void insert(iterator position, int n, const T& x) { insert(position, static_cast<size_type>(n), x); }
+		void insert(iterator position, long n, const T& x) { insert(position, static_cast<size_type>(n), x); }
+		template <class InputIterator>
+		void insert(iterator position, InputIterator first, InputIterator last);
 
 		void push_front(const T& x) { insert(begin(), x); }
+		void push_front(T&& x) { insert(begin(), std::move(x)); }
 		void push_back(const T& x) { insert(end(), x); }
+		void push_back(T&& x) { insert(end(), std::move(x)); }
+		template <class... Args>
+		reference emplace_front(Args&&... args) { return *emplace(begin(), std::forward<Args>(args)...); }
+		template <class... Args>
+		reference emplace_back(Args&&... args) { return *emplace(end(), std::forward<Args>(args)...); }
 
 		iterator erase(iterator position) {
-			link_type next_node = static_cast<link_type>(position.node->next);
-			link_type prev_node = static_cast<link_type>(position.node->prev);
+			link_type next_node = position.node->next;
+			link_type prev_node = position.node->prev;
 			prev_node->next = next_node;
 			next_node->prev = prev_node;
 			destroy_node(position.node);
-			return static_cast<iterator>(next_node);
+			return next_node;
 		}
 		void clear();
 
@@ -122,12 +195,27 @@ namespace STL {
 		void remove(const T& value);
 	};
 
+	template <class T, class Alloc>
+	void list<T, Alloc>::insert(iterator position, size_type n, const T& x) {
+		__node_batch<list_node, Alloc> nodes;
+		for (; n > 0; --n)
+			link_before(position, construct_node(nodes.get(), x));
+	}
+
+	template <class T, class Alloc>
+	template <class InputIterator>
+	void list<T, Alloc>::insert(iterator position, InputIterator first, InputIterator last) {
+		__node_batch<list_node, Alloc> nodes;
+		for (; first != last; ++first)
+			link_before(position, construct_node(nodes.get(), *first));
+	}
+
 	template <class T, class Alloc>
 	void list<T, Alloc>::clear() {
-		link_type cur = static_cast<link_type>(node->next);
+		link_type cur = node->next;
 		while (cur != node) {
 			link_type tmp = cur;
-			cur = static_cast<link_type>(cur->next);
+			cur = cur->next;
 			destroy_node(tmp);
 		}
 		node->next = node;
@@ -153,8 +241,8 @@ namespace STL {
 	void list<T, Alloc>::merge(list<T, Alloc>& x) {
 		iterator first1 = begin();
 		iterator last1 = end();
-		iterator first2 = begin();
-		iterator last2 = end();
+		iterator first2 = x.begin();
+		iterator last2 = x.end();
 
 		while(first1 != last1 && first2 != last2)
 			if (*first2 < *first1) {
@@ -169,12 +257,12 @@ namespace STL {
 
 	template <class T, class Alloc>
 	void list<T, Alloc>::reverse() {
-		if (node->next == node || static_cast<link_type>(node->next)->next == node)
+		if (node->next == node || node->next->next == node)
 			return;
 		iterator first = begin();
 		++first;
 		while (first != end()) {
-			iterator olf = first;
+			iterator old = first;
 			++first;
 			transfer(begin(), old, first);
 		}
@@ -182,7 +270,7 @@ namespace STL {
 
 	template <class T, class Alloc>
 	void list<T, Alloc>::sort() {
-		if (node->next == node || static_cast<link_type>(node->next)->next == node)
+		if (node->next == node || node->next->next == node)
 			return;
 
 		list<T, Alloc> carry;
@@ -9,8 +9,9 @@ namespace STL {
 	template <class T, class Ref, class Ptr>
 	struct __list_iterator {
 		using iterator = __list_iterator<T, T&, T*>;
+		using const_iterator = __list_iterator<T, const T&, const T*>;
 		using self = __list_iterator<T, Ref, Ptr>;
-		 
+
 		using iterator_category = bidirectional_iterator_tag;
 		using value_type = T;
 		using pointer = Ptr;
@@ -23,7 +24,8 @@ namespace STL {
 
 		__list_iterator(link_type x) : node(x) { }
 		__list_iterator() { }
-		explicit __list_iterator(const iterator& x) : node(x.node) { }
+		__list_iterator(const iterator& x) : node(x.node) { }
+		self& operator=(const self&) = default;
 
 		bool operator==(const self& x) const noexcept { return node == x.node; }
 		bool operator!=(const self& x) const noexcept { return node != x.node; }
@@ -32,7 +34,7 @@ namespace STL {
 		pointer operator->() const { return &(operator*()); }
 
 		self& operator++() {
-			node = static_cast<link_type>((*node).next);
+			node = (*node).next;
 			return *this;
 		}
 		self operator++(int) {
@@ -42,7 +44,7 @@ namespace STL {
 		}
 
 		self& operator--() {
-			node = static_cast<link_type>((*node).next);
+			node = (*node).prev;
 			return *this;
 		}
 		self operator--(int) {
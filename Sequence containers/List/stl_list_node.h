@@ -4,9 +4,8 @@ namespace STL {
 
 	template <class T>
 	struct __list_node {
-		using void_pointer = void*;
-		void_pointer prev;
-		void_pointer next;
+		__list_node* prev;
+		__list_node* next;
 		T data;
 	};
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utility>
 #include "stl_deque.h"
 #include "stl_vector.h"
 #include "stl_function.h"
@@ -30,6 +31,9 @@ namespace STL {
 		reference back() noexcept { return c.back(); }
 		const_reference back() const noexcept { return c.back(); }
 		void push(const value_type& x) { c.push_back(x); }
+		void push(value_type&& x) { c.push_back(std::move(x)); }
+		template <class... Args>
+		void emplace(Args&&... args) { c.emplace_back(std::forward<Args>(args)...); }
 		void pop() { c.pop_front(); }
 	};
 
@@ -74,6 +78,14 @@ namespace STL {
 			}
 			__STL_UNWIND(c.clear());
 		}
+		template <class... Args>
+		void emplace(Args&&... args) {
+			__STL_TRY{
+				c.emplace_back(std::forward<Args>(args)...);
+				push_heap(c.begin(), c.end(), comp);
+			}
+			__STL_UNWIND(c.clear());
+		}
 		void pop(const value_type& x) {
 			__STL_TRY{
 				pop_heap(c.begin(), c.end(), comp)
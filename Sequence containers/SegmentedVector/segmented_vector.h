@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include "allocator.h"
+#include "uninitialized.h"
+#include "deque_iterator.h"
+
+namespace STL {
+
+	// Elements per segment: n if given, else as many as fit in 4KiB,
+	// rounded down to a power of two so that indexing is a shift and a mask.
+	constexpr size_t __segment_buf_size(size_t n, size_t sz) {
+		return n != 0 ? n : __floor_pow2(sz < 4096 ? 4096 / sz : 1);
+	}
+
+	constexpr size_t __segment_shift(size_t n) {
+		return n < 2 ? 0 : 1 + __segment_shift(n / 2);
+	}
+
+	// A deque that only grows at the back and keeps its first segment at
+	// map[0]. Growth allocates a new segment and at most copies the map of
+	// segment pointers, so pointers and references to elements stay valid
+	// until the element is removed; iterators, which point into the map,
+	// are invalidated by growth as in deque.
+	template <class T, class Alloc = alloc, size_t Segsiz = 0>
+	class segmented_vector {
+
+	public:
+		using value_type = T;
+		using pointer = value_type *;
+		using reference = value_type &;
+		using const_reference = const value_type &;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+
+	private:
+		enum { __SEGMENT = __segment_buf_size(Segsiz, sizeof(T)), __SHIFT = __segment_shift(__SEGMENT) };
+		static_assert((__SEGMENT & (__SEGMENT - 1)) == 0, "segment size must be a power of two");
+
+	public:
+		using iterator = __deque_iterator<T, T&, T*, __SEGMENT>;
+
+	private:
+		using map_pointer = pointer *;
+		using node_allocator = simpleAlloc<value_type, Alloc>;
+		using map_allocator = simpleAlloc<pointer, Alloc>;
+
+	private:
+		iterator start;
+		iterator finish;
+
+		map_pointer map;
+
+		size_type map_size;
+
+	private:
+		value_type* allocate_node() { return node_allocator::allocate(__SEGMENT); }
+		void deallocate_node(value_type* p) { node_allocator::deallocate(p, __SEGMENT); }
+		size_type initial_map_size() const noexcept { return 8U; }
+		void create_map_and_node();
+		void reserve_map_at_back();
+
+		template <class... Args>
+		void push_back_aux(Args&&... args);
+		void pop_back_aux();
+
+	public:
+		segmented_vector() : start(), finish(), map(0), map_size(0) { }
+		segmented_vector(const segmented_vector&) = delete;
+		segmented_vector& operator=(const segmented_vector&) = delete;
+		~segmented_vector();
+
+	public:
+		iterator begin() noexcept { return start; }
+		iterator end() noexcept { return finish; }
+		size_type size() const noexcept {
+			return map ? (size_type(finish.node - map) << __SHIFT) + (finish.cur - finish.first) : 0;
+		}
+		bool empty() const noexcept { return finish == start; }
+		reference operator[](size_type n) { return map[n >> __SHIFT][n & (__SEGMENT - 1)]; }
+		const_reference operator[](size_type n) const { return map[n >> __SHIFT][n & (__SEGMENT - 1)]; }
+		reference front() noexcept { return *start.cur; }
+		reference back() noexcept { return (*this)[size() - 1]; }
+
+		void swap(segmented_vector&) noexcept;
+
+	public:
+		// Contiguous pieces for loops that want plain pointers: segment i
+		// is [segment_data(i), segment_data(i) + segment_size(i)). Every
+		// segment but the last is full.
+		static constexpr size_type segment_capacity() noexcept { return __SEGMENT; }
+		size_type segment_count() const noexcept { return map && !empty() ? ((size() - 1) >> __SHIFT) + 1 : 0; }
+		pointer segment_data(size_type i) noexcept { return map[i]; }
+		size_type segment_size(size_type i) const noexcept {
+			return map + i < finish.node ? size_type(__SEGMENT) : size_type(finish.cur - finish.first);
+		}
+		// Calls f(first, last) once per non-empty segment, front to back.
+		template <class Function>
+		Function for_each_segment(Function f) {
+			const size_type n = segment_count();
+			for (size_type i = 0; i < n; ++i)
+				f(map[i], map[i] + segment_size(i));
+			return f;
+		}
+
+	public:
+		void push_back(const value_type& t) { emplace_back(t); }
+		void push_back(value_type&& t) { emplace_back(std::move(t)); }
+
+		template <class... Args>
+		reference emplace_back(Args&&... args) {
+			if (finish.last - finish.cur > 1) {
+				construct(finish.cur, std::forward<Args>(args)...);
+				++finish.cur;
+				return *(finish.cur - 1);
+			}
+			push_back_aux(std::forward<Args>(args)...);
+			return back();
+		}
+		void pop_back() {
+			if (finish.cur != finish.first) {
+				--finish.cur;
+				destroy(finish.cur);
+			}
+			else
+				pop_back_aux();
+		}
+		void clear();
+	};
+
+	template <class T, class Alloc, size_t Segsiz>
+	void segmented_vector<T, Alloc, Segsiz>::create_map_and_node() {
+		map = map_allocator::allocate(initial_map_size());
+		try {
+			*map = allocate_node();
+		}
+		catch (...) {
+			map_allocator::deallocate(map, initial_map_size());
+			map = 0;
+			throw;
+		}
+		map_size = initial_map_size();
+		start.set_node(map);
+		start.cur = start.first;
+		finish = start;
+	}
+
+	// Doubles the map when the node after finish would fall off its end.
+	// The segments themselves stay where they are.
+	template <class T, class Alloc, size_t Segsiz>
+	void segmented_vector<T, Alloc, Segsiz>::reserve_map_at_back() {
+		const size_type used = finish.node - map + 1;
+		if (used < map_size)
+			return;
+		const size_type new_map_size = 2 * map_size;
+		map_pointer new_map = map_allocator::allocate(new_map_size);
+		STL::uninitialized_relocate(map, map + used, new_map);
+		map_allocator::deallocate(map, map_size);
+		const difference_type offset = finish.cur - finish.first;
+		map = new_map;
+		map_size = new_map_size;
+		start.set_node(map);
+		start.cur = start.first;
+		finish.set_node(map + used - 1);
+		finish.cur = finish.first + offset;
+	}
+
+	// finish stays short of the end of its segment, as in deque, so the
+	// node after the one that just filled up is allocated here.
+	template <class T, class Alloc, size_t Segsiz>
+	template <class... Args>
+	void segmented_vector<T, Alloc, Segsiz>::push_back_aux(Args&&... args) {
+		if (!map) {
+			create_map_and_node();
+			if (finish.last - finish.cur > 1) {
+				try {
+					construct(finish.cur, std::forward<Args>(args)...);
+				}
+				catch (...) {
+					deallocate_node(*map);
+					map_allocator::deallocate(map, map_size);
+					start = finish = iterator();
+					map = 0;
+					map_size = 0;
+					throw;
+				}
+				++finish.cur;
+				return;
+			}
+		}
+		reserve_map_at_back();
+		*(finish.node + 1) = allocate_node();
+		try {
+			construct(finish.cur, std::forward<Args>(args)...);
+		}
+		catch (...) {
+			deallocate_node(*(finish.node + 1));
+			throw;
+		}
+		finish.set_node(finish.node + 1);
+		finish.cur = finish.first;
+	}
+
+	template <class T, class Alloc, size_t Segsiz>
+	void segmented_vector<T, Alloc, Segsiz>::pop_back_aux() {
+		deallocate_node(finish.first);
+		finish.set_node(finish.node - 1);
+		finish.cur = finish.last - 1;
+		destroy(finish.cur);
+	}
+
+	// Keeps the first segment, like deque::clear.
+	template <class T, class Alloc, size_t Segsiz>
+	void segmented_vector<T, Alloc, Segsiz>::clear() {
+		if (!map)
+			return;
+		for (map_pointer node = map; node < finish.node; ++node) {
+			destroy(*node, *node + __SEGMENT);
+			if (node != map)
+				deallocate_node(*node);
+		}
+		destroy(finish.first, finish.cur);
+		if (finish.node != map)
+			deallocate_node(finish.first);
+		finish = start;
+	}
+
+	template <class T, class Alloc, size_t Segsiz>
+	segmented_vector<T, Alloc, Segsiz>::~segmented_vector() {
+		if (!map)
+			return;
+		clear();
+		deallocate_node(*map);
+		map_allocator::deallocate(map, map_size);
+	}
+
+	template <class T, class Alloc, size_t Segsiz>
+	inline void segmented_vector<T, Alloc, Segsiz>::swap(segmented_vector& rhs) noexcept {
+		STL::swap(start, rhs.start);
+		STL::swap(finish, rhs.finish);
+		STL::swap(map, rhs.map);
+		STL::swap(map_size, rhs.map_size);
+	}
+}
@@ -1,12 +1,13 @@
 #pragma once
 
+#include <utility>
 #include "allocator.h"
 #include "uninitialized.h"
 #include "slist_iterator.h"
 
 namespace STL {
 	
-	template <class T, class Alloc = simpleAlloc<T> >
+	template <class T, class Alloc = alloc>
 	class slist {
 
 	public:
@@ -25,33 +26,70 @@ namespace STL {
 		using list_node = __slist_node<T>;
 		using list_node_base = __slist_node_base;
 		using iterator_base = __slist_iterator_base;
-		using list_node_allocator = simpleAlloc<list_node>;
+		using list_node_allocator = simpleAlloc<list_node, Alloc>;
 
-		static list_node* create_node(const value_type& x) {
-			list_node* node = list_node_allocator::allocate();
-			__STL_TRY{
-				construct(&node->data, x);
+		template <class... Args>
+		static list_node* create_node(Args&&... args) {
+			return construct_node(list_node_allocator::allocate(), std::forward<Args>(args)...);
+		}
+		template <class... Args>
+		static list_node* construct_node(list_node* node, Args&&... args) {
+			try {
+				construct(&node->data, std::forward<Args>(args)...);
 				node->next = nullptr;
 			}
-			__STL_UNWIND(list_node_allocator::deallocate(node));
+			catch (...) {
+				list_node_allocator::deallocate(node);
+				throw;
+			}
 			return node;
 		}
 
 		static void destroy_node(list_node* node) {
-			destroy(&node->data);
+			STL::destroy(&node->data);
 			list_node_allocator::deallocate(node);
 		}
 
+		// Appends [first, last) after the last node, taking the nodes from
+		// a batch; on a throw the nodes already linked are released.
+		template <class InputIterator>
+		void range_initialize(InputIterator first, InputIterator last) {
+			head.next = nullptr;
+			__node_batch<list_node, Alloc> nodes;
+			list_node_base* tail = &head;
+			try {
+				for (; first != last; ++first)
+					tail = __slist_make_link(tail, construct_node(nodes.get(), *first));
+			}
+			catch (...) {
+				clear();
+				throw;
+			}
+		}
+
 	private:
 		list_node_base head;
 
 	public:
 		slist() { head.next = nullptr; }
+		template <class InputIterator>
+		slist(InputIterator first, InputIterator last) { range_initialize(first, last); }
+		slist(const slist& x) { range_initialize(x.begin(), x.end()); }
+		slist(slist&& x) noexcept {
+			head.next = x.head.next;
+			x.head.next = nullptr;
+		}
+		slist& operator=(slist x) noexcept {
+			swap(x);
+			return *this;
+		}
 		~slist() { clear(); }
 
 	public:
 		iterator begin() { return iterator((list_node*)head.next); }
 		iterator end() { return iterator(nullptr); }
+		const_iterator begin() const { return const_iterator((list_node*)head.next); }
+		const_iterator end() const { return const_iterator(nullptr); }
 		size_type size() const noexcept { return __slist_size(head.next); }
 		bool empty() const noexcept { return head.next == nullptr; }
 
@@ -63,15 +101,34 @@ namespace STL {
 
 	public:
 		reference front() { return ((list_node*)head.next)->data; }
+		const_reference front() const { return ((list_node*)head.next)->data; }
 
 		void push_front(const value_type& x) {
 			__slist_make_link(&head, create_node(x));
 		}
+		void push_front(value_type&& x) {
+			__slist_make_link(&head, create_node(std::move(x)));
+		}
+		template <class... Args>
+		reference emplace_front(Args&&... args) {
+			__slist_make_link(&head, create_node(std::forward<Args>(args)...));
+			return front();
+		}
 
 		void pop_front() {
 			list_node* node = (list_node*)head.next;
 			head.next = node->next;
 			destroy_node(node);
 		}
+
+		void clear() {
+			list_node* node = (list_node*)head.next;
+			while (node != nullptr) {
+				list_node* next = (list_node*)node->next;
+				destroy_node(node);
+				node = next;
+			}
+			head.next = nullptr;
+		}
 	};
 }
@@ -28,9 +28,9 @@ namespace STL {
 
 	template <class T, class Ref, class Ptr>
 	struct __slist_iterator : public __slist_iterator_base {
-		using iterator = __slist_iterator_base<T, T&, T*>;
-		using const_iterator = __slist_iterator_base<T, const T&, const T*>;
-		using self = __slist_iterator_base<T, Ref, Ptr>;
+		using iterator = __slist_iterator<T, T&, T*>;
+		using const_iterator = __slist_iterator<T, const T&, const T*>;
+		using self = __slist_iterator<T, Ref, Ptr>;
 
 		using value_type = T;
 		using pointer = Ptr;
@@ -40,9 +40,10 @@ namespace STL {
 		__slist_iterator(list_node* x) : __slist_iterator_base(x) { }
 		__slist_iterator() : __slist_iterator_base(nullptr) { }
 		__slist_iterator(const iterator& x) : __slist_iterator_base(x.node) { }
+		self& operator=(const self&) = default;
 
 		reference operator*() const { return ((list_node*)node)->data; }
-		reference operator->() const { return &(operator*()); }
+		pointer operator->() const { return &(operator*()); }
 
 		self& operator++() {
 			incr();
@@ -0,0 +1,385 @@
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <utility>
+#include "allocator.h"
+#include "uninitialized.h"
+
+namespace STL {
+
+	// A vector whose first N elements live inside the object itself; the
+	// allocator is only called once the size outgrows N. Iterators and
+	// references are invalidated by growth and by swap/move, even while
+	// the elements are still inline.
+	template <class T, size_t N, class Alloc = alloc>
+	class small_vector {
+
+		static_assert(N > 0, "small_vector needs an inline capacity of at least one element");
+
+	public:
+		using value_type = T;
+		using pointer = value_type *;
+		using iterator = value_type *;
+		using reference = value_type &;
+		using const_reference = const value_type &;
+		using size_type = size_t;
+		using difference_type = ptrdiff_t;
+
+	private:
+		iterator start;
+		iterator finish;
+		iterator end_of_storage;
+		alignas(T) unsigned char buffer[N * sizeof(T)];
+
+	private:
+		using data_allocator = simpleAlloc<value_type, Alloc>;
+		using is_POD = typename __type_traits<T>::is_POD_type;
+		using is_relocatable = typename __is_trivially_relocatable<T>::type;
+
+		iterator inline_start() noexcept { return reinterpret_cast<iterator>(buffer); }
+		void reset() noexcept {
+			start = finish = inline_start();
+			end_of_storage = start + N;
+		}
+		// Gives back the heap block, if any; the elements must be gone already.
+		void deallocate() {
+			if (!is_inline()) data_allocator::deallocate(start, end_of_storage - start);
+		}
+		size_type next_capacity(size_type n) const noexcept {
+			const size_type old_capacity = capacity();
+			return old_capacity + (old_capacity > n ? old_capacity : n);
+		}
+		// Takes over rhs's elements; *this must be empty and inline. rhs is
+		// left empty and inline.
+		void steal(small_vector& rhs) {
+			if (rhs.is_inline())
+				finish = STL::uninitialized_relocate(rhs.start, rhs.finish, start);
+			else {
+				start = rhs.start;
+				finish = rhs.finish;
+				end_of_storage = rhs.end_of_storage;
+			}
+			rhs.reset();
+		}
+
+		template <class... Args>
+		void insert_aux(iterator position, Args&&... args);
+		template <class... Args>
+		void relocate_aux(iterator position, size_type len, __true_type, Args&&... args);
+		template <class... Args>
+		void relocate_aux(iterator position, size_type len, __false_type, Args&&... args);
+		void fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __true_type);
+		void fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __false_type);
+		void reserve(size_type new_capacity, __true_type);
+		void reserve(size_type new_capacity, __false_type);
+		void relocate_around(iterator new_start, size_type len, iterator position, size_type n) {
+			iterator new_finish = STL::uninitialized_relocate(start, position, new_start) + n;
+			new_finish = STL::uninitialized_relocate(position, finish, new_finish);
+			deallocate();
+			start = new_start;
+			finish = new_finish;
+			end_of_storage = new_start + len;
+		}
+		void fill_initialize(size_type n, const T& value) {
+			reserve(n);
+			finish = STL::uninitialized_fill_n(start, n, value);
+		}
+		void default_initialize(size_type n) {
+			reserve(n);
+			finish = STL::uninitialized_default_init_n(start, n);
+		}
+
+	public:
+		iterator begin() noexcept { return start; }
+		iterator end() noexcept { return finish; }
+		size_type size() const noexcept { return static_cast<size_type>(finish - start); }
+		size_type capacity() const noexcept { return static_cast<size_type>(end_of_storage - start); }
+		static constexpr size_type inline_capacity() noexcept { return N; }
+		bool is_inline() const noexcept { return start == reinterpret_cast<const value_type*>(buffer); }
+		bool empty() const noexcept { return start == finish; }
+		reference operator[](size_type n) { return *(start + n); }
+		const_reference operator[](size_type n) const { return *(start + n); }
+		reference front() noexcept { return *start; }
+		reference back() noexcept { return *(finish - 1); }
+		const_reference front() const noexcept { return *start; }
+		const_reference back() const noexcept { return *(finish - 1); }
+
+	public:
+		// Not noexcept: inline elements are moved one by one.
+		void swap(small_vector&);
+
+	public:
+		small_vector() { reset(); }
+		small_vector(size_type n, const T& value) { reset(); fill_initialize(n, value); }
+		small_vector(int n, const T& value) { reset(); fill_initialize(n, value); }
+		small_vector(long n, const T& value) { reset(); fill_initialize(n, value); }
+		explicit small_vector(size_type n) { reset(); fill_initialize(n, T()); }
+		// For buffers about to be overwritten: trivial T is left uninitialized.
+		small_vector(size_type n, default_init_t) { reset(); default_initialize(n); }
+		small_vector(const small_vector& rhs) {
+			reset();
+			reserve(rhs.size());
+			finish = STL::uninitialized_copy(rhs.start, rhs.finish, start);
+		}
+		small_vector(small_vector&& rhs) {
+			reset();
+			steal(rhs);
+		}
+		small_vector& operator=(const small_vector& rhs) {
+			if (this != &rhs) {
+				small_vector tmp(rhs);
+				*this = std::move(tmp);
+			}
+			return *this;
+		}
+		small_vector& operator=(small_vector&& rhs) {
+			if (this != &rhs) {
+				destroy(start, finish);
+				deallocate();
+				reset();
+				steal(rhs);
+			}
+			return *this;
+		}
+
+		~small_vector() {
+			destroy(start, finish);
+			deallocate();
+		}
+
+		void push_back(const T& x) { emplace_back(x); }
+		void push_back(T&& x) { emplace_back(std::move(x)); }
+
+		template <class... Args>
+		reference emplace_back(Args&&... args) {
+			if (finish != end_of_storage) {
+				construct(finish, std::forward<Args>(args)...);
+				++finish;
+			}
+			else
+				insert_aux(finish, std::forward<Args>(args)...);
+			return *(finish - 1);
+		}
+
+		template <class... Args>
+		iterator emplace(iterator position, Args&&... args) {
+			const size_type elems_before = position - start;
+			insert_aux(position, std::forward<Args>(args)...);
+			return start + elems_before;
+		}
+		iterator insert(iterator position, const T& x) { return emplace(position, x); }
+		iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+		void insert(iterator position, size_type n, const T& x);
+
+		void pop_back() {
+			--finish;
+			destroy(finish);
+		}
+
+		iterator erase(iterator position) { return erase(position, position + 1); }
+		iterator erase(iterator first, iterator last) {
+			if (first != last) {
+				iterator new_finish = first;
+				for (iterator p = last; p != finish; ++p, ++new_finish)
+					*new_finish = std::move(*p);
+				destroy(new_finish, finish);
+				finish = new_finish;
+			}
+			return first;
+		}
+		void resize(size_type new_size, const T& x) {
+			if (new_size < size())
+				erase(start + new_size, finish);
+			else
+				insert(finish, new_size - size(), x);
+		}
+		void resize(size_type new_size) { resize(new_size, T()); }
+		void reserve(size_type);
+		void clear() { erase(start, finish); }
+	};
+
+	template <class T, size_t N, class Alloc>
+	void small_vector<T, N, Alloc>::swap(small_vector& rhs) {
+		if (this == &rhs)
+			return;
+		if (!is_inline() && !rhs.is_inline()) {
+			STL::swap(start, rhs.start);
+			STL::swap(finish, rhs.finish);
+			STL::swap(end_of_storage, rhs.end_of_storage);
+			return;
+		}
+		small_vector tmp(std::move(rhs));
+		rhs.steal(*this);
+		steal(tmp);
+	}
+
+	template <class T, size_t N, class Alloc>
+	inline void small_vector<T, N, Alloc>::reserve(size_type new_capacity) {
+		if (new_capacity <= capacity()) return;
+		reserve(new_capacity, is_POD());
+	}
+
+	// POD elements already on the heap: let the allocator grow the block,
+	// in place when it can.
+	template <class T, size_t N, class Alloc>
+	void small_vector<T, N, Alloc>::reserve(size_type new_capacity, __true_type) {
+		if (is_inline()) {
+			reserve(new_capacity, __false_type());
+			return;
+		}
+		const size_type n = size();
+		start = data_allocator::reallocate(start, capacity(), new_capacity);
+		finish = start + n;
+		end_of_storage = start + new_capacity;
+	}
+
+	template <class T, size_t N, class Alloc>
+	void small_vector<T, N, Alloc>::reserve(size_type new_capacity, __false_type) {
+		T* new_start = data_allocator::allocate(new_capacity);
+		T* new_finish;
+		try {
+			new_finish = STL::uninitialized_relocate(start, finish, new_start);
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, new_capacity);
+			throw;
+		}
+		deallocate();
+		start = new_start;
+		finish = new_finish;
+		end_of_storage = start + new_capacity;
+	}
+
+	template <class T, size_t N, class Alloc>
+	template <class... Args>
+	void small_vector<T, N, Alloc>::insert_aux(iterator position, Args&&... args) {
+		if (finish != end_of_storage) {
+			if (position == finish) {
+				construct(finish, std::forward<Args>(args)...);
+				++finish;
+				return;
+			}
+			T x_copy(std::forward<Args>(args)...);
+			construct(finish, std::move(*(finish - 1)));
+			++finish;
+			for (iterator p = finish - 2; p != position; --p)
+				*p = std::move(*(p - 1));
+			*position = std::move(x_copy);
+		}
+		else
+			relocate_aux(position, next_capacity(1), is_relocatable(), std::forward<Args>(args)...);
+	}
+
+	// The new element is built first: its arguments may refer into the old
+	// storage, and once it is in place the memcpy relocation cannot fail.
+	template <class T, size_t N, class Alloc>
+	template <class... Args>
+	void small_vector<T, N, Alloc>::relocate_aux(iterator position, size_type len, __true_type, Args&&... args) {
+		iterator new_start = data_allocator::allocate(len);
+		try {
+			construct(new_start + (position - start), std::forward<Args>(args)...);
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+		relocate_around(new_start, len, position, 1);
+	}
+
+	template <class T, size_t N, class Alloc>
+	template <class... Args>
+	void small_vector<T, N, Alloc>::relocate_aux(iterator position, size_type len, __false_type, Args&&... args) {
+		iterator new_start = data_allocator::allocate(len);
+		iterator new_position = new_start + (position - start);
+		iterator new_finish = new_start;
+		bool built = false;
+		try {
+			construct(new_position, std::forward<Args>(args)...);
+			built = true;
+			new_finish = STL::__uninitialized_move_if_noexcept(start, position, new_start);
+			new_finish = STL::__uninitialized_move_if_noexcept(position, finish, new_position + 1);
+		}
+		catch (...) {
+			if (built)
+				destroy(new_position);
+			destroy(new_start, new_finish);
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+
+		destroy(start, finish);
+		deallocate();
+
+		start = new_start;
+		finish = new_finish;
+		end_of_storage = new_start + len;
+	}
+
+	template <class T, size_t N, class Alloc>
+	void small_vector<T, N, Alloc>::insert(iterator position, size_type n, const T& x) {
+		if (n == 0)
+			return;
+		if (size_type(end_of_storage - finish) >= n) {
+			T x_copy = x;
+			const size_type elems_after = finish - position;
+			iterator old_finish = finish;
+			if (elems_after > n) {
+				finish = STL::__uninitialized_move_if_noexcept(finish - n, finish, finish);
+				for (iterator p = old_finish - n; p != position; )
+					--p, *(p + n) = std::move(*p);
+				for (iterator p = position; p != position + n; ++p)
+					*p = x_copy;
+			}
+			else {
+				finish = STL::uninitialized_fill_n(finish, n - elems_after, x_copy);
+				finish = STL::__uninitialized_move_if_noexcept(position, old_finish, finish);
+				for (iterator p = position; p != old_finish; ++p)
+					*p = x_copy;
+			}
+		}
+		else
+			fill_insert_aux(position, n, x, next_capacity(n), is_relocatable());
+	}
+
+	template <class T, size_t N, class Alloc>
+	void small_vector<T, N, Alloc>::fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __true_type) {
+		iterator new_start = data_allocator::allocate(len);
+		try {
+			STL::uninitialized_fill_n(new_start + (position - start), n, x);
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+		relocate_around(new_start, len, position, n);
+	}
+
+	template <class T, size_t N, class Alloc>
+	void small_vector<T, N, Alloc>::fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __false_type) {
+		iterator new_start = data_allocator::allocate(len);
+		iterator new_position = new_start + (position - start);
+		iterator new_finish = new_start;
+		bool filled = false;
+		try {
+			STL::uninitialized_fill_n(new_position, n, x);
+			filled = true;
+			new_finish = STL::__uninitialized_move_if_noexcept(start, position, new_start);
+			new_finish = STL::__uninitialized_move_if_noexcept(position, finish, new_position + n);
+		}
+		catch (...) {
+			if (filled)
+				destroy(new_position, new_position + n);
+			destroy(new_start, new_finish);
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+
+		destroy(start, finish);
+		deallocate();
+
+		start = new_start;
+		finish = new_finish;
+		end_of_storage = new_start + len;
+	}
+}
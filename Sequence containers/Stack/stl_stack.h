@@ -1,5 +1,6 @@
 #pragma once
 
+#include <utility>
 #include "stl_deque.h"
 
 namespace STL {
@@ -24,6 +25,9 @@ namespace STL {
 		size_type size() const noexcept { return c.size(); }
 		const_reference top() const noexcept { return c.back(); }
 		void push(const value_type& x) { c.push_back(x); }
+		void push(value_type&& x) { c.push_back(std::move(x)); }
+		template <class... Args>
+		void emplace(Args&&... args) { c.emplace_back(std::forward<Args>(args)...); }
 		void pop() { c.pop_back(); }
 	};
 
@@ -1,18 +1,24 @@
 #pragma once
  
 #include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include <utility>
 #include "allocator.h"
 #include "uninitialized.h"
+#include "parallel_uninitialized.h"
+#include "vector_growth.h"
 
 namespace STL {
 
-	template <class T, class Alloc = simpleAlloc<T> >
+	template <class T, class Alloc = alloc, class Growth = __default_growth>
 	class vector {
 
 	public:
 		using value_type = T;
 		using pointer = value_type *;
 		using iterator = value_type *;
+		using const_iterator = const value_type *;
 		using reference = value_type &;
 		using const_reference = const value_type &;
 		using size_type = size_t;
@@ -24,21 +30,90 @@ namespace STL {
 		iterator end_of_storage;
 
 	private:
-		using data_allocator = Alloc;
+		using data_allocator = simpleAlloc<value_type, Alloc>;
+		using is_POD = typename __type_traits<T>::is_POD_type;
+		using is_relocatable = typename __is_trivially_relocatable<T>::type;
 
-		void insert_aux(iterator position, const T& x);
+		template <class... Args>
+		void insert_aux(iterator position, Args&&... args);
+		template <class... Args>
+		void grow_insert(iterator position, size_type len, __true_type, Args&&... args);
+		template <class... Args>
+		void grow_insert(iterator position, size_type len, __false_type, Args&&... args);
+		template <class... Args>
+		void relocate_aux(iterator position, size_type len, __true_type, Args&&... args);
+		template <class... Args>
+		void relocate_aux(iterator position, size_type len, __false_type, Args&&... args);
+		void fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __true_type);
+		void fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __false_type);
+		template <class Integer>
+		void insert_dispatch(iterator position, Integer n, Integer x, __true_type) { insert(position, size_type(n), T(x)); }
+		template <class InputIterator>
+		void insert_dispatch(iterator position, InputIterator first, InputIterator last, __false_type) {
+			range_insert(position, first, last, iterator_category(first));
+		}
+		template <class InputIterator>
+		void range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag);
+		template <class ForwardIterator>
+		void range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+		template <class ForwardIterator>
+		void range_insert_in_place(iterator position, ForwardIterator first, ForwardIterator last, size_type n, __true_type);
+		template <class ForwardIterator>
+		void range_insert_in_place(iterator position, ForwardIterator first, ForwardIterator last, size_type n, __false_type);
+		template <class ForwardIterator>
+		void range_insert_aux(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __true_type);
+		template <class ForwardIterator>
+		void range_insert_aux(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __false_type);
+		template <class Integer>
+		void assign_dispatch(Integer n, Integer x, __true_type) { fill_assign(size_type(n), T(x)); }
+		template <class InputIterator>
+		void assign_dispatch(InputIterator first, InputIterator last, __false_type) {
+			range_assign(first, last, iterator_category(first));
+		}
+		template <class InputIterator>
+		void range_assign(InputIterator first, InputIterator last, input_iterator_tag);
+		template <class ForwardIterator>
+		void range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag);
+		void fill_assign(size_type n, const T& x);
+		void erase_at_end(iterator position) {
+			STL::destroy(position, finish);
+			finish = position;
+		}
+		void reserve(size_type new_capacity, __true_type);
+		void reserve(size_type new_capacity, __false_type);
+		// Moves the elements into new_start, leaving a hole of n at position.
+		void relocate_around(iterator new_start, size_type len, iterator position, size_type n) {
+			iterator new_finish = STL::uninitialized_relocate(start, position, new_start) + n;
+			new_finish = STL::uninitialized_relocate(position, finish, new_finish);
+			deallocate();
+			start = new_start;
+			finish = new_finish;
+			end_of_storage = new_start + len;
+		}
+		// POD elements: let the allocator grow the block, in place when it can.
+		void expand(size_type len) {
+			const size_type n = size();
+			start = data_allocator::reallocate(start, capacity(), len);
+			finish = start + n;
+			end_of_storage = start + len;
+		}
 		void deallocate() {
 			if (start) data_allocator::deallocate(start, end_of_storage - start);
 		}
-		void fill_initialize(size_type n, const T& value) {
-			start = allocate_and_fill(n, value);
-			finish = start + n;
-			end_of_storage = finish;
+		size_type next_capacity(size_type required) const {
+			return Growth::next(capacity(), required, sizeof(T));
 		}
-
+		// Large buffers are filled by the worker pool, which also spreads
+		// their first touch across the workers' NUMA nodes.
 		iterator allocate_and_fill(size_type n, const T & value) {
 			iterator result = data_allocator::allocate(n);
-			STL::unintialized_fill_n(result, n, value)
+			try {
+				STL::parallel_uninitialized_fill_n(result, n, value);
+			}
+			catch (...) {
+				data_allocator::deallocate(result, n);
+				throw;
+			}
 			return result;
 		}
 
@@ -47,6 +122,18 @@ namespace STL {
 			finish = start + n;
 			end_of_storage = finish;
 		}
+		void default_initialize(size_type n) {
+			start = data_allocator::allocate(n);
+			try {
+				STL::uninitialized_default_init_n(start, n);
+			}
+			catch (...) {
+				data_allocator::deallocate(start, n);
+				throw;
+			}
+			finish = start + n;
+			end_of_storage = finish;
+		}
 
 	public:
 		const_reference front() const noexcept { return *begin(); }
@@ -54,10 +141,17 @@ namespace STL {
 	public:
 		iterator begin() noexcept { return start; }
 		iterator end() noexcept { return finish;  }
-		size_type size() { return return(finish - start); }
+		const_iterator begin() const noexcept { return start; }
+		const_iterator end() const noexcept { return finish; }
+		size_type size() const noexcept { return static_cast<size_type>(finish - start); }
 		size_type capacity() const noexcept { return static_cast<size_type>(end_of_storage - start); }
 		bool empty() const noexcept { return start == finish; }
+		memory_usage memory_report() const noexcept {
+			memory_usage usage = { size() * sizeof(T), capacity() * sizeof(T) };
+			return usage;
+		}
 		reference operator[](size_type n) { return *(start + n); }
+		const_reference operator[](size_type n) const { return *(start + n); }
 
 	public:
 		void swap(vector&) noexcept;
@@ -68,142 +162,473 @@ namespace STL {
 		vector(int n, const T& value) { fill_initialize(n, value); }
 		vector(long n, const T& value) { fill_initialize(n, value); }
 		explicit vector(size_type n) { fill_initialize(n, T()); }
+		// For buffers about to be overwritten: trivial T is left uninitialized.
+		vector(size_type n, default_init_t) { default_initialize(n); }
+		vector(const vector& rhs) : start(nullptr), finish(nullptr), end_of_storage(nullptr) {
+			if (rhs.start == rhs.finish)
+				return;
+			start = data_allocator::allocate(rhs.size());
+			try {
+				finish = STL::uninitialized_copy(rhs.start, rhs.finish, start);
+			}
+			catch (...) {
+				data_allocator::deallocate(start, rhs.size());
+				throw;
+			}
+			end_of_storage = finish;
+		}
+		vector(vector&& rhs) noexcept : start(rhs.start), finish(rhs.finish), end_of_storage(rhs.end_of_storage) {
+			rhs.start = rhs.finish = rhs.end_of_storage = nullptr;
+		}
+		vector& operator=(const vector& rhs) {
+			if (this != &rhs) {
+				vector tmp(rhs);
+				swap(tmp);
+			}
+			return *this;
+		}
+		vector& operator=(vector&& rhs) noexcept {
+			if (this != &rhs) {
+				vector tmp(std::move(rhs));
+				swap(tmp);
+			}
+			return *this;
+		}
 
 		~vector() {
-			destroy(start, finish);
+			STL::parallel_destroy(start, finish);
 			deallocate();
 		}
 		reference front() noexcept { return *start; }
-		reference back() noexcept { return *finish; }
-		void push_back(const T& x) {
+		reference back() noexcept { return *(finish - 1); }
+		void push_back(const T& x) { emplace_back(x); }
+		void push_back(T&& x) { emplace_back(std::move(x)); }
+
+		template <class... Args>
+		reference emplace_back(Args&&... args) {
 			if (finish != end_of_storage) {
-				construct(finish, x);
+				construct(finish, std::forward<Args>(args)...);
 				++finish;
 			}
 			else
-				insert_aux(finish, x);
+				insert_aux(finish, std::forward<Args>(args)...);
+			return *(finish - 1);
 		}
 
+		template <class... Args>
+		iterator emplace(iterator position, Args&&... args) {
+			const size_type elems_before = position - start;
+			insert_aux(position, std::forward<Args>(args)...);
+			return start + elems_before;
+		}
+		iterator insert(iterator position, const T& x) { return emplace(position, x); }
+		iterator insert(iterator position, T&& x) { return emplace(position, std::move(x)); }
+
 		void pop_back() {
 			--finish;
-			destroy(finish);
+			STL::destroy(finish);
 		}
 
 		iterator erase(iterator position) {
 			if (position + 1 != finish)
-				copy(position + 1, finish, position);
+				STL::copy(position + 1, finish, position);
 			--finish;
-			destroy(finish);
+			STL::destroy(finish);
 			return position;
 		}
 		void resize(size_type new_size, const T& x) {
 			if (new_size < size())
-				erase(start + new_size, finish);
+				erase_at_end(start + new_size);
 			else
-				insert(finish, new_size - finish, x);
+				insert(finish, new_size - size(), x);
 		}
 		void resize(size_type new_size) { return resize(new_size, T()); }
+		void resize_default_init(size_type new_size);
 		void reserve(size_type);
-		void clear() { erase(start, finish); }
+		// Non-binding in the standard; here the block is always cut to size.
+		void shrink_to_fit();
+		void clear() { erase_at_end(start); }
 		void insert(iterator position, size_type n, const T& x) {
 			if (n != 0) {
-				if (size_type(end_of_storage - finish >= n)) {
+				if (size_type(end_of_storage - finish) >= n) {
 					T x_copy = x;
 					const size_type elems_after = finish - position;
 					iterator old_finish = finish;
 					if (elems_after > n) {
-						uninitialized_copy(finish - n, finish, finish);
+						STL::uninitialized_copy(finish - n, finish, finish);
 						finish += n;
-						copy_backward(position, old_finish - n, old_finish);
-						fill(position, position + n, x_copy);
+						STL::copy_backward(position, old_finish - n, old_finish);
+						STL::fill(position, position + n, x_copy);
 					}
 					else {
-						uninitialized_fill_n(finish, n - elems_after, x_copy);
+						STL::uninitialized_fill_n(finish, n - elems_after, x_copy);
 						finish += n - elems_after;
-						uninitialized_copy(position, old_finish, finish);
+						STL::uninitialized_copy(position, old_finish, finish);
 						finish += elems_after;
-						fill(position, old_finish, x_copy);
+						STL::fill(position, old_finish, x_copy);
 					}
 				}
 				else {
 					const size_type old_size = size();
-					const size_type len = old_size + max(old_size, n);
-					iterator new_start = data_allocator::allocate(len);
-					iterator new_finish = new_start;
-					__STL_TRY{
-						new_finish = uninitialized_copy(start, position, new_start);
-						new_finish = uninitialized_fill_n(new_finish, n);
-						new_finish = uninitialized_copy(position, finish, new_finish);
-					}
-				# ifdef __STL_USE_EXCEPTIONS
-					catch (...) {
-						destroy(new_start, new_finish);
-						data_allocator::deallocate(new_start, len);
-						throw;
-					}
-				# endif /* __STL_USE_EXCEPTIONS */
-					destroy(start, finish);
-					deallocate();
-					start = new_start;
-					finish = new_finish;
-					end_of_storage = new_start + len;
+					const size_type len = next_capacity(old_size + n);
+					fill_insert_aux(position, n, x, len, is_relocatable());
 				}
 			}
 		}
+
+		// Forward ranges are measured first, so the vector reallocates at
+		// most once; single-pass input ranges go element by element. The
+		// range must not point into *this.
+		template <class InputIterator>
+		void insert(iterator position, InputIterator first, InputIterator last) {
+			using is_integer = typename __bool_type<std::is_integral<InputIterator>::value>::type;
+			insert_dispatch(position, first, last, is_integer());
+		}
+		template <class InputIterator>
+		void append(InputIterator first, InputIterator last) { insert(finish, first, last); }
+		void assign(size_type n, const T& x) { fill_assign(n, x); }
+		template <class InputIterator>
+		void assign(InputIterator first, InputIterator last) {
+			using is_integer = typename __bool_type<std::is_integral<InputIterator>::value>::type;
+			assign_dispatch(first, last, is_integer());
+		}
 	};
-	template <class T, class Alloc>
-	inline void vector<T, Alloc>::swap(vector& rhs) noexcept {
+	template <class T, class Alloc, class Growth>
+	inline void vector<T, Alloc, Growth>::swap(vector& rhs) noexcept {
 		STL::swap(start, rhs.start);
 		STL::swap(finish, rhs.finish);
 		STL::swap(end_of_storage, rhs.end_of_storage);
 	}
 
-	template <class T, class Alloc>
-	inline void vector<T, Alloc>::reserve(size_type new_capacity) {
+	template <class T, class Alloc, class Growth>
+	void vector<T, Alloc, Growth>::resize_default_init(size_type new_size) {
+		const size_type old_size = size();
+		if (new_size <= old_size) {
+			STL::destroy(start + new_size, finish);
+			finish = start + new_size;
+			return;
+		}
+		if (new_size > capacity())
+			reserve(next_capacity(new_size));
+		finish = STL::uninitialized_default_init_n(finish, new_size - old_size);
+	}
+
+	template <class T, class Alloc, class Growth>
+	inline void vector<T, Alloc, Growth>::reserve(size_type new_capacity) {
 		if (new_capacity <= capacity()) return;
+		reserve(new_capacity, is_POD());
+	}
+
+	template <class T, class Alloc, class Growth>
+	void vector<T, Alloc, Growth>::shrink_to_fit() {
+		if (finish == end_of_storage)
+			return;
+		if (start == finish) {
+			deallocate();
+			start = finish = end_of_storage = nullptr;
+			return;
+		}
+		reserve(size(), is_POD());
+	}
+
+	template <class T, class Alloc, class Growth>
+	inline void vector<T, Alloc, Growth>::reserve(size_type new_capacity, __true_type) {
+		expand(new_capacity);
+	}
+
+	template <class T, class Alloc, class Growth>
+	void vector<T, Alloc, Growth>::reserve(size_type new_capacity, __false_type) {
 		T* new_start = data_allocator::allocate(new_capacity);
-		T* new_finish = STL::uninitialized_copy(start, finish, new_start);
-		destroy(start, finish);
+		T* new_finish;
+		try {
+			new_finish = STL::uninitialized_relocate(start, finish, new_start);
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, new_capacity);
+			throw;
+		}
 		deallocate();
 		start = new_start;
 		finish = new_finish;
 		end_of_storage = start + new_capacity;
-
 	}
 	
-	template <class T, class Alloc>
-	void vector<T, Alloc>::insert_aux(iterator position, const T& x) {
+	template <class T, class Alloc, class Growth>
+	template <class... Args>
+	void vector<T, Alloc, Growth>::insert_aux(iterator position, Args&&... args) {
 		if (finish != end_of_storage) {
-			construct(finish, *(finish - 1))
+			if (position == finish) {
+				construct(finish, std::forward<Args>(args)...);
+				++finish;
+				return;
+			}
+			T x_copy(std::forward<Args>(args)...);
+			construct(finish, std::move(*(finish - 1)));
 			++finish;
-			T x_copy = x;
-			STL::copy_backward(position, finish - 2, finish - 1);
-			*position = x_copy;
+			for (iterator p = finish - 2; p != position; --p)
+				*p = std::move(*(p - 1));
+			*position = std::move(x_copy);
 		}
 		else {
 			const size_type old_size = size();
-			const size_type len = old_size != 0 ? old_size * 2 : 1;
+			const size_type len = next_capacity(old_size + 1);
+			grow_insert(position, len, is_POD(), std::forward<Args>(args)...);
+		}
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class... Args>
+	void vector<T, Alloc, Growth>::grow_insert(iterator position, size_type len, __true_type, Args&&... args) {
+		const T x_copy(std::forward<Args>(args)...);
+		const size_type elems_before = position - start;
+		expand(len);
+		position = start + elems_before;
+		memmove(position + 1, position, (finish - position) * sizeof(T));
+		*position = x_copy;
+		++finish;
+	}
 
-			iterator new_start = data_allocator::allocate(len);
-			iterator new_finish = new_start;
+	template <class T, class Alloc, class Growth>
+	template <class... Args>
+	inline void vector<T, Alloc, Growth>::grow_insert(iterator position, size_type len, __false_type, Args&&... args) {
+		relocate_aux(position, len, is_relocatable(), std::forward<Args>(args)...);
+	}
+
+	// The new element is built first: its arguments may refer into the old
+	// storage, and once it is in place the memcpy relocation cannot fail.
+	template <class T, class Alloc, class Growth>
+	template <class... Args>
+	void vector<T, Alloc, Growth>::relocate_aux(iterator position, size_type len, __true_type, Args&&... args) {
+		iterator new_start = data_allocator::allocate(len);
+		try {
+			construct(new_start + (position - start), std::forward<Args>(args)...);
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+		relocate_around(new_start, len, position, 1);
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class... Args>
+	void vector<T, Alloc, Growth>::relocate_aux(iterator position, size_type len, __false_type, Args&&... args) {
+		iterator new_start = data_allocator::allocate(len);
+		iterator new_position = new_start + (position - start);
+		iterator new_finish = new_start;
+		bool built = false;
+		try {
+			construct(new_position, std::forward<Args>(args)...);
+			built = true;
+			new_finish = STL::__uninitialized_move_if_noexcept(start, position, new_start);
+			new_finish = STL::__uninitialized_move_if_noexcept(position, finish, new_position + 1);
+		}
+		catch (...) {
+			if (built)
+				STL::destroy(new_position);
+			STL::destroy(new_start, new_finish);
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+
+		STL::destroy(start, finish);
+		deallocate();
+
+		start = new_start;
+		finish = new_finish;
+		end_of_storage = new_start + len;
+	}
+
+	template <class T, class Alloc, class Growth>
+	void vector<T, Alloc, Growth>::fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __true_type) {
+		iterator new_start = data_allocator::allocate(len);
+		try {
+			STL::uninitialized_fill_n(new_start + (position - start), n, x);
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+		relocate_around(new_start, len, position, n);
+	}
+
+	template <class T, class Alloc, class Growth>
+	void vector<T, Alloc, Growth>::fill_insert_aux(iterator position, size_type n, const T& x, size_type len, __false_type) {
+		iterator new_start = data_allocator::allocate(len);
+		iterator new_finish = new_start;
+		try {
+			new_finish = STL::uninitialized_copy(start, position, new_start);
+			new_finish = STL::uninitialized_fill_n(new_finish, n, x);
+			new_finish = STL::uninitialized_copy(position, finish, new_finish);
+		}
+		catch (...) {
+			STL::destroy(new_start, new_finish);
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+
+		STL::destroy(start, finish);
+		deallocate();
+
+		start = new_start;
+		finish = new_finish;
+		end_of_storage = new_start + len;
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class InputIterator>
+	void vector<T, Alloc, Growth>::range_insert(iterator position, InputIterator first, InputIterator last, input_iterator_tag) {
+		for (; first != last; ++first, ++position)
+			position = insert(position, *first);
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class ForwardIterator>
+	void vector<T, Alloc, Growth>::range_insert(iterator position, ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+		const size_type n = static_cast<size_type>(STL::distance(first, last));
+		if (n == 0)
+			return;
+		if (size_type(end_of_storage - finish) >= n)
+			range_insert_in_place(position, first, last, n, is_POD());
+		else
+			range_insert_aux(position, first, last, n, next_capacity(size() + n), is_relocatable());
+	}
+
+	// POD: open the gap with one memmove and copy the range into it.
+	template <class T, class Alloc, class Growth>
+	template <class ForwardIterator>
+	void vector<T, Alloc, Growth>::range_insert_in_place(iterator position, ForwardIterator first, ForwardIterator last, size_type n, __true_type) {
+		// Appending has no tail to move. The null test only spells out for GCC
+		// that a vector with room has a block; it warns with -Wnonnull otherwise.
+		const size_type elems_after = finish - position;
+		if (elems_after != 0 && position != nullptr)
+			memmove(position + n, position, elems_after * sizeof(T));
+		STL::copy(first, last, position);
+		finish += n;
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class ForwardIterator>
+	void vector<T, Alloc, Growth>::range_insert_in_place(iterator position, ForwardIterator first, ForwardIterator last, size_type n, __false_type) {
+		const size_type elems_after = finish - position;
+		iterator old_finish = finish;
+		if (elems_after > n) {
+			finish = STL::__uninitialized_move_if_noexcept(finish - n, finish, finish);
+			for (iterator p = old_finish - n; p != position; ) {
+				--p;
+				*(p + n) = std::move(*p);
+			}
+			STL::copy(first, last, position);
+		}
+		else {
+			ForwardIterator mid = first;
+			STL::advance(mid, elems_after);
+			finish = STL::uninitialized_copy(mid, last, finish);
+			finish = STL::__uninitialized_move_if_noexcept(position, old_finish, finish);
+			STL::copy(first, mid, position);
+		}
+	}
+
+	// The range is copied into the new block first; relocating the old
+	// elements around it then cannot fail.
+	template <class T, class Alloc, class Growth>
+	template <class ForwardIterator>
+	void vector<T, Alloc, Growth>::range_insert_aux(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __true_type) {
+		iterator new_start = data_allocator::allocate(len);
+		try {
+			STL::uninitialized_copy(first, last, new_start + (position - start));
+		}
+		catch (...) {
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+		relocate_around(new_start, len, position, n);
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class ForwardIterator>
+	void vector<T, Alloc, Growth>::range_insert_aux(iterator position, ForwardIterator first, ForwardIterator last, size_type n, size_type len, __false_type) {
+		iterator new_start = data_allocator::allocate(len);
+		iterator new_position = new_start + (position - start);
+		iterator new_finish = new_start;
+		bool copied = false;
+		try {
+			STL::uninitialized_copy(first, last, new_position);
+			copied = true;
+			new_finish = STL::__uninitialized_move_if_noexcept(start, position, new_start);
+			new_finish = STL::__uninitialized_move_if_noexcept(position, finish, new_position + n);
+		}
+		catch (...) {
+			if (copied)
+				STL::destroy(new_position, new_position + n);
+			STL::destroy(new_start, new_finish);
+			data_allocator::deallocate(new_start, len);
+			throw;
+		}
+
+		STL::destroy(start, finish);
+		deallocate();
+
+		start = new_start;
+		finish = new_finish;
+		end_of_storage = new_start + len;
+	}
+
+	template <class T, class Alloc, class Growth>
+	template <class InputIterator>
+	void vector<T, Alloc, Growth>::range_assign(InputIterator first, InputIterator last, input_iterator_tag) {
+		iterator cur = start;
+		for (; first != last && cur != finish; ++first, ++cur)
+			*cur = *first;
+		if (first == last)
+			erase_at_end(cur);
+		else
+			range_insert(finish, first, last, input_iterator_tag());
+	}
+
+	// A range longer than the capacity gets a block of exactly its size,
+	// like the (n, value) constructor.
+	template <class T, class Alloc, class Growth>
+	template <class ForwardIterator>
+	void vector<T, Alloc, Growth>::range_assign(ForwardIterator first, ForwardIterator last, forward_iterator_tag) {
+		const size_type n = static_cast<size_type>(STL::distance(first, last));
+		if (n > capacity()) {
+			iterator new_start = data_allocator::allocate(n);
 			try {
-				new_finish = STL::uninitialized_copy(start, position, new_start);
-				const construct(new_finish, x);
-				++new_finish;
-				new_finish = STL::uninitialized_copy(position, finish, new_finish)
+				STL::uninitialized_copy(first, last, new_start);
 			}
-			catch (std::exception&) {
-				destroy(new_start, new_finish);
-				data_allocator::deallocate(new_start, len);
+			catch (...) {
+				data_allocator::deallocate(new_start, n);
 				throw;
 			}
-
-			destroy(start, finish);
+			STL::destroy(start, finish);
 			deallocate();
-
 			start = new_start;
-			finish = new_finish;
-			end_of_storage = new_start + len;
+			finish = end_of_storage = new_start + n;
+		}
+		else if (size() >= n)
+			erase_at_end(STL::copy(first, last, start));
+		else {
+			ForwardIterator mid = first;
+			STL::advance(mid, size());
+			STL::copy(first, mid, start);
+			finish = STL::uninitialized_copy(mid, last, finish);
+		}
+	}
+
+	template <class T, class Alloc, class Growth>
+	void vector<T, Alloc, Growth>::fill_assign(size_type n, const T& x) {
+		if (n > capacity()) {
+			vector tmp(n, x);
+			swap(tmp);
+		}
+		else if (size() >= n) {
+			STL::fill_n(start, n, x);
+			erase_at_end(start + n);
+		}
+		else {
+			STL::fill(start, finish, x);
+			finish = STL::uninitialized_fill_n(finish, n - size(), x);
 		}
 	}
 }
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+
+namespace STL {
+
+	// Growth policies for vector. next() gets the current capacity, the
+	// smallest capacity that will do and sizeof(T), and returns the new
+	// capacity in elements; the result is never below required.
+
+	// capacity * Num / Den. <2, 1> is the classic doubling and leaves up to
+	// half the block unused; <3, 2> caps the slack at a third.
+	template <size_t Num = 2, size_t Den = 1>
+	struct __geometric_growth {
+		static_assert(Num > Den && Den > 0, "growth factor must be greater than one");
+
+		static size_t next(size_t capacity, size_t required, size_t) {
+			const size_t grown = capacity != 0 ? capacity + capacity / Den * (Num - Den) + capacity % Den * (Num - Den) / Den : 1;
+			return grown > required ? grown : required;
+		}
+	};
+
+	// Small blocks follow Small. From MinBytes on, the block grows by a
+	// quarter and is rounded up to whole pages, which the system allocator
+	// hands out anyway; on multi-gigabyte vectors this bounds the unused
+	// tail at 25% plus one page instead of 50%.
+	template <size_t PageBytes = 4096, size_t MinBytes = 1024 * 1024, class Small = __geometric_growth<> >
+	struct __page_rounded_growth {
+		static_assert((PageBytes & (PageBytes - 1)) == 0, "page size must be a power of two");
+
+		static size_t next(size_t capacity, size_t required, size_t element_size) {
+			if (required * element_size < MinBytes)
+				return Small::next(capacity, required, element_size);
+			size_t grown = capacity + capacity / 4;
+			if (grown < required)
+				grown = required;
+			const size_t bytes = (grown * element_size + PageBytes - 1) & ~(PageBytes - 1);
+			return bytes / element_size;
+		}
+	};
+
+	using __default_growth = __geometric_growth<>;
+
+	// What a container holds against what it has taken from its allocator.
+	struct memory_usage {
+		size_t used_bytes;
+		size_t allocated_bytes;
+
+		size_t slack_bytes() const noexcept { return allocated_bytes - used_bytes; }
+		// Unused fraction of the allocation, 0 when the block is full or absent.
+		double overhead() const noexcept { return allocated_bytes ? double(slack_bytes()) / double(allocated_bytes) : 0.0; }
+	};
+}
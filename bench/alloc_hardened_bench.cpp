@@ -0,0 +1,57 @@
+// Cost of the hardened pool. The same source is built twice, as
+// alloc_hardened_bench and alloc_hardened_bench_off; run both and compare.
+
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "alloc.h"
+#include "bench.h"
+
+namespace {
+
+	using pool = STL::__default_alloc_template<false, 0>;
+
+	// Allocation and deallocation in LIFO bursts, as container nodes see them.
+	double burst_ns(size_t bytes, size_t n) {
+		std::vector<void*> blocks(n);
+		const double ns = bench::best_ns(7, [&] {
+			for (size_t i = 0; i < n; ++i)
+				blocks[i] = pool::allocate(bytes);
+			for (size_t i = n; i-- != 0; )
+				pool::deallocate(blocks[i], bytes);
+		});
+		return ns / double(2 * n);
+	}
+
+	// Frees in random order, so consecutive allocations walk scattered
+	// free-list links.
+	double scattered_ns(size_t bytes, size_t n) {
+		std::vector<void*> blocks(n);
+		std::mt19937 rng(7);
+		const double ns = bench::best_ns(7, [&] {
+			for (size_t i = 0; i < n; ++i)
+				blocks[i] = pool::allocate(bytes);
+			for (size_t i = n; i > 1; --i)
+				std::swap(blocks[i - 1], blocks[rng() % i]);
+			for (size_t i = 0; i < n; ++i)
+				pool::deallocate(blocks[i], bytes);
+		});
+		return ns / double(2 * n);
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t n = argc > 1 ? std::stoul(argv[1]) : 100000;
+#ifdef __STL_ALLOC_HARDENED
+	std::printf("hardened pool, ");
+#else
+	std::printf("plain pool, ");
+#endif
+	std::printf("%zu blocks, ns per operation\n", n);
+	std::printf("%8s %10s %12s\n", "block", "burst", "scattered");
+	const size_t sizes[] = { 8, 24, 48, 96 };
+	for (size_t bytes : sizes)
+		std::printf("%6zu B %10.2f %12.2f\n", bytes, burst_ns(bytes, n), scattered_ns(bytes, n));
+	return 0;
+}
@@ -0,0 +1,110 @@
+// Small-object throughput of the shared pool against its single-threaded
+// path and malloc. Built as alloc_lockfree_bench (__STL_ALLOC_LOCKFREE) and
+// alloc_lockfree_bench_off (mutex-only returns) from this one source.
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "alloc.h"
+#include "bench.h"
+
+namespace {
+
+	using single_pool = STL::__default_alloc_template<false, 0>;
+	using shared_pool = STL::__default_alloc_template<true, 0>;
+
+	enum { BATCH = 256 };
+
+	// One thread allocating and freeing its own blocks.
+	template <class Alloc>
+	double local_ns(size_t bytes, size_t n) {
+		std::vector<void*> blocks(BATCH);
+		const double ns = bench::best_ns(5, [&] {
+			for (size_t done = 0; done < n; done += BATCH) {
+				for (size_t i = 0; i < BATCH; ++i)
+					blocks[i] = Alloc::allocate(bytes);
+				for (size_t i = 0; i < BATCH; ++i)
+					Alloc::deallocate(blocks[i], bytes);
+			}
+		});
+		return ns / double(2 * n);
+	}
+
+	struct handoff {
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<std::vector<void*> > batches;
+		bool done = false;
+	};
+
+	// Producers allocate, consumers on other threads free: every block
+	// crosses threads once.
+	template <class Alloc>
+	double producer_consumer_ns(size_t bytes, size_t n, unsigned pairs) {
+		const double ns = bench::best_ns(3, [&] {
+			std::vector<handoff> pipes(pairs);
+			std::vector<std::thread> threads;
+			for (unsigned p = 0; p < pairs; ++p) {
+				handoff& h = pipes[p];
+				threads.emplace_back([&h, bytes, n] {
+					for (size_t done = 0; done < n; done += BATCH) {
+						std::vector<void*> batch(BATCH);
+						for (size_t i = 0; i < BATCH; ++i)
+							batch[i] = Alloc::allocate(bytes);
+						std::lock_guard<std::mutex> lock(h.mutex);
+						h.batches.push_back(std::move(batch));
+						h.ready.notify_one();
+					}
+					std::lock_guard<std::mutex> lock(h.mutex);
+					h.done = true;
+					h.ready.notify_one();
+				});
+				threads.emplace_back([&h, bytes] {
+					for (;;) {
+						std::vector<void*> batch;
+						{
+							std::unique_lock<std::mutex> lock(h.mutex);
+							h.ready.wait(lock, [&h] { return !h.batches.empty() || h.done; });
+							if (h.batches.empty())
+								return;
+							batch = std::move(h.batches.front());
+							h.batches.pop_front();
+						}
+						for (void* p : batch)
+							Alloc::deallocate(p, bytes);
+					}
+				});
+			}
+			for (std::thread& t : threads)
+				t.join();
+		});
+		return ns / double(2 * n * pairs);
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t n = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+#ifdef __STL_ALLOC_LOCKFREE
+	std::printf("lock-free returns, ");
+#else
+	std::printf("mutex returns, ");
+#endif
+	std::printf("%zu blocks per thread, ns per operation\n\n", n);
+
+	std::printf("one thread\n%8s %10s %14s %14s\n", "block", "malloc", "single pool", "shared pool");
+	const size_t sizes[] = { 16, 64, 128 };
+	for (size_t bytes : sizes)
+		std::printf("%6zu B %10.2f %14.2f %14.2f\n", bytes,
+			local_ns<STL::malloc_alloc>(bytes, n), local_ns<single_pool>(bytes, n), local_ns<shared_pool>(bytes, n));
+
+	const unsigned hw = std::thread::hardware_concurrency();
+	std::printf("\nproducer/consumer pairs, 64 B blocks\n%8s %10s %14s\n", "pairs", "malloc", "shared pool");
+	for (unsigned pairs = 1; pairs <= (hw > 1 ? hw / 2 : 1); pairs *= 2)
+		std::printf("%8u %10.2f %14.2f\n", pairs,
+			producer_consumer_ns<STL::malloc_alloc>(64, n, pairs), producer_consumer_ns<shared_pool>(64, n, pairs));
+	return 0;
+}
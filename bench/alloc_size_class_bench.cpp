@@ -0,0 +1,75 @@
+// Node allocation throughput for map<std::string, X>-shaped nodes of 64,
+// 128, 256 and 512 bytes: a tree header, a string key and the rest as
+// mapped value. rb_tree does not build here yet, so the nodes are churned
+// directly through each allocator the way insert/erase would. Keys stay
+// within the short-string buffer so that only the node is allocated.
+
+#include <cstdio>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#include "alloc.h"
+#include "bench.h"
+
+namespace {
+
+	struct node_header {
+		int color;
+		void* parent;
+		void* left;
+		void* right;
+	};
+
+	template <class Alloc>
+	struct churn {
+		static std::string* make(size_t bytes, int key) {
+			char* p = static_cast<char*>(Alloc::allocate(bytes));
+			new (p) node_header();
+			return new (p + sizeof(node_header)) std::string(std::to_string(key));
+		}
+		static void release(std::string* s, size_t bytes) {
+			s->~basic_string();
+			Alloc::deallocate(reinterpret_cast<char*>(s) - sizeof(node_header), bytes);
+		}
+
+		// Fills n nodes, replaces half of them at random twice over, then
+		// frees the lot. Returns nanoseconds per allocation.
+		static double run(size_t bytes, size_t n) {
+			std::vector<std::string*> nodes(n);
+			std::mt19937 rng(42);
+			const size_t rounds = n;
+			const double ns = bench::best_ns(5, [&] {
+				for (size_t i = 0; i < n; ++i)
+					nodes[i] = make(bytes, static_cast<int>(i));
+				for (size_t i = 0; i < rounds; ++i) {
+					const size_t k = rng() % n;
+					release(nodes[k], bytes);
+					nodes[k] = make(bytes, static_cast<int>(k));
+				}
+				for (size_t i = 0; i < n; ++i)
+					release(nodes[i], bytes);
+			});
+			return ns / double(n + rounds);
+		}
+	};
+
+	using linear_pool = STL::__default_alloc_template<false, 0>;
+	using geometric_pool = STL::__default_alloc_template<false, 0, STL::__geometric_size_classes<> >;
+	using geometric_pool_mt = STL::__default_alloc_template<true, 0, STL::__geometric_size_classes<> >;
+}
+
+int main(int argc, char** argv) {
+	const size_t n = argc > 1 ? std::stoul(argv[1]) : 200000;
+	std::printf("%zu nodes, ns per allocation (lower is better)\n", n);
+	std::printf("%10s %12s %14s %16s %18s\n", "node", "malloc", "linear/128", "geometric/512", "geometric/512 mt");
+	const size_t sizes[] = { 64, 128, 256, 512 };
+	for (size_t bytes : sizes) {
+		std::printf("%8zu B %12.1f %14.1f %16.1f %18.1f\n", bytes,
+			churn<STL::malloc_alloc>::run(bytes, n),
+			churn<linear_pool>::run(bytes, n),
+			churn<geometric_pool>::run(bytes, n),
+			churn<geometric_pool_mt>::run(bytes, n));
+	}
+	return 0;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+
+namespace bench {
+
+	using clock = std::chrono::steady_clock;
+
+	// Keeps the compiler from dropping work whose result is never read.
+	template <class T>
+	inline void keep(const T& value) {
+#if defined(_MSC_VER)
+		static const void* volatile sink;
+		sink = &value;
+#else
+		asm volatile("" : : "r"(&value) : "memory");
+#endif
+	}
+
+	// Best of runs timings of f(), in nanoseconds.
+	template <class Function>
+	double best_ns(int runs, Function f) {
+		double best = 0;
+		for (int i = 0; i < runs; ++i) {
+			const clock::time_point t0 = clock::now();
+			f();
+			const double ns = std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+			if (i == 0 || ns < best)
+				best = ns;
+		}
+		return best;
+	}
+
+	inline const char* bytes_label(size_t bytes, char* buf, size_t len) {
+		if (bytes >= (size_t(1) << 30))
+			std::snprintf(buf, len, "%zu GiB", bytes >> 30);
+		else if (bytes >= (size_t(1) << 20))
+			std::snprintf(buf, len, "%zu MiB", bytes >> 20);
+		else if (bytes >= (size_t(1) << 10))
+			std::snprintf(buf, len, "%zu KiB", bytes >> 10);
+		else
+			std::snprintf(buf, len, "%zu B", bytes);
+		return buf;
+	}
+}
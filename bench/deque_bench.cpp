@@ -0,0 +1,68 @@
+// push_back, operator[] and iteration over deque<int>, deque<std::string>
+// and deque<big512> under each block policy, in ns per element.
+
+#include <cstdio>
+#include <string>
+#include "stl_deque.h"
+#include "bench.h"
+
+namespace {
+
+	struct big512 {
+		long key;
+		char pad[504];
+		big512(long k = 0) : key(k) { }
+	};
+
+	long key_of(int v) { return v; }
+	long key_of(const std::string& s) { return static_cast<long>(s.size()); }
+	long key_of(const big512& b) { return b.key; }
+
+	int make(int i, int*) { return i; }
+	std::string make(int i, std::string*) { return std::string(i % 32, 's'); }
+	big512 make(int i, big512*) { return big512(i); }
+
+	template <class T, class Block>
+	void measure(const char* type, const char* block, size_t n) {
+		double push_ns = 0, index_ns = 0, iter_ns = 0;
+		for (int run = 0; run < 3; ++run) {
+			STL::deque<T, STL::alloc, 0, Block> d;
+			const double p = bench::best_ns(1, [&] {
+				for (size_t i = 0; i < n; ++i)
+					d.push_back(make(static_cast<int>(i), static_cast<T*>(nullptr)));
+			});
+			long sum = 0;
+			const double x = bench::best_ns(1, [&] {
+				for (size_t i = 0; i < n; ++i)
+					sum += key_of(d[i]);
+			});
+			const double it = bench::best_ns(1, [&] {
+				for (auto i = d.begin(); i != d.end(); ++i)
+					sum += key_of(*i);
+			});
+			bench::keep(sum);
+			if (run == 0 || p < push_ns) push_ns = p;
+			if (run == 0 || x < index_ns) index_ns = x;
+			if (run == 0 || it < iter_ns) iter_ns = it;
+		}
+		std::printf("%-8s %-8s %8zu %10zu %10.2f %10.2f %10.2f\n", type, block,
+			STL::deque<T, STL::alloc, 0, Block>::iterator::buffer_size(), n,
+			push_ns / double(n), index_ns / double(n), iter_ns / double(n));
+	}
+
+	template <class T>
+	void measure_all(const char* type, size_t n) {
+		measure<T, STL::__deque_classic_block>(type, "classic", n);
+		measure<T, STL::__deque_paged_block<> >(type, "paged", n);
+		measure<T, STL::__deque_huge_block<> >(type, "huge", n);
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t scale = argc > 1 ? std::stoul(argv[1]) : 1 << 20;
+	std::printf("%-8s %-8s %8s %10s %10s %10s %10s\n", "type", "block", "per node", "elements", "push_back", "operator[]", "iterate");
+	measure_all<int>("int", 4 * scale);
+	measure_all<std::string>("string", scale);
+	measure_all<big512>("big512", scale / 8);
+	return 0;
+}
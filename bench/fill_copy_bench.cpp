@@ -0,0 +1,82 @@
+// fill and copy throughput from 64 B to 1 GiB (or the size given on the
+// command line): STL::fill through the kernels against the element loop
+// it replaced, and STL::copy against plain memcpy. Ranges past the
+// non-temporal threshold are streamed; see nontemporal_bench for that.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "fill_kernel.h"
+#include "stl_algobase.h"
+#include "bench.h"
+
+namespace {
+
+	struct pair16 { uint64_t lo, hi; };
+
+	// Enough repetitions that each timing covers at least 256 MiB.
+	int repeats(size_t bytes) {
+		const size_t total = size_t(256) << 20;
+		return bytes >= total ? 1 : static_cast<int>(total / bytes);
+	}
+
+	double gib_per_s(size_t bytes, int reps, double ns) { return double(bytes) * reps / ns * 1e9 / double(size_t(1) << 30); }
+
+	template <class T, class Fill>
+	double fill_rate(T* p, size_t bytes, const T& value, Fill fill) {
+		const size_t n = bytes / sizeof(T);
+		const int reps = repeats(bytes);
+		const double ns = bench::best_ns(3, [&] {
+			for (int r = 0; r < reps; ++r) {
+				fill(p, n, value);
+				bench::keep(*p);
+			}
+		});
+		return gib_per_s(n * sizeof(T), reps, ns);
+	}
+
+	template <class Copy>
+	double copy_rate(unsigned char* dst, const unsigned char* src, size_t bytes, Copy copy) {
+		const int reps = repeats(bytes);
+		const double ns = bench::best_ns(3, [&] {
+			for (int r = 0; r < reps; ++r) {
+				copy(dst, src, bytes);
+				bench::keep(*dst);
+			}
+		});
+		return gib_per_s(bytes, reps, ns);
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t max_bytes = argc > 1 ? std::stoull(argv[1]) : size_t(1) << 30;
+	unsigned char* src = static_cast<unsigned char*>(std::malloc(max_bytes));
+	unsigned char* dst = static_cast<unsigned char*>(std::malloc(max_bytes));
+	if (src == nullptr || dst == nullptr) {
+		std::fprintf(stderr, "cannot allocate 2 x %zu bytes\n", max_bytes);
+		return 1;
+	}
+	std::memset(src, 1, max_bytes);
+	std::memset(dst, 2, max_bytes);
+
+	std::printf("GiB/s, non-temporal threshold %zu bytes\n", STL::nontemporal_threshold());
+	std::printf("%9s %10s %10s %10s %10s %10s %10s %10s\n", "size", "char", "char loop", "int", "int loop",
+		"pair16", "copy", "memcpy");
+	for (size_t bytes = 64; bytes <= max_bytes; bytes *= 2) {
+		char label[32];
+		const auto kernel = [](auto* p, size_t n, const auto& v) { STL::fill_n(p, n, v); };
+		const auto loop = [](auto* p, size_t n, const auto& v) { STL::__fill_t(p, n, v, STL::__false_type()); };
+		std::printf("%9s %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n", bench::bytes_label(bytes, label, sizeof(label)),
+			fill_rate(reinterpret_cast<char*>(dst), bytes, 'x', kernel),
+			fill_rate(reinterpret_cast<char*>(dst), bytes, 'x', loop),
+			fill_rate(reinterpret_cast<int*>(dst), bytes, 0x01020304, kernel),
+			fill_rate(reinterpret_cast<int*>(dst), bytes, 0x01020304, loop),
+			fill_rate(reinterpret_cast<pair16*>(dst), bytes, pair16{ 1, 2 }, kernel),
+			copy_rate(dst, src, bytes, [](unsigned char* d, const unsigned char* s, size_t n) { STL::copy(s, s + n, d); }),
+			copy_rate(dst, src, bytes, [](unsigned char* d, const unsigned char* s, size_t n) { std::memcpy(d, s, n); }));
+	}
+	std::free(src);
+	std::free(dst);
+	return 0;
+}
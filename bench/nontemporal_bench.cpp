@@ -0,0 +1,115 @@
+// What a large fill or copy does to everyone else's cache. A second thread
+// walks a working set of a quarter of the last-level cache in random order
+// while this one fills and copies ranges well past it, once with
+// non-temporal stores and once without. Also reported: the walk right
+// after a fill on the same thread, which is what a single-threaded caller
+// sees.
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fill_kernel.h"
+#include "stl_algobase.h"
+#include "bench.h"
+
+namespace {
+
+	// A random cyclic permutation of cache lines, so each load depends on
+	// the one before and the prefetchers cannot help.
+	struct working_set {
+		struct alignas(64) line { line* next; };
+		std::vector<line> lines;
+
+		explicit working_set(size_t bytes) : lines(bytes / sizeof(line)) {
+			std::vector<size_t> order(lines.size());
+			std::iota(order.begin(), order.end(), size_t(0));
+			std::shuffle(order.begin() + 1, order.end(), std::mt19937_64(1));
+			for (size_t i = 0; i < order.size(); ++i)
+				lines[order[i]].next = &lines[order[(i + 1) % order.size()]];
+		}
+
+		// ns per dependent load over `steps' loads.
+		double walk(size_t steps) const {
+			const line* p = &lines[0];
+			const bench::clock::time_point t0 = bench::clock::now();
+			for (size_t i = 0; i < steps; ++i)
+				p = p->next;
+			const double ns = std::chrono::duration<double, std::nano>(bench::clock::now() - t0).count();
+			bench::keep(p);
+			return ns / double(steps);
+		}
+	};
+
+	struct result {
+		double fill_gib_s;
+		double copy_gib_s;
+		double walk_during_ns;
+		double walk_after_ns;
+	};
+
+	result run(const working_set& ws, unsigned char* dst, const unsigned char* src, size_t bytes, size_t threshold) {
+		const size_t old = STL::set_nontemporal_threshold(threshold);
+		result r = { };
+		const size_t steps = ws.lines.size() * 4;
+
+		ws.walk(steps);
+		STL::fill(dst, dst + bytes, static_cast<unsigned char>(3));
+		r.walk_after_ns = ws.walk(steps);
+
+		std::atomic<bool> stop(false);
+		std::atomic<size_t> walks(0);
+		double walk_total = 0;
+		std::thread victim([&] {
+			while (!stop.load(std::memory_order_relaxed)) {
+				walk_total += ws.walk(steps);
+				walks.fetch_add(1, std::memory_order_relaxed);
+			}
+		});
+		const int reps = 4;
+		const double fill_ns = bench::best_ns(reps, [&] { STL::fill(dst, dst + bytes, static_cast<unsigned char>(5)); });
+		const double copy_ns = bench::best_ns(reps, [&] { STL::copy(src, src + bytes, dst); });
+		stop.store(true);
+		victim.join();
+
+		r.fill_gib_s = double(bytes) / fill_ns * 1e9 / double(size_t(1) << 30);
+		r.copy_gib_s = double(bytes) / copy_ns * 1e9 / double(size_t(1) << 30);
+		r.walk_during_ns = walks.load() != 0 ? walk_total / double(walks.load()) : 0;
+		STL::set_nontemporal_threshold(old);
+		return r;
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t bytes = argc > 1 ? std::stoull(argv[1]) : size_t(1) << 30;
+	const size_t llc = STL::nontemporal_threshold() * 2;
+	const working_set ws(llc / 4);
+	unsigned char* src = static_cast<unsigned char*>(std::malloc(bytes));
+	unsigned char* dst = static_cast<unsigned char*>(std::malloc(bytes));
+	if (src == nullptr || dst == nullptr) {
+		std::fprintf(stderr, "cannot allocate 2 x %zu bytes\n", bytes);
+		return 1;
+	}
+	std::memset(src, 1, bytes);
+	std::memset(dst, 2, bytes);
+
+	char label[32], ws_label[32];
+	std::printf("%s fills and copies, %s working set, idle walk %.2f ns per load\n",
+		bench::bytes_label(bytes, label, sizeof(label)), bench::bytes_label(llc / 4, ws_label, sizeof(ws_label)),
+		ws.walk(ws.lines.size() * 4));
+	std::printf("%12s %12s %12s %18s %18s\n", "stores", "fill GiB/s", "copy GiB/s", "walk during (ns)", "walk after (ns)");
+	const result cached = run(ws, dst, src, bytes, SIZE_MAX);
+	const result streamed = run(ws, dst, src, bytes, 1);
+	std::printf("%12s %12.2f %12.2f %18.2f %18.2f\n", "cached", cached.fill_gib_s, cached.copy_gib_s, cached.walk_during_ns, cached.walk_after_ns);
+	std::printf("%12s %12.2f %12.2f %18.2f %18.2f\n", "streamed", streamed.fill_gib_s, streamed.copy_gib_s, streamed.walk_during_ns, streamed.walk_after_ns);
+	std::free(src);
+	std::free(dst);
+	return 0;
+}
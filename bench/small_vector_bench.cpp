@@ -0,0 +1,63 @@
+// small_vector<T, 8> against vector<T> for the sizes per-request vectors
+// actually have: allocations per container and ns to build, walk and
+// destroy one, both over the default pool allocator.
+
+#include <cstdio>
+#include <string>
+#include "stl_vector.h"
+#include "small_vector.h"
+#include "bench.h"
+
+namespace {
+
+	struct counting_pool {
+		static inline size_t allocations = 0;
+
+		static void* allocate(size_t n) {
+			++allocations;
+			return STL::alloc::allocate(n);
+		}
+		static void deallocate(void* p, size_t n) { STL::alloc::deallocate(p, n); }
+		static void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+			++allocations;
+			return STL::alloc::reallocate(p, old_sz, new_sz);
+		}
+	};
+
+	struct record {
+		long id;
+		double score;
+		char tag[16];
+	};
+
+	template <class Vec, class T>
+	void measure(const char* name, size_t n, size_t containers) {
+		const size_t before = counting_pool::allocations;
+		long sum = 0;
+		const double ns = bench::best_ns(5, [&] {
+			for (size_t c = 0; c < containers; ++c) {
+				Vec v;
+				for (size_t i = 0; i < n; ++i)
+					v.push_back(T());
+				for (size_t i = 0; i < v.size(); ++i)
+					sum += static_cast<long>(sizeof(v[i]));
+			}
+		});
+		bench::keep(sum);
+		const double allocs = double(counting_pool::allocations - before) / double(5 * containers);
+		std::printf("%-28s %6zu %12.2f %12.1f\n", name, n, allocs, ns / double(containers));
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t containers = argc > 1 ? std::stoul(argv[1]) : 100000;
+	std::printf("%-28s %6s %12s %12s\n", "container", "size", "allocs", "ns each");
+	const size_t sizes[] = { 1, 2, 4, 8, 16, 32 };
+	for (size_t n : sizes) {
+		measure<STL::vector<int, counting_pool>, int>("vector<int>", n, containers);
+		measure<STL::small_vector<int, 8, counting_pool>, int>("small_vector<int, 8>", n, containers);
+		measure<STL::vector<record, counting_pool>, record>("vector<record>", n, containers);
+		measure<STL::small_vector<record, 8, counting_pool>, record>("small_vector<record, 8>", n, containers);
+	}
+	return 0;
+}
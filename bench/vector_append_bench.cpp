@@ -0,0 +1,74 @@
+// Appending a range to a vector: one append(first, last) against a
+// push_back loop, for a POD and a non-trivial element type.
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "stl_vector.h"
+#include "bench.h"
+
+namespace {
+
+	struct counting_pool {
+		static inline size_t allocations = 0;
+
+		static void* allocate(size_t n) {
+			++allocations;
+			return STL::alloc::allocate(n);
+		}
+		static void deallocate(void* p, size_t n) { STL::alloc::deallocate(p, n); }
+	};
+
+	// Copyable but not bytewise: every copy and move goes through the
+	// constructors.
+	struct node {
+		int key;
+		char name[28];
+
+		node(int k = 0) : key(k) { std::memset(name, 'n', sizeof(name)); }
+		node(const node& rhs) : key(rhs.key) { std::memcpy(name, rhs.name, sizeof(name)); }
+		node& operator=(const node& rhs) {
+			key = rhs.key;
+			std::memcpy(name, rhs.name, sizeof(name));
+			return *this;
+		}
+	};
+
+	template <class T>
+	void measure(const char* type, size_t n, int reps) {
+		const std::vector<T> src(n, T(7));
+		size_t allocs[2] = { };
+		double ns[2];
+
+		size_t before = counting_pool::allocations;
+		ns[0] = bench::best_ns(reps, [&] {
+			STL::vector<T, counting_pool> v;
+			for (size_t i = 0; i < n; ++i)
+				v.push_back(src[i]);
+			bench::keep(v[n - 1]);
+		});
+		allocs[0] = (counting_pool::allocations - before) / reps;
+
+		before = counting_pool::allocations;
+		ns[1] = bench::best_ns(reps, [&] {
+			STL::vector<T, counting_pool> v;
+			v.append(src.data(), src.data() + n);
+			bench::keep(v[n - 1]);
+		});
+		allocs[1] = (counting_pool::allocations - before) / reps;
+
+		std::printf("%-6s %9zu %14.2f %8zu %14.2f %8zu\n", type, n, ns[0] / double(n), allocs[0], ns[1] / double(n), allocs[1]);
+	}
+}
+
+int main(int argc, char** argv) {
+	const size_t max_n = argc > 1 ? std::stoul(argv[1]) : size_t(1) << 22;
+	std::printf("%-6s %9s %14s %8s %14s %8s\n", "type", "elements", "push_back ns", "allocs", "append ns", "allocs");
+	for (size_t n = 16; n <= max_n; n *= 8) {
+		const int reps = n < 100000 ? 50 : 5;
+		measure<int>("int", n, reps);
+		measure<node>("node", n, reps);
+	}
+	return 0;
+}
@@ -0,0 +1,76 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "alloc.h"
+#include "check.h"
+
+// Built with __STL_ALLOC_HARDENED. The corruption handler throws, so each
+// detected error surfaces here instead of aborting.
+
+namespace {
+
+	struct corruption : std::runtime_error {
+		explicit corruption(const char* what) : std::runtime_error(what) { }
+	};
+
+	void throw_corruption(int, const char* what, const void*) { throw corruption(what); }
+
+	template <int inst>
+	std::string caught(void (*f)()) {
+		STL::__alloc_guard_handler<inst>::set_corruption_handler(throw_corruption);
+		try {
+			f();
+		}
+		catch (const corruption& e) {
+			return e.what();
+		}
+		return std::string();
+	}
+
+	using pool1 = STL::__default_alloc_template<false, 1>;
+	using pool2 = STL::__default_alloc_template<false, 2>;
+	using pool3 = STL::__default_alloc_template<false, 3>;
+	using pool4 = STL::__default_alloc_template<false, 4>;
+	using pool5 = STL::__default_alloc_template<false, 5>;
+
+	void clean_round_trip() {
+		for (size_t n = 1; n <= 64; ++n) {
+			void* p = pool1::allocate(n);
+			std::memset(p, 0x5a, n);
+			pool1::deallocate(p, n);
+		}
+	}
+
+	void double_free() {
+		void* p = pool2::allocate(24);
+		pool2::deallocate(p, 24);
+		pool2::deallocate(p, 24);
+	}
+
+	void size_mismatch() {
+		void* p = pool3::allocate(24);
+		pool3::deallocate(p, 32);
+	}
+
+	void overflow() {
+		char* p = static_cast<char*>(pool4::allocate(24));
+		std::memset(p, 0, 25);
+		pool4::deallocate(p, 24);
+	}
+
+	void use_after_free() {
+		char* p = static_cast<char*>(pool5::allocate(24));
+		pool5::deallocate(p, 24);
+		p[8] = 0;
+		pool5::allocate(24);
+	}
+}
+
+int main() {
+	CHECK(caught<1>(clean_round_trip).empty());
+	CHECK(caught<2>(double_free) == "double free");
+	CHECK(caught<3>(size_mismatch) == "size mismatch in deallocate");
+	CHECK(caught<4>(overflow) == "buffer overflow past end of block");
+	CHECK(caught<5>(use_after_free) == "write to freed block");
+	return test::result();
+}
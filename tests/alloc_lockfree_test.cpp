@@ -0,0 +1,128 @@
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "alloc.h"
+#include "check.h"
+
+// Producers allocate and stamp blocks, consumers on other threads check
+// the stamp and free them. Built twice: with __STL_ALLOC_LOCKFREE nearly
+// every deallocation goes through the returned stacks, without it through
+// the depot under the pool mutex.
+
+namespace {
+
+	using pool = STL::__default_alloc_template<true, 1>;
+
+	enum { PAIRS = 4, BATCHES = 400, BATCH = 256 };
+
+	struct handoff {
+		std::mutex mutex;
+		std::condition_variable ready;
+		std::deque<std::vector<void*> > batches;
+		bool done = false;
+
+		void put(std::vector<void*>&& batch) {
+			std::lock_guard<std::mutex> lock(mutex);
+			batches.push_back(std::move(batch));
+			ready.notify_one();
+		}
+		bool take(std::vector<void*>& batch) {
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [this] { return !batches.empty() || done; });
+			if (batches.empty())
+				return false;
+			batch = std::move(batches.front());
+			batches.pop_front();
+			return true;
+		}
+		void close() {
+			std::lock_guard<std::mutex> lock(mutex);
+			done = true;
+			ready.notify_all();
+		}
+	};
+
+	size_t block_size(size_t i) { return 8 + (i * 24) % 120; }
+
+	void stamp(void* p, size_t bytes, uintptr_t tag) {
+		unsigned char* q = static_cast<unsigned char*>(p);
+		for (size_t i = 0; i < bytes; ++i)
+			q[i] = static_cast<unsigned char>(tag + i);
+	}
+
+	bool stamped(const void* p, size_t bytes, uintptr_t tag) {
+		const unsigned char* q = static_cast<const unsigned char*>(p);
+		for (size_t i = 0; i < bytes; ++i)
+			if (q[i] != static_cast<unsigned char>(tag + i))
+				return false;
+		return true;
+	}
+
+	void producer(handoff& h, unsigned seed) {
+		for (size_t b = 0; b < BATCHES; ++b) {
+			std::vector<void*> batch(BATCH);
+			for (size_t i = 0; i < BATCH; ++i) {
+				const size_t bytes = block_size(i + seed);
+				batch[i] = pool::allocate(bytes);
+				stamp(batch[i], bytes, reinterpret_cast<uintptr_t>(batch[i]));
+			}
+			h.put(std::move(batch));
+			// Some same-thread churn between handoffs.
+			void* local = pool::allocate(block_size(b));
+			pool::deallocate(local, block_size(b));
+			void* group[40];
+			pool::allocate_batch(block_size(b + seed), 40, group);
+			pool::deallocate_batch(block_size(b + seed), 40, group);
+		}
+		h.close();
+	}
+
+	void consumer(handoff& h, unsigned seed, size_t& corrupted) {
+		std::vector<void*> batch;
+		while (h.take(batch)) {
+			for (size_t i = 0; i < batch.size(); ++i) {
+				const size_t bytes = block_size(i + seed);
+				if (!stamped(batch[i], bytes, reinterpret_cast<uintptr_t>(batch[i])))
+					++corrupted;
+				pool::deallocate(batch[i], bytes);
+			}
+		}
+	}
+}
+
+int main() {
+	for (int round = 0; round < 3; ++round) {
+		std::vector<handoff> pipes(PAIRS);
+		std::vector<size_t> corrupted(PAIRS, 0);
+		std::vector<std::thread> threads;
+		for (unsigned i = 0; i < PAIRS; ++i) {
+			threads.emplace_back(producer, std::ref(pipes[i]), i);
+			threads.emplace_back(consumer, std::ref(pipes[i]), i, std::ref(corrupted[i]));
+		}
+		for (std::thread& t : threads)
+			t.join();
+		for (size_t c : corrupted)
+			CHECK(c == 0);
+	}
+
+	// Everything handed back must be reusable from the main thread.
+	std::vector<void*> blocks;
+	for (size_t i = 0; i < PAIRS * BATCH; ++i) {
+		blocks.push_back(pool::allocate(64));
+		stamp(blocks.back(), 64, i);
+	}
+	for (size_t i = 0; i < blocks.size(); ++i) {
+		CHECK(stamped(blocks[i], 64, i));
+		pool::deallocate(blocks[i], 64);
+	}
+
+	// The exited threads gave their caches back, so with nothing live every
+	// chunk can be released.
+	pool::trim();
+	CHECK(pool::occupancy().chunks == 0);
+	return test::result();
+}
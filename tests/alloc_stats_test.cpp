@@ -0,0 +1,120 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "alloc.h"
+#include "check.h"
+
+// The __STL_ALLOC_STATS counters: per-class and total counts, live and
+// peak bytes, the request-size histogram, the trace hook and dump().
+
+namespace {
+
+	using pool = STL::__default_alloc_template<false, 4>;
+	using stats = STL::__alloc_stats<4>;
+	using classes = STL::__default_size_classes;
+
+	size_t traced_allocations = 0;
+	size_t traced_frees = 0;
+
+	void trace(int inst, const void* p, size_t, bool allocated) {
+		if (inst != 4 || p == nullptr)
+			return;
+		if (allocated)
+			++traced_allocations;
+		else
+			++traced_frees;
+	}
+
+	void counts_and_bytes() {
+		STL::alloc_stats_snapshot s = stats::snapshot();
+		CHECK(s.inst == 4);
+		CHECK(s.total.allocations == 0);
+		CHECK(s.total.live_bytes == 0);
+
+		const size_t small = classes::index(20);
+		const size_t medium = classes::index(100);
+		const size_t large = STL::__STATS_LARGE;
+		std::vector<void*> a, b, c;
+		for (int i = 0; i < 10; ++i)
+			a.push_back(pool::allocate(20));
+		for (int i = 0; i < 5; ++i)
+			b.push_back(pool::allocate(100));
+		for (int i = 0; i < 2; ++i)
+			c.push_back(pool::allocate(1000));
+
+		// Pooled requests count their class size, large ones what was asked.
+		const size_t live = 10 * classes::size(small) + 5 * classes::size(medium) + 2 * 1000;
+		s = stats::snapshot();
+		CHECK(s.total.allocations == 17);
+		CHECK(s.total.frees == 0);
+		CHECK(s.total.live_bytes == live);
+		CHECK(s.total.peak_bytes == live);
+		CHECK(s.classes[small].class_bytes == classes::size(small));
+		CHECK(s.classes[small].allocations == 10);
+		CHECK(s.classes[small].live_bytes == 10 * classes::size(small));
+		CHECK(s.classes[medium].allocations == 5);
+		CHECK(s.classes[large].class_bytes == 0);
+		CHECK(s.classes[large].allocations == 2);
+		CHECK(s.classes[large].live_bytes == 2000);
+
+		// Histogram buckets are powers of two of the requested size.
+		CHECK(s.histogram[4] == 10);
+		CHECK(s.histogram[6] == 5);
+		CHECK(s.histogram[9] == 2);
+
+		// Frees lower the live bytes; the peak stays.
+		for (void* p : a)
+			pool::deallocate(p, 20);
+		pool::deallocate(c[0], 1000);
+		s = stats::snapshot();
+		CHECK(s.total.frees == 11);
+		CHECK(s.classes[small].frees == 10);
+		CHECK(s.classes[small].live_bytes == 0);
+		CHECK(s.classes[small].peak_bytes == 10 * classes::size(small));
+		CHECK(s.classes[large].live_bytes == 1000);
+		CHECK(s.total.live_bytes == live - 10 * classes::size(small) - 1000);
+		CHECK(s.total.peak_bytes == live);
+
+		// Batches count one allocation and free per object.
+		void* batch[8];
+		pool::allocate_batch(20, 8, batch);
+		s = stats::snapshot();
+		CHECK(s.classes[small].allocations == 18);
+		CHECK(s.classes[small].live_bytes == 8 * classes::size(small));
+		pool::deallocate_batch(20, 8, batch);
+		CHECK(stats::snapshot().classes[small].frees == 18);
+
+		for (void* p : b)
+			pool::deallocate(p, 100);
+		pool::deallocate(c[1], 1000);
+		s = stats::snapshot();
+		CHECK(s.total.allocations == s.total.frees);
+		CHECK(s.total.live_bytes == 0);
+		CHECK(s.total.peak_bytes == live);
+	}
+
+	void trace_and_dump() {
+		STL::alloc_trace_hook previous = stats::set_trace_hook(&trace);
+		CHECK(previous == nullptr);
+		void* p = pool::allocate(48);
+		void* q = pool::allocate(4096);
+		pool::deallocate(p, 48);
+		pool::deallocate(q, 4096);
+		CHECK(stats::set_trace_hook(previous) == &trace);
+		CHECK(traced_allocations == 2);
+		CHECK(traced_frees == 2);
+
+		std::ostringstream os;
+		stats::dump(os);
+		const std::string text = os.str();
+		CHECK(text.find("alloc inst 4:") == 0);
+		CHECK(text.find("  large:") != std::string::npos);
+		CHECK(text.find("  24B:") != std::string::npos);
+	}
+}
+
+int main() {
+	counts_and_bytes();
+	trace_and_dump();
+	return test::result();
+}
@@ -0,0 +1,193 @@
+#include <cstring>
+#include <utility>
+#include <vector>
+#include "alloc.h"
+#include "check.h"
+
+namespace {
+
+	// Every request maps to the smallest class that holds it.
+	template <class SizeClasses>
+	void test_size_classes() {
+		size_t last = 0;
+		for (size_t bytes = 1; bytes <= static_cast<size_t>(SizeClasses::max_bytes); ++bytes) {
+			const size_t index = SizeClasses::index(bytes);
+			CHECK(index < static_cast<size_t>(SizeClasses::count));
+			CHECK(SizeClasses::size(index) >= bytes);
+			CHECK(SizeClasses::size(index) % SizeClasses::align == 0);
+			CHECK(index == 0 || SizeClasses::size(index - 1) < bytes);
+			CHECK(index >= last);
+			last = index;
+		}
+		CHECK(SizeClasses::size(SizeClasses::count - 1) == static_cast<size_t>(SizeClasses::max_bytes));
+	}
+
+	// Blocks from the pool are disjoint and usable in full, up to and past
+	// the cutoff.
+	template <class Alloc>
+	void test_pool(size_t max_bytes) {
+		std::vector<void*> blocks;
+		std::vector<size_t> sizes;
+		for (size_t bytes = 1; bytes <= max_bytes + 64; bytes += 7) {
+			for (int i = 0; i < 3; ++i) {
+				void* p = Alloc::allocate(bytes);
+				CHECK(p != nullptr);
+				std::memset(p, static_cast<int>(bytes & 0xff), bytes);
+				blocks.push_back(p);
+				sizes.push_back(bytes);
+			}
+		}
+		for (size_t i = 0; i < blocks.size(); ++i) {
+			const unsigned char* p = static_cast<const unsigned char*>(blocks[i]);
+			bool intact = true;
+			for (size_t j = 0; j < sizes[i]; ++j)
+				intact = intact && p[j] == (sizes[i] & 0xff);
+			CHECK(intact);
+		}
+		for (size_t i = 0; i < blocks.size(); ++i)
+			Alloc::deallocate(blocks[i], sizes[i]);
+
+		CHECK(Alloc::pooled(max_bytes));
+		CHECK(!Alloc::pooled(max_bytes + 1));
+	}
+
+	template <size_t Classes>
+	size_t total(const size_t (&counts)[Classes]) {
+		size_t sum = 0;
+		for (size_t c : counts)
+			sum += c;
+		return sum;
+	}
+
+	// trim() hands back every chunk with nothing live in it, and only those;
+	// the pool then starts over from a fresh chunk. With thread caches the
+	// freed blocks sit in the cache until trim() releases it, so the counts
+	// in between are only checked for the single-threaded pool.
+	template <class Alloc>
+	void test_trim(bool cached) {
+		using occupancy_type = decltype(Alloc::occupancy());
+		std::vector<void*> blocks;
+		std::vector<size_t> sizes;
+		for (int i = 0; i < 20000; ++i) {
+			sizes.push_back(8 + static_cast<size_t>(i % 8) * 8);
+			blocks.push_back(Alloc::allocate(sizes.back()));
+		}
+		occupancy_type before = Alloc::occupancy();
+		CHECK(before.chunks >= 2);
+		CHECK(before.empty_chunks == 0);
+		CHECK(before.heap_bytes == before.chunks * STL::__CHUNK_BYTES);
+		CHECK(total(before.carved_objects) >= blocks.size());
+
+		// One block kept back pins its chunk.
+		for (size_t i = 1; i < blocks.size(); ++i)
+			Alloc::deallocate(blocks[i], sizes[i]);
+		if (!cached) {
+			occupancy_type freed = Alloc::occupancy();
+			CHECK(freed.chunks == before.chunks);
+			CHECK(freed.empty_chunks == before.chunks - 1);
+			CHECK(total(freed.free_objects) == total(freed.carved_objects) - 1);
+		}
+		CHECK(Alloc::trim() == (before.chunks - 1) * STL::__CHUNK_BYTES);
+		occupancy_type pinned = Alloc::occupancy();
+		CHECK(pinned.chunks == 1);
+		CHECK(pinned.empty_chunks == 0);
+		CHECK(pinned.heap_bytes == STL::__CHUNK_BYTES);
+
+		Alloc::deallocate(blocks[0], sizes[0]);
+		CHECK(Alloc::trim() == STL::__CHUNK_BYTES);
+		occupancy_type after = Alloc::occupancy();
+		CHECK(after.chunks == 0);
+		CHECK(after.heap_bytes == 0);
+		CHECK(after.tail_bytes == 0);
+		CHECK(total(after.carved_objects) == 0);
+		CHECK(total(after.free_objects) == 0);
+		CHECK(Alloc::trim() == 0);
+
+		// Allocation works again from new chunks.
+		for (size_t i = 0; i < 1000; ++i) {
+			blocks[i] = Alloc::allocate(sizes[i]);
+			std::memset(blocks[i], 0x5a, sizes[i]);
+		}
+		occupancy_type again = Alloc::occupancy();
+		CHECK(again.chunks >= 1);
+		CHECK(again.empty_chunks == 0);
+		CHECK(again.heap_bytes == again.chunks * STL::__CHUNK_BYTES);
+		for (size_t i = 0; i < 1000; ++i)
+			Alloc::deallocate(blocks[i], sizes[i]);
+		CHECK(Alloc::trim() == again.chunks * STL::__CHUNK_BYTES);
+	}
+
+	// Allocates from one size class until it refills once more and returns
+	// the new batch size. The blocks are kept, so the free list stays empty
+	// for the next call.
+	template <class Alloc>
+	size_t force_refill(size_t bytes, std::vector<std::pair<void*, size_t> >& keep) {
+		const size_t index = STL::__default_size_classes::index(bytes);
+		const size_t want = Alloc::refill_stats().refills[index] + 1;
+		while (Alloc::refill_stats().refills[index] < want)
+			keep.push_back(std::make_pair(Alloc::allocate(bytes), bytes));
+		return Alloc::refill_stats().batch[index];
+	}
+
+	// Refills of the other classes advance the refill clock without
+	// touching the 8-byte class.
+	template <class Alloc>
+	void other_refills(size_t count, std::vector<std::pair<void*, size_t> >& keep) {
+		for (size_t i = 0; i < count; ++i)
+			force_refill<Alloc>(16 + (i % 15) * 8, keep);
+	}
+
+	// Back-to-back refills of one class double its batch up to a quarter
+	// chunk; a class that has not refilled for a while gets half the batch.
+	template <class Alloc>
+	void test_refill_batch() {
+		const size_t classes = STL::__default_size_classes::count;
+		const size_t max_batch = STL::__CHUNK_BYTES / 4 / 8;
+		std::vector<std::pair<void*, size_t> > keep;
+
+		CHECK(Alloc::refill_stats().batch[0] == STL::__REFILL_INITIAL);
+		size_t batch = force_refill<Alloc>(8, keep);
+		CHECK(batch == STL::__REFILL_INITIAL);
+		bool doubled = true;
+		for (size_t expect = batch; expect < max_batch; ) {
+			expect = expect * 2 < max_batch ? expect * 2 : max_batch;
+			batch = force_refill<Alloc>(8, keep);
+			doubled = doubled && batch == expect;
+		}
+		CHECK(doubled);
+		CHECK(batch == max_batch);
+		CHECK(force_refill<Alloc>(8, keep) == max_batch);
+
+		// Idle for more than eight rounds of every class: halved.
+		other_refills<Alloc>(8 * classes + 1, keep);
+		CHECK(force_refill<Alloc>(8, keep) == max_batch / 2);
+
+		// Neither busy nor idle: unchanged.
+		other_refills<Alloc>(2 * classes, keep);
+		CHECK(force_refill<Alloc>(8, keep) == max_batch / 2);
+
+		other_refills<Alloc>(8 * classes + 1, keep);
+		CHECK(force_refill<Alloc>(8, keep) == max_batch / 4);
+
+		for (size_t i = 0; i < keep.size(); ++i)
+			Alloc::deallocate(keep[i].first, keep[i].second);
+		Alloc::trim();
+	}
+}
+
+int main() {
+	test_size_classes<STL::__linear_size_classes<> >();
+	test_size_classes<STL::__linear_size_classes<16, 256> >();
+	test_size_classes<STL::__geometric_size_classes<> >();
+	test_size_classes<STL::__geometric_size_classes<16, 1024, 2> >();
+
+	test_pool<STL::__default_alloc_template<false, 1> >(128);
+	test_pool<STL::__default_alloc_template<false, 2, STL::__geometric_size_classes<> > >(512);
+	test_pool<STL::__default_alloc_template<true, 3, STL::__geometric_size_classes<> > >(512);
+
+	test_trim<STL::__default_alloc_template<false, 7> >(false);
+	test_trim<STL::__default_alloc_template<true, 8> >(true);
+
+	test_refill_batch<STL::__default_alloc_template<false, 9> >();
+	return test::result();
+}
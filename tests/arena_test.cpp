@@ -0,0 +1,169 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <thread>
+#include <vector>
+#include "arena_alloc.h"
+#include "stl_vector.h"
+#include "stl_deque.h"
+#include "counted.h"
+#include "check.h"
+
+// The arena allocator: zero-byte requests, vector and deque storage carved
+// from it, reset() rewinding onto a caller's buffer, and the per-thread
+// arena keeping each thread's blocks apart.
+
+namespace {
+
+	using test::counted;
+
+	bool aligned(const void* p, size_t align) {
+		return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+	}
+
+	void zero_bytes() {
+		using arena = STL::__arena_alloc_template<false, 1>;
+		void* a = arena::allocate(0);
+		void* b = arena::allocate(0);
+		CHECK(a != nullptr);
+		CHECK(b != nullptr);
+		CHECK(a != b);
+		void* c = arena::allocate(0, 64);
+		CHECK(c != nullptr);
+		CHECK(aligned(c, 64));
+		CHECK(c != a && c != b);
+		arena::deallocate(a, 0);
+		arena::reset();
+	}
+
+	void containers() {
+		using arena = STL::__arena_alloc_template<false, 2>;
+		{
+			STL::vector<counted, arena> v;
+			for (int i = 0; i < 5000; ++i)
+				v.push_back(counted(i));
+			CHECK(v.size() == 5000);
+			bool in_order = true;
+			for (int i = 0; i < 5000; ++i)
+				in_order = in_order && v[i].value == i;
+			CHECK(in_order);
+			v.erase(v.begin());
+			v.resize(4000);
+			CHECK(v.size() == 4000);
+			CHECK(v[0].value == 1);
+			CHECK(v[3999].value == 4000);
+		}
+		CHECK(counted::live == 0);
+
+		{
+			STL::deque<counted, arena> d;
+			for (int i = 0; i < 3000; ++i) {
+				d.push_back(counted(i));
+				d.push_front(counted(-i));
+			}
+			CHECK(d.size() == 6000);
+			CHECK(d.front().value == -2999);
+			CHECK(d.back().value == 2999);
+			for (int i = 0; i < 1000; ++i) {
+				d.pop_front();
+				d.pop_back();
+			}
+			CHECK(d.size() == 4000);
+			CHECK(d.front().value == -1999);
+			CHECK(d[3999].value == 1999);
+		}
+		CHECK(counted::live == 0);
+		arena::reset();
+	}
+
+	// Outlives the arena's own statics, so the block can stay linked.
+	alignas(16) char buffer[16 * 1024];
+
+	void reset_onto_buffer() {
+		using arena = STL::__arena_alloc_template<false, 3>;
+		arena::add_buffer(buffer, sizeof(buffer));
+		char* first = static_cast<char*>(arena::allocate(100));
+		CHECK(first >= buffer && first + 100 <= buffer + sizeof(buffer));
+		char* second = static_cast<char*>(arena::allocate(100));
+		CHECK(second >= first + 100);
+
+		// Past the buffer the arena mallocs blocks of its own.
+		std::vector<void*> spilled;
+		for (int i = 0; i < 40; ++i)
+			spilled.push_back(arena::allocate(1024));
+		CHECK(spilled.back() < static_cast<void*>(buffer) || spilled.back() >= static_cast<void*>(buffer + sizeof(buffer)));
+
+		// reset frees those and starts over at the front of the buffer.
+		arena::reset();
+		CHECK(arena::allocate(100) == first);
+		CHECK(arena::allocate(100) == second);
+
+		{
+			STL::vector<int, arena> v(500, 7);
+			CHECK(static_cast<void*>(&v[0]) >= static_cast<void*>(buffer));
+			CHECK(static_cast<void*>(&v[499] + 1) <= static_cast<void*>(buffer + sizeof(buffer)));
+			CHECK(v[250] == 7);
+		}
+		arena::reset();
+		CHECK(arena::allocate(100) == first);
+		arena::reset();
+	}
+
+	// Each thread fills a vector from its own arena; no two live threads
+	// are ever handed the same bytes. The threads wait for each other before
+	// exiting, since an exiting thread frees its arena.
+	void per_thread() {
+		using arena = STL::thread_arena_alloc;
+		const int THREADS = 4;
+		const int N = 20000;
+		std::vector<std::vector<std::pair<std::uintptr_t, std::uintptr_t> > > ranges(THREADS);
+		std::vector<int> intact(THREADS, 0);
+		std::atomic<int> arrived(0);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < THREADS; ++t)
+			threads.emplace_back([&, t] {
+				{
+					STL::vector<int, arena> v;
+					for (int i = 0; i < N; ++i)
+						v.push_back(t * N + i);
+					bool ok = true;
+					for (int i = 0; i < N; ++i)
+						ok = ok && v[i] == t * N + i;
+					intact[t] = ok;
+				}
+				for (int i = 0; i < 200; ++i) {
+					char* p = static_cast<char*>(arena::allocate(64));
+					std::memset(p, t, 64);
+					ranges[t].emplace_back(reinterpret_cast<std::uintptr_t>(p), reinterpret_cast<std::uintptr_t>(p) + 64);
+				}
+				++arrived;
+				while (arrived.load() < THREADS)
+					std::this_thread::yield();
+			});
+		for (auto& th : threads)
+			th.join();
+
+		CHECK(intact == std::vector<int>(THREADS, 1));
+		bool overlap = false;
+		for (int a = 0; a < THREADS; ++a)
+			for (int b = a + 1; b < THREADS; ++b)
+				for (auto& ra : ranges[a])
+					for (auto& rb : ranges[b])
+						overlap = overlap || (ra.first < rb.second && rb.first < ra.second);
+		CHECK(!overlap);
+
+		// The main thread's arena is separate from the ones that just exited.
+		void* p = arena::allocate(0);
+		CHECK(p != nullptr);
+		arena::reset();
+	}
+}
+
+int main() {
+	zero_bytes();
+	containers();
+	reset_onto_buffer();
+	per_thread();
+	return test::result();
+}
@@ -0,0 +1,206 @@
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <vector>
+#include "alloc.h"
+#include "allocator.h"
+#include "stl_list.h"
+#include "slist.h"
+#include "stl_set.h"
+#include "hash_set.h"
+#include "counted.h"
+#include "check.h"
+
+// Batch allocation: the pool's allocate_batch/deallocate_batch, simpleAlloc's
+// forwarding and its loop fallback, and the containers whose bulk paths take
+// nodes from a __node_batch, each checked against the same container built
+// one node at a time.
+
+namespace {
+
+	// malloc underneath, counting single and batch calls separately.
+	struct batch_counting_alloc {
+		static inline size_t single_calls = 0;
+		static inline size_t batch_calls = 0;
+		static inline long live_objects = 0;
+
+		static void* allocate(size_t n) {
+			++single_calls;
+			++live_objects;
+			return STL::malloc_alloc::allocate(n);
+		}
+		static void deallocate(void* p, size_t n) {
+			--live_objects;
+			STL::malloc_alloc::deallocate(p, n);
+		}
+		static void allocate_batch(size_t n, size_t count, void** out) {
+			++batch_calls;
+			live_objects += static_cast<long>(count);
+			for (size_t i = 0; i < count; ++i)
+				out[i] = STL::malloc_alloc::allocate(n);
+		}
+		static void deallocate_batch(size_t n, size_t count, void** p) {
+			live_objects -= static_cast<long>(count);
+			for (size_t i = 0; i < count; ++i)
+				STL::malloc_alloc::deallocate(p[i], n);
+		}
+
+		static void reset() {
+			single_calls = 0;
+			batch_calls = 0;
+		}
+	};
+
+	// Blocks from one batch are distinct, aligned and usable; once returned,
+	// the next batch of the same size is served from them.
+	template <class Alloc>
+	void pool_batch(size_t bytes) {
+		const size_t count = 300;
+		std::vector<void*> out(count);
+		Alloc::allocate_batch(bytes, count, out.data());
+		std::set<void*> distinct(out.begin(), out.end());
+		CHECK(distinct.size() == count);
+		bool aligned = true;
+		for (size_t i = 0; i < count; ++i) {
+			aligned = aligned && reinterpret_cast<std::uintptr_t>(out[i]) % alignof(void*) == 0;
+			std::memset(out[i], static_cast<int>(i & 0xff), bytes);
+		}
+		CHECK(aligned);
+		bool intact = true;
+		for (size_t i = 0; i < count; ++i)
+			intact = intact && static_cast<unsigned char*>(out[i])[bytes - 1] == (i & 0xff);
+		CHECK(intact);
+
+		Alloc::deallocate_batch(bytes, count, out.data());
+		std::vector<void*> again(count);
+		Alloc::allocate_batch(bytes, count, again.data());
+		CHECK(std::set<void*>(again.begin(), again.end()) == distinct);
+
+		// Single frees and a batch allocation share the same free lists.
+		for (size_t i = 0; i < count; ++i)
+			Alloc::deallocate(again[i], bytes);
+		Alloc::allocate_batch(bytes, count, out.data());
+		CHECK(std::set<void*>(out.begin(), out.end()) == distinct);
+		Alloc::deallocate_batch(bytes, count, out.data());
+
+		// Past the cutoff every block goes through allocate.
+		Alloc::allocate_batch(4096, 3, out.data());
+		CHECK(out[0] != out[1] && out[1] != out[2]);
+		Alloc::deallocate_batch(4096, 3, out.data());
+	}
+
+	struct node24 { void* links[2]; int value; };
+
+	void simple_alloc_batch() {
+		node24* nodes[40];
+
+		// An allocator with batch entry points gets one call.
+		batch_counting_alloc::reset();
+		STL::simpleAlloc<node24, batch_counting_alloc>::allocate_batch(40, nodes);
+		CHECK(batch_counting_alloc::batch_calls == 1);
+		CHECK(batch_counting_alloc::single_calls == 0);
+		CHECK(batch_counting_alloc::live_objects == 40);
+		STL::simpleAlloc<node24, batch_counting_alloc>::deallocate_batch(nodes, 40);
+		CHECK(batch_counting_alloc::live_objects == 0);
+
+		// One without them is called once per object.
+		const size_t before = test::counting_alloc::allocations;
+		STL::simpleAlloc<node24, test::counting_alloc>::allocate_batch(40, nodes);
+		CHECK(test::counting_alloc::allocations == before + 40);
+		STL::simpleAlloc<node24, test::counting_alloc>::deallocate_batch(nodes, 40);
+		CHECK(test::counting_alloc::live_bytes == 0);
+
+		// The pool hands out distinct nodes through simpleAlloc as well.
+		using pool = STL::__default_alloc_template<false, 6>;
+		STL::simpleAlloc<node24, pool>::allocate_batch(40, nodes);
+		CHECK(std::set<node24*>(nodes, nodes + 40).size() == 40);
+		STL::simpleAlloc<node24, pool>::deallocate_batch(nodes, 40);
+	}
+
+	template <class Container>
+	std::vector<int> values(const Container& c) {
+		std::vector<int> out;
+		for (auto it = c.begin(); it != c.end(); ++it)
+			out.push_back(*it);
+		return out;
+	}
+
+	// __node_batch asks for 4, 8, 16, 32 and then 64 nodes at a time.
+	size_t batches_for(size_t nodes) {
+		size_t calls = 0;
+		for (size_t got = 0, batch = 4; got < nodes; got += batch, batch = batch * 2 < 64 ? batch * 2 : 64)
+			++calls;
+		return calls;
+	}
+
+	void containers_batched_and_unbatched() {
+		std::vector<int> src;
+		for (int i = 0; i < 200; ++i)
+			src.push_back((i * 37) % 200);
+
+		{
+			batch_counting_alloc::reset();
+			STL::list<int, batch_counting_alloc> batched(src.begin(), src.end());
+			CHECK(batch_counting_alloc::batch_calls == batches_for(src.size()));
+			CHECK(batch_counting_alloc::single_calls == 1);
+			// The batch's unused nodes went back; only the elements and the sentinel remain.
+			CHECK(batch_counting_alloc::live_objects == static_cast<long>(src.size()) + 1);
+
+			batch_counting_alloc::reset();
+			STL::list<int, batch_counting_alloc> unbatched;
+			for (int v : src)
+				unbatched.push_back(v);
+			CHECK(batch_counting_alloc::batch_calls == 0);
+			CHECK(batch_counting_alloc::single_calls == src.size() + 1);
+			CHECK(values(batched) == values(unbatched));
+			CHECK(values(batched) == src);
+		}
+		CHECK(batch_counting_alloc::live_objects == 0);
+
+		{
+			batch_counting_alloc::reset();
+			STL::slist<int, batch_counting_alloc> batched(src.begin(), src.end());
+			CHECK(batch_counting_alloc::batch_calls == batches_for(src.size()));
+			CHECK(batch_counting_alloc::single_calls == 0);
+			CHECK(values(batched) == src);
+		}
+		CHECK(batch_counting_alloc::live_objects == 0);
+
+		{
+			batch_counting_alloc::reset();
+			STL::set<int, STL::less<int>, batch_counting_alloc> batched(src.begin(), src.end());
+			CHECK(batch_counting_alloc::batch_calls == batches_for(src.size()));
+			CHECK(batch_counting_alloc::single_calls == 1);
+
+			batch_counting_alloc::reset();
+			STL::set<int, STL::less<int>, batch_counting_alloc> unbatched;
+			for (int v : src)
+				unbatched.insert(v);
+			CHECK(batch_counting_alloc::batch_calls == 0);
+			CHECK(values(batched) == values(unbatched));
+			CHECK(batched.size() == 200);
+		}
+		CHECK(batch_counting_alloc::live_objects == 0);
+
+		{
+			using hset = STL::hash_set<int, STL::hash<int>, STL::equal_to<int>, batch_counting_alloc>;
+			hset original(src.begin(), src.end());
+			batch_counting_alloc::reset();
+			hset copy(original);
+			CHECK(batch_counting_alloc::batch_calls == batches_for(original.size()));
+			CHECK(copy == original);
+			CHECK(copy.size() == original.size());
+		}
+		CHECK(batch_counting_alloc::live_objects == 0);
+	}
+}
+
+int main() {
+	pool_batch<STL::__default_alloc_template<false, 4> >(24);
+	pool_batch<STL::__default_alloc_template<false, 4> >(128);
+	pool_batch<STL::__default_alloc_template<true, 5> >(24);
+	pool_batch<STL::__default_alloc_template<true, 5, STL::__geometric_size_classes<> > >(200);
+	simple_alloc_batch();
+	containers_batched_and_unbatched();
+	return test::result();
+}
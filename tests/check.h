@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdio>
+
+// CHECK reports a failed condition and carries on; main returns
+// test::result() so that ctest sees the failure.
+
+namespace test {
+
+	inline int& failures() {
+		static int count = 0;
+		return count;
+	}
+
+	inline void fail(const char* expr, const char* file, int line) {
+		std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expr);
+		++failures();
+	}
+
+	inline int result() {
+		if (failures() != 0)
+			std::fprintf(stderr, "%d check(s) failed\n", failures());
+		return failures() != 0;
+	}
+}
+
+#define CHECK(cond) ((cond) ? (void)0 : test::fail(#cond, __FILE__, __LINE__))
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include "alloc.h"
+
+// Helpers shared by the container tests.
+
+namespace test {
+
+	// An element type with a nontrivial copy, move and destructor that
+	// keeps a count of live objects, so a test can tell that every element
+	// was destroyed exactly once. The count is atomic for the parallel
+	// algorithms, which construct and destroy on several threads.
+	struct counted {
+		static inline std::atomic<long> live{ 0 };
+		int value;
+		bool moved_from;
+
+		counted(int v = 0) : value(v), moved_from(false) { ++live; }
+		counted(const counted& rhs) : value(rhs.value), moved_from(false) { ++live; }
+		counted(counted&& rhs) noexcept : value(rhs.value), moved_from(false) {
+			rhs.moved_from = true;
+			++live;
+		}
+		counted& operator=(const counted& rhs) {
+			value = rhs.value;
+			moved_from = false;
+			return *this;
+		}
+		counted& operator=(counted&& rhs) noexcept {
+			value = rhs.value;
+			moved_from = false;
+			rhs.moved_from = true;
+			return *this;
+		}
+		~counted() { --live; }
+
+		bool operator==(int v) const { return value == v; }
+	};
+
+	// malloc underneath, counting calls and bytes outstanding.
+	struct counting_alloc {
+		static inline size_t allocations = 0;
+		static inline long live_bytes = 0;
+
+		static void* allocate(size_t n) {
+			++allocations;
+			live_bytes += static_cast<long>(n);
+			return STL::malloc_alloc::allocate(n);
+		}
+		static void deallocate(void* p, size_t n) {
+			live_bytes -= static_cast<long>(n);
+			STL::malloc_alloc::deallocate(p, n);
+		}
+	};
+
+	inline int value_of(int v) { return v; }
+	inline int value_of(const counted& c) { return c.value; }
+
+	// Compares a container's elements with the values in want.
+	template <class Container, class Values>
+	bool equals(Container& c, const Values& want) {
+		if (c.size() != want.size())
+			return false;
+		for (size_t i = 0; i < want.size(); ++i)
+			if (value_of(c[i]) != want[i])
+				return false;
+		return true;
+	}
+}
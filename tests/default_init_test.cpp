@@ -0,0 +1,155 @@
+#include <cstring>
+#include "uninitialized.h"
+#include "stl_vector.h"
+#include "stl_deque.h"
+#include "small_vector.h"
+#include "counted.h"
+#include "check.h"
+
+// Default-initialization: elements with a trivial default constructor keep
+// whatever bytes the storage held, anything else is still constructed, and
+// a constructor that throws leaves nothing behind. The containers get their
+// storage from an allocator that pre-fills it with a known byte.
+
+namespace {
+
+	using test::counted;
+
+	const unsigned char FILL = 0xab;
+
+	struct pattern_alloc {
+		static void* allocate(size_t n) {
+			void* p = STL::malloc_alloc::allocate(n);
+			std::memset(p, FILL, n);
+			return p;
+		}
+		static void deallocate(void* p, size_t n) { STL::malloc_alloc::deallocate(p, n); }
+	};
+
+	bool untouched(const void* p, size_t bytes) {
+		const unsigned char* b = static_cast<const unsigned char*>(p);
+		for (size_t i = 0; i < bytes; ++i)
+			if (b[i] != FILL)
+				return false;
+		return true;
+	}
+
+	// Not trivial to __type_traits, so it must be constructed.
+	struct made : counted {
+		made() : counted(42) { }
+	};
+
+	struct fragile : counted {
+		static inline int countdown = 0;
+		fragile() : counted(7) {
+			if (--countdown == 0)
+				throw 1;
+		}
+	};
+
+	void primitive() {
+		alignas(double) unsigned char raw[64 * sizeof(double)];
+		std::memset(raw, FILL, sizeof(raw));
+		double* d = reinterpret_cast<double*>(raw);
+		CHECK(STL::uninitialized_default_init_n(d, 64) == d + 64);
+		CHECK(untouched(raw, sizeof(raw)));
+
+		alignas(made) unsigned char storage[16 * sizeof(made)];
+		made* m = reinterpret_cast<made*>(storage);
+		CHECK(STL::uninitialized_default_init_n(m, 16) == m + 16);
+		CHECK(counted::live == 16);
+		bool built = true;
+		for (int i = 0; i < 16; ++i)
+			built = built && m[i].value == 42;
+		CHECK(built);
+		STL::destroy(m, m + 16);
+		CHECK(counted::live == 0);
+
+		alignas(fragile) unsigned char fragile_storage[16 * sizeof(fragile)];
+		fragile* f = reinterpret_cast<fragile*>(fragile_storage);
+		fragile::countdown = 10;
+		bool threw = false;
+		try {
+			STL::uninitialized_default_init_n(f, 16);
+		}
+		catch (int) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(counted::live == 0);
+	}
+
+	void containers() {
+		{
+			STL::vector<int, pattern_alloc> v(1000, STL::default_init);
+			CHECK(v.size() == 1000);
+			CHECK(untouched(&v[0], 1000 * sizeof(int)));
+
+			// Value-initialization still zeroes.
+			STL::vector<int, pattern_alloc> z(1000);
+			bool zero = true;
+			for (size_t i = 0; i < z.size(); ++i)
+				zero = zero && z[i] == 0;
+			CHECK(zero);
+
+			v[0] = 5;
+			v.resize_default_init(3000);
+			CHECK(v.size() == 3000);
+			CHECK(v[0] == 5);
+			CHECK(untouched(&v[1000], 2000 * sizeof(int)));
+			v.resize_default_init(10);
+			CHECK(v.size() == 10);
+		}
+
+		{
+			STL::deque<int, pattern_alloc> d(1000, STL::default_init);
+			CHECK(d.size() == 1000);
+			bool kept = true;
+			for (size_t i = 0; i < d.size(); ++i)
+				kept = kept && untouched(&d[i], sizeof(int));
+			CHECK(kept);
+			d.resize_default_init(5000);
+			kept = true;
+			for (size_t i = 1000; i < d.size(); ++i)
+				kept = kept && untouched(&d[i], sizeof(int));
+			CHECK(kept);
+		}
+
+		{
+			STL::small_vector<int, 4, pattern_alloc> s(100, STL::default_init);
+			CHECK(!s.is_inline());
+			CHECK(untouched(&s[0], 100 * sizeof(int)));
+		}
+
+		{
+			STL::vector<made, pattern_alloc> v(100, STL::default_init);
+			CHECK(counted::live == 100);
+			CHECK(v[99].value == 42);
+			v.resize_default_init(300);
+			CHECK(counted::live == 300);
+			CHECK(v[299].value == 42);
+
+			STL::deque<made, pattern_alloc> d(500, STL::default_init);
+			CHECK(counted::live == 800);
+			CHECK(d[499].value == 42);
+		}
+		CHECK(counted::live == 0);
+
+		fragile::countdown = 50;
+		bool threw = false;
+		try {
+			STL::vector<fragile> v(100, STL::default_init);
+		}
+		catch (int) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(counted::live == 0);
+	}
+}
+
+int main() {
+	primitive();
+	containers();
+	return test::result();
+}
@@ -0,0 +1,182 @@
+#include <deque>
+#include "stl_deque.h"
+#include "counted.h"
+#include "check.h"
+
+// deque under each block policy: node sizes first, then the same
+// push/pop/insert/erase workload checked against std::deque.
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+
+	struct big512 { char bytes[512]; };
+	struct big1000 { char bytes[1000]; };
+
+	using classic = STL::__deque_classic_block;
+	using paged = STL::__deque_paged_block<>;
+	using paged_16k = STL::__deque_paged_block<16384, 32>;
+	using huge = STL::__deque_huge_block<>;
+
+	void block_sizes() {
+		// 512-byte nodes, and one element per node from 512 bytes up.
+		CHECK(classic::elements(1) == 512);
+		CHECK(classic::elements(4) == 128);
+		CHECK(classic::elements(511) == 1);
+		CHECK(classic::elements(512) == 1);
+		CHECK(classic::elements(4096) == 1);
+
+		// A page, or MinElements rounded up to whole pages.
+		CHECK(paged::elements(4) == 1024);
+		CHECK(paged::elements(24) == 4096 / 24);
+		CHECK(paged::elements(512) == 8);
+		CHECK(paged::elements(1000) == 8192 / 1000);
+		CHECK(paged::elements(4096) == 8);
+		CHECK(paged_16k::elements(4) == 4096);
+		CHECK(paged_16k::elements(1000) == 32768 / 1000);
+
+		// Whole huge pages.
+		const size_t hp = STL::__HUGE_PAGE_BYTES;
+		CHECK(huge::elements(4) == hp / 4);
+		CHECK(huge::elements(512) == hp / 512);
+		CHECK(huge::elements(1024 * 1024) == 8);
+
+		// Every policy's node holds at least MinElements and fits its block.
+		const size_t sizes[] = { 1, 3, 8, 24, 100, 512, 1000, 5000 };
+		for (size_t sz : sizes) {
+			CHECK(paged::elements(sz) >= 8);
+			CHECK(paged::elements(sz) * sz <= STL::__deque_round_up(8 * sz > 4096 ? 8 * sz : 4096, 4096));
+			CHECK(huge::elements(sz) >= 8);
+		}
+
+		// The iterator sees the policy, and a nonzero Bufsiz still wins.
+		CHECK((STL::deque<int, STL::alloc, 0, paged>::iterator::buffer_size() == 1024));
+		CHECK((STL::deque<big512, STL::alloc, 0, paged>::iterator::buffer_size() == 8));
+		CHECK((STL::deque<big512>::iterator::buffer_size() == 1));
+		CHECK((STL::deque<int, STL::alloc, 16, paged>::iterator::buffer_size() == 16));
+	}
+
+	template <class T, size_t Bufsiz, class Block>
+	void workload() {
+		STL::deque<T, counting_alloc, Bufsiz, Block> d;
+		std::deque<int> want;
+		CHECK(d.empty());
+		for (int i = 0; i < 3000; ++i) {
+			if (i % 3 == 0) {
+				d.push_front(T(i));
+				want.push_front(i);
+			}
+			else {
+				d.push_back(T(i));
+				want.push_back(i);
+			}
+		}
+		CHECK(test::equals(d, want));
+		CHECK(test::value_of(d.front()) == want.front());
+		CHECK(test::value_of(d.back()) == want.back());
+
+		size_t n = 0;
+		bool ok = true;
+		for (auto it = d.begin(); it != d.end(); ++it, ++n)
+			ok = ok && test::value_of(*it) == want[n];
+		CHECK(ok && n == want.size());
+
+		for (int i = 0; i < 40; ++i) {
+			const size_t at = (i * 37) % want.size();
+			d.insert(d.begin() + at, T(-i));
+			want.insert(want.begin() + at, -i);
+		}
+		CHECK(test::equals(d, want));
+
+		for (int i = 0; i < 40; ++i) {
+			const size_t at = (i * 53) % want.size();
+			d.erase(d.begin() + at);
+			want.erase(want.begin() + at);
+		}
+		CHECK(test::equals(d, want));
+
+		d.erase(d.begin() + 10, d.begin() + 500);
+		want.erase(want.begin() + 10, want.begin() + 500);
+		CHECK(test::equals(d, want));
+		d.erase(d.end() - 700, d.end() - 5);
+		want.erase(want.end() - 700, want.end() - 5);
+		CHECK(test::equals(d, want));
+
+		for (int i = 0; i < 300; ++i) {
+			d.pop_front();
+			want.pop_front();
+			d.pop_back();
+			want.pop_back();
+		}
+		CHECK(test::equals(d, want));
+
+		d.clear();
+		CHECK(d.empty());
+		d.push_back(T(1));
+		d.push_front(T(0));
+		CHECK(d.size() == 2 && test::value_of(d[0]) == 0 && test::value_of(d[1]) == 1);
+	}
+
+	// Copying a negative value throws an int, which is not a std::exception.
+	struct throws_int {
+		int value;
+		throws_int(int v) : value(v) { }
+		throws_int(const throws_int& rhs) : value(rhs.value) {
+			if (rhs.value < 0)
+				throw rhs.value;
+		}
+	};
+
+	// A throw while building the element in a fresh node must give the
+	// node back, at either end.
+	void throw_at_node_boundary() {
+		{
+			STL::deque<throws_int, counting_alloc, 4> d;
+			for (int i = 0; i < 3; ++i)
+				d.push_back(throws_int(i));
+			const long bytes = counting_alloc::live_bytes;
+			const throws_int bad(-1);
+			bool thrown = false;
+			try {
+				d.push_back(bad);
+			}
+			catch (int) {
+				thrown = true;
+			}
+			CHECK(thrown && counting_alloc::live_bytes == bytes);
+			thrown = false;
+			try {
+				d.push_front(bad);
+			}
+			catch (int) {
+				thrown = true;
+			}
+			CHECK(thrown && counting_alloc::live_bytes == bytes);
+			CHECK(d.size() == 3 && d.front().value == 0 && d.back().value == 2);
+		}
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	template <class T, size_t Bufsiz, class Block>
+	void run_workload() {
+		const long live = counted::live;
+		workload<T, Bufsiz, Block>();
+		CHECK(counted::live == live);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+}
+
+int main() {
+	block_sizes();
+	run_workload<int, 0, classic>();
+	run_workload<counted, 0, classic>();
+	run_workload<counted, 4, classic>();
+	run_workload<int, 0, paged>();
+	run_workload<counted, 0, paged>();
+	run_workload<counted, 0, paged_16k>();
+	run_workload<int, 0, huge>();
+	run_workload<counted, 0, huge>();
+	throw_at_node_boundary();
+	return test::result();
+}
@@ -0,0 +1,112 @@
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "stl_algobase.h"
+#include "uninitialized.h"
+#include "check.h"
+
+// fill, fill_n and copy of bytewise-copyable types go through memset, the
+// vector fill kernels or memmove. Every width, length and alignment must
+// come out as the element-by-element loop would.
+
+namespace {
+
+	struct rgb { unsigned char r, g, b; };
+	struct pair16 { uint64_t lo, hi; };
+	struct wide { uint32_t v[9]; };
+
+	bool same(const void* a, const void* b, size_t bytes) { return bytes == 0 || std::memcmp(a, b, bytes) == 0; }
+
+	template <class T>
+	void test_fill(const T& value) {
+		const size_t lengths[] = { 0, 1, 2, 3, 7, 15, 16, 17, 31, 33, 64, 100, 257, 1000, 4099 };
+		for (size_t n : lengths) {
+			for (size_t offset = 0; offset < 3; ++offset) {
+				// Guard elements on both sides catch writes out of range.
+				std::vector<T> got(n + offset + 2), want(n + offset + 2);
+				std::memset(static_cast<void*>(got.data()), 0x11, got.size() * sizeof(T));
+				std::memset(static_cast<void*>(want.data()), 0x11, want.size() * sizeof(T));
+				T* first = got.data() + offset + 1;
+				for (size_t i = 0; i < n; ++i)
+					want[offset + 1 + i] = value;
+
+				STL::fill(first, first + n, value);
+				CHECK(same(got.data(), want.data(), got.size() * sizeof(T)));
+
+				std::memset(static_cast<void*>(got.data()), 0x11, got.size() * sizeof(T));
+				CHECK(STL::fill_n(first, n, value) == first + n);
+				CHECK(same(got.data(), want.data(), got.size() * sizeof(T)));
+
+				std::memset(static_cast<void*>(got.data()), 0x11, got.size() * sizeof(T));
+				CHECK(STL::uninitialized_fill_n(first, n, value) == first + n);
+				CHECK(same(got.data(), want.data(), got.size() * sizeof(T)));
+			}
+		}
+	}
+
+	template <class T>
+	void test_copy() {
+		const size_t lengths[] = { 0, 1, 5, 64, 1000 };
+		for (size_t n : lengths) {
+			std::vector<T> src(n), dst(n + 2);
+			unsigned char* bytes = reinterpret_cast<unsigned char*>(src.data());
+			for (size_t i = 0; i < n * sizeof(T); ++i)
+				bytes[i] = static_cast<unsigned char>(i * 7 + 3);
+			std::memset(static_cast<void*>(dst.data()), 0, dst.size() * sizeof(T));
+
+			CHECK(STL::copy(src.data(), src.data() + n, dst.data() + 1) == dst.data() + 1 + n);
+			CHECK(same(src.data(), dst.data() + 1, n * sizeof(T)));
+
+			std::memset(static_cast<void*>(dst.data()), 0, dst.size() * sizeof(T));
+			CHECK(STL::uninitialized_copy(src.data(), src.data() + n, dst.data() + 1) == dst.data() + 1 + n);
+			CHECK(same(src.data(), dst.data() + 1, n * sizeof(T)));
+		}
+	}
+
+	// Overlapping ranges: copy shifts left, copy_backward shifts right.
+	void test_overlap() {
+		std::vector<int> v(100), want(100);
+		for (int i = 0; i < 100; ++i)
+			v[i] = i;
+
+		want = v;
+		for (int i = 0; i < 90; ++i)
+			want[i] = want[i + 10];
+		STL::copy(v.data() + 10, v.data() + 100, v.data());
+		CHECK(v == want);
+
+		for (int i = 0; i < 100; ++i)
+			v[i] = want[i] = i;
+		for (int i = 99; i >= 10; --i)
+			want[i] = want[i - 10];
+		CHECK(STL::copy_backward(v.data(), v.data() + 90, v.data() + 100) == v.data() + 10);
+		CHECK(v == want);
+	}
+
+	void test_all() {
+		test_fill<char>('x');
+		test_fill<unsigned char>(0);
+		test_fill<short>(static_cast<short>(0x0102));
+		test_fill<int>(-1);
+		test_fill<int>(0x01020304);
+		test_fill<double>(1.5);
+		test_fill<rgb>(rgb{ 1, 2, 3 });
+		test_fill<pair16>(pair16{ 0x0102030405060708ULL, 0x1112131415161718ULL });
+		test_fill<wide>(wide{ { 1, 2, 3, 4, 5, 6, 7, 8, 9 } });
+
+		test_copy<char>();
+		test_copy<int>();
+		test_copy<pair16>();
+		test_copy<wide>();
+		test_overlap();
+	}
+}
+
+int main() {
+	test_all();
+	// Again with every range long enough to stream taking the non-temporal path.
+	const size_t old = STL::set_nontemporal_threshold(1);
+	test_all();
+	STL::set_nontemporal_threshold(old);
+	return test::result();
+}
@@ -0,0 +1,147 @@
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include "hash_set.h"
+#include "hash_map.h"
+#include "hash_multiset.h"
+#include "hash_multimap.h"
+#include "counted.h"
+#include "check.h"
+
+// The hashtable containers: emplace with move-only and counted values,
+// copies, and a random insert/erase workload against the std unordered
+// containers that grows the table through several resizes.
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+
+	struct counted_hash {
+		size_t operator()(const counted& c) const { return static_cast<size_t>(c.value); }
+	};
+
+	struct counted_equal {
+		bool operator()(const counted& a, const counted& b) const { return a.value == b.value; }
+	};
+
+	unsigned next_random(unsigned& state) {
+		state = state * 1103515245u + 12345u;
+		return state >> 16;
+	}
+
+	void emplace_move_only() {
+		STL::hash_map<int, std::unique_ptr<int>> m;
+		CHECK(m.emplace(2, new int(20)).second);
+		CHECK(m.emplace(1, std::make_unique<int>(10)).second);
+		CHECK(!m.emplace(2, new int(99)).second);
+		CHECK(m.size() == 2);
+		CHECK(*m.find(2)->second == 20);
+		CHECK(m.find(3) == m.end());
+
+		STL::hash_multimap<int, std::unique_ptr<int>> mm;
+		mm.emplace(1, new int(1));
+		mm.emplace(1, new int(2));
+		mm.emplace(0, new int(0));
+		CHECK(mm.size() == 3);
+		CHECK(mm.count(1) == 2);
+		auto range = mm.equal_range(1);
+		int sum = 0;
+		for (; range.first != range.second; ++range.first)
+			sum += *range.first->second;
+		CHECK(sum == 3);
+	}
+
+	void emplace_counted() {
+		{
+			STL::hash_set<counted, counted_hash, counted_equal, counting_alloc> s;
+			for (int i = 0; i < 400; ++i)
+				CHECK(s.emplace(i % 200).second == (i < 200));
+			CHECK(s.size() == 200);
+			CHECK(counted::live == 200);
+
+			counted c(1000);
+			CHECK(s.insert(std::move(c)).second);
+			CHECK(c.moved_from);
+
+			STL::hash_multiset<counted, counted_hash, counted_equal, counting_alloc> ms;
+			for (int i = 0; i < 400; ++i)
+				ms.emplace(i % 200);
+			CHECK(ms.size() == 400);
+			CHECK(ms.count(counted(7)) == 2);
+
+			STL::hash_set<counted, counted_hash, counted_equal, counting_alloc> copy(s);
+			CHECK(copy.size() == s.size());
+			CHECK(copy.count(counted(1000)) == 1);
+			// c, moved from, is still alive.
+			CHECK(counted::live == 1 + 201 + 400 + 201);
+
+			ms.erase(counted(7));
+			CHECK(ms.size() == 398);
+			ms.clear();
+			CHECK(ms.empty());
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	void against_std() {
+		STL::hash_set<int> s;
+		std::unordered_set<int> want;
+		STL::hash_multimap<int, int> mm;
+		std::unordered_multimap<int, int> mm_want;
+		unsigned state = 1;
+		for (int i = 0; i < 20000; ++i) {
+			int k = static_cast<int>(next_random(state) % 3000);
+			if (next_random(state) % 4 == 0) {
+				CHECK(s.erase(k) == want.erase(k));
+				CHECK(mm.erase(k) == mm_want.erase(k));
+			}
+			else {
+				CHECK(s.insert(k).second == want.insert(k).second);
+				mm.insert(std::pair<const int, int>(k, i));
+				mm_want.emplace(k, i);
+			}
+		}
+		CHECK(s.size() == want.size());
+		CHECK(s.bucket_count() >= s.size());
+		size_t seen = 0;
+		bool all_found = true;
+		for (auto it = s.begin(); it != s.end(); ++it, ++seen)
+			all_found = all_found && want.count(*it) == 1;
+		CHECK(all_found);
+		CHECK(seen == want.size());
+
+		CHECK(mm.size() == mm_want.size());
+		bool counts_match = true;
+		for (auto& kv : mm_want)
+			counts_match = counts_match && mm.count(kv.first) == mm_want.count(kv.first);
+		CHECK(counts_match);
+
+		STL::hash_set<int> copied(s);
+		CHECK(copied == s);
+		copied.erase(*copied.begin());
+		CHECK(!(copied == s));
+
+		STL::hash_map<int, int> m;
+		m[3] = 30;
+		m[1] = 10;
+		m[3] += 1;
+		CHECK(m.size() == 2);
+		CHECK(m[3] == 31);
+
+		int raw[] = { 5, 1, 4, 1, 3 };
+		STL::hash_set<int> ranged(raw, raw + 5);
+		CHECK(ranged.size() == 4);
+		STL::hash_multiset<int> multi(raw, raw + 5);
+		CHECK(multi.size() == 5);
+		CHECK(multi.count(1) == 2);
+	}
+}
+
+int main() {
+	emplace_move_only();
+	emplace_counted();
+	against_std();
+	return test::result();
+}
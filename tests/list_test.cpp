@@ -0,0 +1,107 @@
+#include <memory>
+#include <vector>
+#include "stl_list.h"
+#include "counted.h"
+#include "check.h"
+
+// list: emplace with move-only and counted elements, the range and fill
+// constructors that take their nodes from a batch, and the splicing members.
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+
+	template <class List>
+	std::vector<int> values(const List& l) {
+		std::vector<int> out;
+		for (auto it = l.begin(); it != l.end(); ++it)
+			out.push_back(test::value_of(*it));
+		return out;
+	}
+
+	void emplace_move_only() {
+		STL::list<std::unique_ptr<int>> l;
+		l.emplace_back(new int(2));
+		l.emplace_front(new int(1));
+		auto it = l.emplace(l.end(), new int(3));
+		CHECK(**it == 3);
+		l.push_back(std::make_unique<int>(4));
+		CHECK(l.size() == 4);
+		CHECK(*l.front() == 1);
+		CHECK(*l.back() == 4);
+
+		STL::list<std::unique_ptr<int>> moved(std::move(l));
+		CHECK(l.empty());
+		CHECK(moved.size() == 4);
+		int want = 1;
+		for (auto& p : moved)
+			CHECK(*p == want++);
+	}
+
+	void emplace_counted() {
+		{
+			STL::list<counted, counting_alloc> l;
+			for (int i = 0; i < 100; ++i)
+				l.emplace_back(i);
+			CHECK(counted::live == 100);
+			counted c(100);
+			l.push_back(std::move(c));
+			CHECK(c.moved_from);
+			CHECK(l.back() == 100);
+			l.pop_front();
+			CHECK(l.front() == 1);
+			CHECK(l.size() == 100);
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	void construct_and_copy() {
+		{
+			int raw[] = { 5, 3, 8, 1, 9, 2 };
+			STL::list<counted, counting_alloc> a(raw, raw + 6);
+			CHECK((values(a) == std::vector<int>{ 5, 3, 8, 1, 9, 2 }));
+
+			STL::list<counted, counting_alloc> b(a);
+			CHECK(values(b) == values(a));
+			CHECK(counted::live == 12);
+
+			STL::list<counted, counting_alloc> c(size_t(3), counted(7));
+			CHECK((values(c) == std::vector<int>{ 7, 7, 7 }));
+			c = b;
+			CHECK(values(c) == values(a));
+			CHECK(counted::live == 18);
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	void reorder() {
+		int raw[] = { 5, 3, 8, 1, 9, 2 };
+		STL::list<int> a(raw, raw + 6);
+		a.reverse();
+		CHECK((values(a) == std::vector<int>{ 2, 9, 1, 8, 3, 5 }));
+		a.sort();
+		CHECK((values(a) == std::vector<int>{ 1, 2, 3, 5, 8, 9 }));
+
+		int more[] = { 0, 4, 10 };
+		STL::list<int> b(more, more + 3);
+		a.merge(b);
+		CHECK(b.empty());
+		CHECK((values(a) == std::vector<int>{ 0, 1, 2, 3, 4, 5, 8, 9, 10 }));
+
+		a.remove(4);
+		a.push_back(10);
+		a.unique();
+		CHECK((values(a) == std::vector<int>{ 0, 1, 2, 3, 5, 8, 9, 10 }));
+	}
+}
+
+int main() {
+	emplace_move_only();
+	emplace_counted();
+	construct_and_copy();
+	reorder();
+	return test::result();
+}
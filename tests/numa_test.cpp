@@ -0,0 +1,88 @@
+#include <set>
+#include <thread>
+#include <vector>
+#include "numa_alloc.h"
+#include "check.h"
+
+// The per-node pools under simulated nodes: threads are spread over the
+// nodes, every block a thread gets comes from a chunk of its own node's
+// pool, and frees from another thread find their way back by chunk.
+
+namespace {
+
+	using policy = STL::__numa_node_policy<4>;
+	using numa = STL::__numa_alloc_template<true, 12, STL::__default_size_classes, STL::__chunk_source, policy>;
+
+	void simulated_nodes() {
+		policy::simulate(3);
+		CHECK(policy::nodes() == 3);
+
+		const int THREADS = 6;
+		const int PER = 500;
+		const int BATCH = 64;
+		const size_t BYTES = 48;
+		std::vector<size_t> node(THREADS);
+		std::vector<int> stable(THREADS, 0);
+		std::vector<int> own_node(THREADS, 0);
+		std::vector<std::vector<void*> > blocks(THREADS);
+		std::vector<std::thread> threads;
+		for (int t = 0; t < THREADS; ++t)
+			threads.emplace_back([&, t] {
+				node[t] = policy::current();
+				blocks[t].resize(PER + BATCH);
+				for (int i = 0; i < PER; ++i)
+					blocks[t][i] = numa::allocate(BYTES);
+				numa::allocate_batch(BYTES, BATCH, &blocks[t][PER]);
+				stable[t] = policy::current() == node[t];
+				bool own = true;
+				for (void* p : blocks[t])
+					own = own && numa::node_of(p) == node[t];
+				own_node[t] = own;
+			});
+		for (auto& th : threads)
+			th.join();
+
+		CHECK(stable == std::vector<int>(THREADS, 1));
+		CHECK(own_node == std::vector<int>(THREADS, 1));
+		// Consecutive threads take the nodes in turn.
+		CHECK(std::set<size_t>(node.begin(), node.end()) == (std::set<size_t>{ 0, 1, 2 }));
+
+		std::set<void*> distinct;
+		for (auto& b : blocks)
+			distinct.insert(b.begin(), b.end());
+		CHECK(distinct.size() == static_cast<size_t>(THREADS * (PER + BATCH)));
+
+		// The main thread frees everything, interleaving the nodes so the
+		// batch free has to split the array into runs.
+		std::vector<void*> mixed;
+		for (int i = 0; i < PER + BATCH; ++i)
+			for (int t = 0; t < THREADS; ++t)
+				mixed.push_back(blocks[t][i]);
+		numa::deallocate_batch(BYTES, mixed.size() / 2, mixed.data());
+		for (size_t i = mixed.size() / 2; i < mixed.size(); ++i)
+			numa::deallocate(mixed[i], BYTES);
+
+		// Large requests bypass the node pools.
+		void* big = numa::allocate(4096);
+		CHECK(big != nullptr);
+		numa::deallocate(big, 4096);
+		numa::trim();
+		policy::simulate(0);
+	}
+
+	// Without simulation the node comes from the CPU, cached per thread.
+	void real_nodes() {
+		using real = STL::__numa_node_policy<8>;
+		CHECK(real::nodes() >= 1);
+		bool in_range = true;
+		for (int i = 0; i < 5000; ++i)
+			in_range = in_range && real::current() < static_cast<size_t>(real::max_nodes);
+		CHECK(in_range);
+	}
+}
+
+int main() {
+	simulated_nodes();
+	real_nodes();
+	return test::result();
+}
@@ -0,0 +1,158 @@
+#include <cstdint>
+#include <vector>
+#include "object_pool.h"
+#include "stl_list.h"
+#include "stl_set.h"
+#include "check.h"
+
+// object_pool: lowest-address-first reuse, the occupancy counts as slabs
+// fill and drain, the one spare empty slab and trim(), then the list and
+// set nodes that come from it by default.
+
+namespace {
+
+	struct node24 { void* links[2]; int value; };
+
+	using pool = STL::object_pool<node24, false, 1>;
+
+	void address_order(std::vector<node24*>& a) {
+		const size_t cap = pool::occupancy().objects_per_slab;
+		CHECK(cap >= STL::__SLAB_MIN_OBJECTS);
+		a.resize(2 * cap);
+		for (size_t i = 0; i < a.size(); ++i)
+			a[i] = pool::allocate();
+
+		// Each slab is handed out front to back.
+		bool packed = true;
+		for (size_t i = 1; i < a.size(); ++i)
+			if (i != cap)
+				packed = packed && a[i] == a[i - 1] + 1;
+		CHECK(packed);
+
+		STL::slab_occupancy o = pool::occupancy();
+		CHECK(o.slabs == 2);
+		CHECK(o.full_slabs == 2);
+		CHECK(o.partial_slabs == 0);
+		CHECK(o.empty_slabs == 0);
+		CHECK(o.live_objects == 2 * cap);
+
+		// Freed slots come back lowest first, whatever order they were freed
+		// in, including across bitmap words.
+		const size_t holes[] = { 100, 9, 70, 2, 5 };
+		for (size_t h : holes)
+			pool::deallocate(a[h]);
+		o = pool::occupancy();
+		CHECK(o.full_slabs == 1);
+		CHECK(o.partial_slabs == 1);
+		CHECK(o.live_objects == 2 * cap - 5);
+		CHECK(pool::allocate() == a[2]);
+		CHECK(pool::allocate() == a[5]);
+		CHECK(pool::allocate() == a[9]);
+		CHECK(pool::allocate() == a[70]);
+		CHECK(pool::allocate() == a[100]);
+		o = pool::occupancy();
+		CHECK(o.full_slabs == 2);
+		CHECK(o.partial_slabs == 0);
+
+		// A slab that regains room queues behind the one being filled.
+		pool::deallocate(a[cap + 1]);
+		pool::deallocate(a[3]);
+		CHECK(pool::allocate() == a[cap + 1]);
+		CHECK(pool::allocate() == a[3]);
+	}
+
+	void empty_slabs(std::vector<node24*>& a) {
+		const size_t cap = a.size() / 2;
+
+		// The first slab to drain is kept as the spare.
+		for (size_t i = 0; i < cap; ++i)
+			pool::deallocate(a[i]);
+		STL::slab_occupancy o = pool::occupancy();
+		CHECK(o.slabs == 2);
+		CHECK(o.full_slabs == 1);
+		CHECK(o.partial_slabs == 0);
+		CHECK(o.empty_slabs == 1);
+		CHECK(o.live_objects == cap);
+
+		// A second one goes back to the system.
+		for (size_t i = cap; i < a.size(); ++i)
+			pool::deallocate(a[i]);
+		o = pool::occupancy();
+		CHECK(o.slabs == 1);
+		CHECK(o.full_slabs == 0);
+		CHECK(o.empty_slabs == 1);
+		CHECK(o.live_objects == 0);
+
+		// The spare is reused before a new slab is made.
+		node24* p = pool::allocate();
+		CHECK(p == a[0]);
+		CHECK(pool::occupancy().slabs == 1);
+		CHECK(pool::occupancy().empty_slabs == 0);
+		pool::deallocate(p);
+
+		CHECK(pool::trim() == o.slab_bytes);
+		CHECK(pool::trim() == 0);
+		o = pool::occupancy();
+		CHECK(o.slabs == 0);
+		CHECK(o.empty_slabs == 0);
+
+		p = pool::allocate();
+		CHECK(p != nullptr);
+		CHECK(pool::occupancy().slabs == 1);
+		pool::deallocate(p);
+		pool::trim();
+	}
+
+	// Counts neighbours in iteration order that sit next to each other.
+	template <class Container>
+	size_t adjacent(const Container& c, size_t node_bytes) {
+		size_t n = 0;
+		const char* prev = nullptr;
+		for (auto it = c.begin(); it != c.end(); ++it) {
+			const char* cur = reinterpret_cast<const char*>(&*it);
+			if (prev != nullptr && cur - prev == static_cast<std::ptrdiff_t>(node_bytes))
+				++n;
+			prev = cur;
+		}
+		return n;
+	}
+
+	void containers() {
+		const int N = 1000;
+		{
+			using nodes = STL::object_pool<STL::__list_node<int> >;
+			STL::list<int> l;
+			for (int i = 0; i < N; ++i)
+				l.push_back(i);
+			// The elements and the sentinel.
+			CHECK(nodes::occupancy().live_objects == N + 1);
+			const size_t per_slab = nodes::occupancy().objects_per_slab;
+			CHECK(adjacent(l, sizeof(STL::__list_node<int>)) >= N - 1 - N / per_slab - 1);
+
+			STL::list<int> copy(l);
+			CHECK(nodes::occupancy().live_objects == 2 * (N + 1));
+		}
+		CHECK(STL::object_pool<STL::__list_node<int> >::occupancy().live_objects == 0);
+
+		{
+			using nodes = STL::object_pool<STL::__rb_tree_node<int> >;
+			STL::set<int> s;
+			for (int i = 0; i < N; ++i)
+				s.insert(i);
+			CHECK(nodes::occupancy().live_objects == N + 1);
+			const size_t per_slab = nodes::occupancy().objects_per_slab;
+			CHECK(adjacent(s, sizeof(STL::__rb_tree_node<int>)) >= N - 1 - N / per_slab - 1);
+			s.erase(500);
+			CHECK(nodes::occupancy().live_objects == N);
+		}
+		CHECK(STL::object_pool<STL::__rb_tree_node<int> >::occupancy().live_objects == 0);
+	}
+}
+
+int main() {
+	std::vector<node24*> a;
+	address_order(a);
+	empty_slabs(a);
+	containers();
+	return test::result();
+}
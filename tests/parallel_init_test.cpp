@@ -0,0 +1,109 @@
+#include <atomic>
+#include <new>
+#include <stdexcept>
+#include "parallel_uninitialized.h"
+#include "stl_vector.h"
+#include "counted.h"
+#include "check.h"
+
+// The parallel fill, copy and destroy above __PARALLEL_MIN_BYTES, with the
+// pool fixed at four threads: a chunk that throws leaves no element alive
+// in the destination, and a large vector is filled and destroyed in chunks
+// with every element built and destroyed exactly once.
+
+namespace {
+
+	using test::counted;
+
+	// Copies throw once, when the countdown reaches zero.
+	struct fragile : counted {
+		static inline std::atomic<long> countdown{ 0 };
+
+		fragile(int v = 0) : counted(v) { }
+		fragile(const fragile& rhs) : counted(rhs) {
+			if (countdown.fetch_sub(1) == 1)
+				throw std::runtime_error("fragile copy");
+		}
+	};
+
+	const size_t N = STL::__PARALLEL_MIN_BYTES / sizeof(fragile) + 1000;
+
+	void chunking() {
+		CHECK(STL::__worker_pool::available());
+		CHECK(STL::__worker_pool::instance().size() == 4);
+		STL::__parallel_chunks chunks(N, sizeof(fragile));
+		CHECK(chunks.count == 4);
+		CHECK(chunks.begin(0) == 0);
+		CHECK(chunks.end(chunks.count - 1) == N);
+		STL::__parallel_chunks small(1000, sizeof(fragile));
+		CHECK(small.count == 1);
+	}
+
+	void throwing_chunk(fragile* buf) {
+		{
+			fragile value(7);
+			fragile::countdown = static_cast<long>(N / 2);
+			bool threw = false;
+			try {
+				STL::parallel_uninitialized_fill_n(buf, N, value);
+			}
+			catch (const std::runtime_error&) {
+				threw = true;
+			}
+			CHECK(threw);
+			// Only value is left: the failed chunk and the finished ones were
+			// all unwound.
+			CHECK(counted::live == 1);
+		}
+		CHECK(counted::live == 0);
+
+		STL::vector<fragile> src(N);
+		for (size_t i = 0; i < N; ++i)
+			src[i].value = static_cast<int>(i);
+		CHECK(counted::live == static_cast<long>(N));
+
+		fragile::countdown = static_cast<long>(N / 3);
+		bool threw = false;
+		try {
+			STL::parallel_uninitialized_copy(src.begin(), src.end(), buf);
+		}
+		catch (const std::runtime_error&) {
+			threw = true;
+		}
+		CHECK(threw);
+		CHECK(counted::live == static_cast<long>(N));
+
+		fragile::countdown = 0;
+		STL::parallel_uninitialized_copy(src.begin(), src.end(), buf);
+		CHECK(counted::live == 2 * static_cast<long>(N));
+		bool copied = true;
+		for (size_t i = 0; i < N; ++i)
+			copied = copied && buf[i].value == static_cast<int>(i);
+		CHECK(copied);
+		STL::parallel_destroy(buf, buf + N);
+		CHECK(counted::live == static_cast<long>(N));
+	}
+
+	void large_vector() {
+		{
+			STL::vector<counted> v(N, counted(5));
+			CHECK(counted::live == static_cast<long>(N));
+			bool filled = true;
+			for (size_t i = 0; i < N; ++i)
+				filled = filled && v[i].value == 5;
+			CHECK(filled);
+		}
+		// The destructor went through parallel_destroy.
+		CHECK(counted::live == 0);
+	}
+}
+
+int main() {
+	chunking();
+	fragile* buf = static_cast<fragile*>(::operator new(N * sizeof(fragile)));
+	throwing_chunk(buf);
+	::operator delete(buf);
+	CHECK(counted::live == 0);
+	large_vector();
+	return test::result();
+}
@@ -0,0 +1,143 @@
+#include <vector>
+#include "segmented_vector.h"
+#include "counted.h"
+#include "check.h"
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+
+	template <class T, size_t Segsiz>
+	using seg_vector = STL::segmented_vector<T, counting_alloc, Segsiz>;
+
+	template <class T, size_t Segsiz>
+	void push_and_index(size_t n) {
+		seg_vector<T, Segsiz> v;
+		CHECK(v.empty());
+		CHECK(v.size() == 0);
+		CHECK(v.segment_count() == 0);
+		for (size_t i = 0; i < n; ++i)
+			CHECK(test::value_of(v.emplace_back(static_cast<int>(i))) == static_cast<int>(i));
+		CHECK(v.size() == n);
+		bool ok = true;
+		for (size_t i = 0; i < n; ++i)
+			ok = ok && test::value_of(v[i]) == static_cast<int>(i);
+		CHECK(ok);
+		CHECK(test::value_of(v.front()) == 0);
+		CHECK(test::value_of(v.back()) == static_cast<int>(n - 1));
+
+		size_t i = 0;
+		ok = true;
+		for (auto it = v.begin(); it != v.end(); ++it, ++i)
+			ok = ok && test::value_of(*it) == static_cast<int>(i);
+		CHECK(ok && i == n);
+	}
+
+	// Growth never moves an element.
+	template <class T, size_t Segsiz>
+	void stable_addresses() {
+		seg_vector<T, Segsiz> v;
+		std::vector<const T*> where;
+		for (int i = 0; i < 5000; ++i) {
+			v.push_back(T(i));
+			if (i % 97 == 0)
+				where.push_back(&v[i]);
+		}
+		for (int i = 5000; i < 50000; ++i)
+			v.push_back(T(i));
+		bool ok = true;
+		for (size_t k = 0; k < where.size(); ++k)
+			ok = ok && where[k] == &v[k * 97] && test::value_of(*where[k]) == static_cast<int>(k * 97);
+		CHECK(ok);
+	}
+
+	template <class T, size_t Segsiz>
+	void segments(size_t n) {
+		seg_vector<T, Segsiz> v;
+		for (size_t i = 0; i < n; ++i)
+			v.push_back(T(static_cast<int>(i)));
+		const size_t cap = v.segment_capacity();
+		CHECK((cap & (cap - 1)) == 0);
+		CHECK(v.segment_count() == (n + cap - 1) / cap);
+
+		size_t seen = 0;
+		bool ok = true;
+		for (size_t s = 0; s < v.segment_count(); ++s) {
+			const size_t len = v.segment_size(s);
+			ok = ok && (s + 1 == v.segment_count() ? len >= 1 && len <= cap : len == cap);
+			const T* p = v.segment_data(s);
+			for (size_t i = 0; i < len; ++i)
+				ok = ok && test::value_of(p[i]) == static_cast<int>(seen + i) && &p[i] == &v[seen + i];
+			seen += len;
+		}
+		CHECK(ok && seen == n);
+
+		size_t calls = 0;
+		seen = 0;
+		v.for_each_segment([&](T* first, T* last) {
+			++calls;
+			for (; first != last; ++first, ++seen)
+				ok = ok && test::value_of(*first) == static_cast<int>(seen);
+		});
+		CHECK(ok && seen == n && calls == v.segment_count());
+	}
+
+	template <class T, size_t Segsiz>
+	void pop_clear_swap() {
+		seg_vector<T, Segsiz> v;
+		for (int i = 0; i < 1000; ++i)
+			v.push_back(T(i));
+		for (int i = 999; i >= 300; --i) {
+			CHECK(test::value_of(v.back()) == i);
+			v.pop_back();
+		}
+		CHECK(v.size() == 300);
+		for (int i = 300; i < 700; ++i)
+			v.push_back(T(i));
+		bool ok = true;
+		for (int i = 0; i < 700; ++i)
+			ok = ok && test::value_of(v[i]) == i;
+		CHECK(ok);
+		while (!v.empty())
+			v.pop_back();
+		CHECK(v.size() == 0);
+
+		for (int i = 0; i < 100; ++i)
+			v.push_back(T(i));
+		v.clear();
+		CHECK(v.empty());
+		CHECK(v.segment_count() == 0);
+		v.push_back(T(5));
+		CHECK(v.size() == 1 && test::value_of(v[0]) == 5);
+
+		seg_vector<T, Segsiz> w;
+		for (int i = 0; i < 50; ++i)
+			w.push_back(T(i));
+		v.swap(w);
+		CHECK(v.size() == 50 && test::value_of(v[49]) == 49);
+		CHECK(w.size() == 1 && test::value_of(w[0]) == 5);
+	}
+
+	template <class T, size_t Segsiz>
+	void run_all() {
+		const long live = counted::live;
+		const size_t sizes[] = { 1, 3, 4, 5, 64, 1000, 20000 };
+		for (size_t n : sizes) {
+			push_and_index<T, Segsiz>(n);
+			segments<T, Segsiz>(n);
+		}
+		stable_addresses<T, Segsiz>();
+		pop_clear_swap<T, Segsiz>();
+		CHECK(counted::live == live);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+}
+
+int main() {
+	run_all<int, 0>();
+	run_all<int, 4>();
+	run_all<counted, 0>();
+	run_all<counted, 4>();
+	return test::result();
+}
@@ -0,0 +1,141 @@
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+#include "stl_set.h"
+#include "stl_map.h"
+#include "stl_multiset.h"
+#include "stl_multimap.h"
+#include "counted.h"
+#include "check.h"
+
+// The rb_tree containers: emplace with move-only and counted values,
+// then a random insert/erase workload checked against std::set and
+// std::multimap, which also exercises the rebalancing on erase.
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+
+	struct counted_less {
+		bool operator()(const counted& a, const counted& b) const { return a.value < b.value; }
+	};
+
+	template <class Container>
+	std::vector<int> values(const Container& c) {
+		std::vector<int> out;
+		for (auto it = c.begin(); it != c.end(); ++it)
+			out.push_back(*it);
+		return out;
+	}
+
+	unsigned next_random(unsigned& state) {
+		state = state * 1103515245u + 12345u;
+		return state >> 16;
+	}
+
+	void emplace_move_only() {
+		STL::map<int, std::unique_ptr<int>> m;
+		CHECK(m.emplace(2, new int(20)).second);
+		CHECK(m.emplace(1, std::make_unique<int>(10)).second);
+		CHECK(!m.emplace(2, new int(99)).second);
+		auto hint = m.emplace_hint(m.end(), 3, new int(30));
+		CHECK(hint->first == 3);
+		CHECK(m.size() == 3);
+		CHECK(*m.find(2)->second == 20);
+
+		STL::multimap<int, std::unique_ptr<int>> mm;
+		mm.emplace(1, new int(1));
+		mm.emplace(1, new int(2));
+		mm.emplace_hint(mm.begin(), 0, new int(0));
+		CHECK(mm.size() == 3);
+		CHECK(mm.count(1) == 2);
+		CHECK(*mm.begin()->second == 0);
+	}
+
+	void emplace_counted() {
+		{
+			STL::set<counted, counted_less, counting_alloc> s;
+			for (int i = 0; i < 50; ++i)
+				CHECK(s.emplace(i % 25).second == (i < 25));
+			CHECK(s.size() == 25);
+			CHECK(counted::live == 25);
+
+			counted c(100);
+			CHECK(s.insert(std::move(c)).second);
+			CHECK(c.moved_from);
+
+			STL::multiset<counted, counted_less, counting_alloc> ms;
+			for (int i = 0; i < 50; ++i)
+				ms.emplace(i % 25);
+			CHECK(ms.size() == 50);
+			CHECK(ms.count(counted(7)) == 2);
+
+			STL::set<counted, counted_less, counting_alloc> copy(s);
+			CHECK(copy.size() == s.size());
+			CHECK(copy.begin()->value == 0);
+			// c, moved from, is still alive.
+			CHECK(counted::live == 1 + 26 + 50 + 26);
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	void against_std() {
+		STL::set<int> s;
+		std::set<int> want;
+		STL::multimap<int, int> mm;
+		std::multimap<int, int> mm_want;
+		unsigned state = 1;
+		for (int i = 0; i < 20000; ++i) {
+			int k = static_cast<int>(next_random(state) % 500);
+			if (next_random(state) % 3 == 0) {
+				CHECK(s.erase(k) == want.erase(k));
+				CHECK(mm.erase(k) == mm_want.erase(k));
+			}
+			else {
+				CHECK(s.insert(k).second == want.insert(k).second);
+				mm.emplace(k, i);
+				mm_want.emplace(k, i);
+			}
+		}
+		CHECK(s.size() == want.size());
+		CHECK(values(s) == std::vector<int>(want.begin(), want.end()));
+		CHECK(mm.size() == mm_want.size());
+		bool same = true;
+		auto it = mm.begin();
+		for (auto& kv : mm_want) {
+			same = same && it->first == kv.first && it->second == kv.second;
+			++it;
+		}
+		CHECK(same);
+
+		int raw[] = { 5, 1, 4, 1, 3 };
+		STL::set<int> ranged(raw, raw + 5);
+		CHECK((values(ranged) == std::vector<int>{ 1, 3, 4, 5 }));
+		CHECK(*ranged.rbegin() == 5);
+		STL::set<int> copied(ranged);
+		CHECK(copied == ranged);
+		copied.erase(4);
+		CHECK(ranged < copied);
+		STL::multiset<int> multi(raw, raw + 5);
+		CHECK(multi.size() == 5);
+		CHECK(multi.count(1) == 2);
+
+		STL::map<int, int> m;
+		m[3] = 30;
+		m[1] = 10;
+		m[3] += 1;
+		CHECK(m.size() == 2);
+		CHECK(m[3] == 31);
+		CHECK(m.find(2) == m.end());
+	}
+}
+
+int main() {
+	emplace_move_only();
+	emplace_counted();
+	against_std();
+	return test::result();
+}
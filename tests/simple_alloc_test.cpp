@@ -0,0 +1,229 @@
+#include <cstdint>
+#include "alloc.h"
+#include "allocator.h"
+#include "arena_alloc.h"
+#include "stl_vector.h"
+#include "stl_list.h"
+#include "counted.h"
+#include "check.h"
+
+// simpleAlloc::reallocate and the POD vector growth built on it: growth in
+// place where the allocator allows it, forwarding to Alloc::reallocate, the
+// allocate-copy-free fallback, and over-aligned types that always take the
+// fallback. Then alignof(T) forwarding and cache_aligned_alloc.
+
+namespace {
+
+	using test::counting_alloc;
+
+	// malloc underneath, recording which entry points were used.
+	struct recording_alloc {
+		static inline size_t reallocations = 0;
+		static inline size_t aligned_allocations = 0;
+		static inline size_t last_align = 0;
+
+		static void* allocate(size_t n) { return STL::malloc_alloc::allocate(n); }
+		static void deallocate(void* p, size_t n) { STL::malloc_alloc::deallocate(p, n); }
+		static void* allocate(size_t n, size_t align) {
+			++aligned_allocations;
+			last_align = align;
+			return STL::malloc_alloc::allocate(n, align);
+		}
+		static void deallocate(void* p, size_t n, size_t align) { STL::malloc_alloc::deallocate(p, n, align); }
+		static void* reallocate(void* p, size_t old_sz, size_t new_sz) {
+			++reallocations;
+			return STL::malloc_alloc::reallocate(p, old_sz, new_sz);
+		}
+	};
+
+	struct alignas(64) line {
+		int value;
+		char pad[60];
+	};
+
+	bool aligned(const void* p, size_t align) {
+		return reinterpret_cast<std::uintptr_t>(p) % align == 0;
+	}
+
+	template <class T>
+	void iota(T* p, size_t n) {
+		for (size_t i = 0; i < n; ++i)
+			p[i] = static_cast<T>(i);
+	}
+
+	template <class T>
+	bool intact(const T* p, size_t n) {
+		for (size_t i = 0; i < n; ++i)
+			if (p[i] != static_cast<T>(i))
+				return false;
+		return true;
+	}
+
+	void in_place() {
+		// The arena extends its most recent block.
+		using arena = STL::__arena_alloc_template<false, 5>;
+		int* p = STL::simpleAlloc<int, arena>::allocate(10);
+		iota(p, 10);
+		int* q = STL::simpleAlloc<int, arena>::reallocate(p, 10, 1000);
+		CHECK(q == p);
+		CHECK(intact(q, 10));
+
+		// The pool keeps a block whose size class does not change.
+		int* r = STL::simpleAlloc<int, STL::alloc>::allocate(3);
+		iota(r, 3);
+		CHECK((STL::simpleAlloc<int, STL::alloc>::reallocate(r, 3, 4) == r));
+		CHECK(intact(r, 3));
+		STL::simpleAlloc<int, STL::alloc>::deallocate(r, 4);
+
+		// A POD vector on the arena moves only when its block runs out.
+		{
+			STL::vector<int, arena> v;
+			size_t grows = 0, moves = 0;
+			const int* data = nullptr;
+			size_t capacity = 0;
+			for (int i = 0; i < 10000; ++i) {
+				v.push_back(i);
+				if (v.capacity() != capacity) {
+					++grows;
+					moves += data != nullptr && &v[0] != data;
+					capacity = v.capacity();
+					data = &v[0];
+				}
+			}
+			CHECK(grows > 10);
+			CHECK(moves < grows / 2);
+			CHECK(intact(&v[0], v.size()));
+		}
+		arena::reset();
+	}
+
+	void forwarding_and_fallback() {
+		// An allocator with reallocate gets the call.
+		recording_alloc::reallocations = 0;
+		int* p = STL::simpleAlloc<int, recording_alloc>::allocate(100);
+		iota(p, 100);
+		p = STL::simpleAlloc<int, recording_alloc>::reallocate(p, 100, 100000);
+		CHECK(recording_alloc::reallocations == 1);
+		CHECK(intact(p, 100));
+		STL::simpleAlloc<int, recording_alloc>::deallocate(p, 100000);
+
+		// One without it gets allocate, copy, deallocate.
+		const size_t before = counting_alloc::allocations;
+		int* q = STL::simpleAlloc<int, counting_alloc>::allocate(100);
+		iota(q, 100);
+		int* moved = STL::simpleAlloc<int, counting_alloc>::reallocate(q, 100, 300);
+		CHECK(counting_alloc::allocations == before + 2);
+		CHECK(counting_alloc::live_bytes == static_cast<long>(300 * sizeof(int)));
+		CHECK(intact(moved, 100));
+		// Shrinking copies only what fits.
+		moved = STL::simpleAlloc<int, counting_alloc>::reallocate(moved, 300, 50);
+		CHECK(intact(moved, 50));
+		CHECK(counting_alloc::live_bytes == static_cast<long>(50 * sizeof(int)));
+		STL::simpleAlloc<int, counting_alloc>::deallocate(moved, 50);
+		CHECK(counting_alloc::live_bytes == 0);
+
+		// Null and empty blocks are plain allocations; zero elements frees.
+		int* fresh = STL::simpleAlloc<int, counting_alloc>::reallocate(nullptr, 0, 8);
+		CHECK(fresh != nullptr);
+		CHECK((STL::simpleAlloc<int, counting_alloc>::reallocate(fresh, 8, 0) == nullptr));
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	// Alloc::reallocate knows nothing of alignment, so over-aligned blocks
+	// never reach it, even from a POD vector's expand().
+	void over_aligned() {
+		recording_alloc::reallocations = 0;
+		recording_alloc::aligned_allocations = 0;
+		line* p = STL::simpleAlloc<line, recording_alloc>::allocate(4);
+		CHECK(aligned(p, 64));
+		for (int i = 0; i < 4; ++i)
+			p[i].value = i;
+		p = STL::simpleAlloc<line, recording_alloc>::reallocate(p, 4, 64);
+		CHECK(recording_alloc::reallocations == 0);
+		CHECK(recording_alloc::aligned_allocations == 2);
+		CHECK(recording_alloc::last_align == 64);
+		CHECK(aligned(p, 64));
+		CHECK(p[3].value == 3);
+		STL::simpleAlloc<line, recording_alloc>::deallocate(p, 64);
+
+		STL::vector<line, recording_alloc> v;
+		bool all_aligned = true;
+		for (int i = 0; i < 1000; ++i) {
+			line l = { i, { } };
+			v.push_back(l);
+			all_aligned = all_aligned && aligned(&v[0], 64);
+		}
+		CHECK(all_aligned);
+		CHECK(recording_alloc::reallocations == 0);
+		bool kept = true;
+		for (int i = 0; i < 1000; ++i)
+			kept = kept && v[i].value == i;
+		CHECK(kept);
+	}
+
+	struct alignas(16) quad { double v[2]; };
+	struct alignas(128) wide_line { char bytes[128]; };
+
+	// Every single, array and batch allocation of T through Alloc.
+	template <class T, class Alloc>
+	bool all_aligned(size_t align) {
+		using a = STL::simpleAlloc<T, Alloc>;
+		bool ok = true;
+		T* one = a::allocate();
+		ok = ok && aligned(one, align);
+		a::deallocate(one);
+		for (size_t n = 1; n <= 33; n += 4) {
+			T* p = a::allocate(n);
+			ok = ok && aligned(p, align);
+			a::deallocate(p, n);
+		}
+		T* batch[9];
+		a::allocate_batch(9, batch);
+		for (T* p : batch)
+			ok = ok && aligned(p, align);
+		a::deallocate_batch(batch, 9);
+		return ok;
+	}
+
+	void alignment() {
+		// alignof(T) reaches the pool, which hands over-aligned requests to
+		// the aligned malloc path.
+		CHECK((all_aligned<quad, STL::alloc>(16)));
+		CHECK((all_aligned<line, STL::alloc>(64)));
+		CHECK((all_aligned<wide_line, STL::alloc>(128)));
+
+		recording_alloc::aligned_allocations = 0;
+		CHECK((all_aligned<wide_line, recording_alloc>(128)));
+		CHECK(recording_alloc::last_align == 128);
+		CHECK(recording_alloc::aligned_allocations == 1 + 9 + 9);
+
+		// cache_aligned_alloc lifts everything to a cache line, and keeps
+		// larger alignments.
+		CHECK((all_aligned<char, STL::cache_aligned_alloc>(STL::__CACHE_LINE)));
+		CHECK((all_aligned<int, STL::cache_aligned_alloc>(STL::__CACHE_LINE)));
+		CHECK((all_aligned<wide_line, STL::cache_aligned_alloc>(128)));
+		void* raw = STL::cache_aligned_alloc::allocate(24);
+		CHECK(aligned(raw, STL::__CACHE_LINE));
+		STL::cache_aligned_alloc::deallocate(raw, 24);
+
+		// Containers of over-aligned elements.
+		STL::vector<line> v;
+		STL::list<line> l;
+		bool ok = true;
+		for (int i = 0; i < 200; ++i) {
+			line x = { i, { } };
+			v.push_back(x);
+			l.push_back(x);
+			ok = ok && aligned(&v[0], 64) && aligned(&l.back(), 64);
+		}
+		CHECK(ok);
+	}
+}
+
+int main() {
+	in_place();
+	forwarding_and_fallback();
+	over_aligned();
+	alignment();
+	return test::result();
+}
@@ -0,0 +1,69 @@
+#include <memory>
+#include <vector>
+#include "slist.h"
+#include "counted.h"
+#include "check.h"
+
+// slist: emplace_front with move-only and counted elements, and the
+// range, copy and move constructors.
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+
+	template <class List>
+	std::vector<int> values(const List& l) {
+		std::vector<int> out;
+		for (auto it = l.begin(); it != l.end(); ++it)
+			out.push_back(test::value_of(*it));
+		return out;
+	}
+
+	void emplace_move_only() {
+		STL::slist<std::unique_ptr<int>> l;
+		l.emplace_front(new int(3));
+		l.push_front(std::make_unique<int>(2));
+		CHECK(*l.emplace_front(new int(1)) == 1);
+		CHECK(l.size() == 3);
+
+		STL::slist<std::unique_ptr<int>> moved(std::move(l));
+		CHECK(l.empty());
+		int want = 1;
+		for (auto it = moved.begin(); it != moved.end(); ++it)
+			CHECK(**it == want++);
+		moved.pop_front();
+		CHECK(*moved.front() == 2);
+	}
+
+	void construct_and_copy() {
+		{
+			int raw[] = { 4, 1, 7, 2 };
+			STL::slist<counted, counting_alloc> a(raw, raw + 4);
+			CHECK((values(a) == std::vector<int>{ 4, 1, 7, 2 }));
+
+			STL::slist<counted, counting_alloc> b(a);
+			CHECK(values(b) == values(a));
+			CHECK(counted::live == 8);
+
+			counted c(9);
+			b.push_front(std::move(c));
+			CHECK(c.moved_from);
+			a = b;
+			CHECK((values(a) == std::vector<int>{ 9, 4, 1, 7, 2 }));
+			CHECK(counted::live == 11);
+
+			b.clear();
+			CHECK(b.empty());
+			CHECK(counted::live == 6);
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+}
+
+int main() {
+	emplace_move_only();
+	construct_and_copy();
+	return test::result();
+}
@@ -0,0 +1,154 @@
+#include <vector>
+#include "stl_vector.h"
+#include "counted.h"
+#include "check.h"
+
+// insert(pos, first, last), assign(first, last) and append(first, last)
+// for input, forward and random-access ranges.
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+	using test::equals;
+
+	// A forward iterator over an array, so the forward (not the
+	// random-access) overloads run.
+	class forward_iter : public STL::iterator<STL::forward_iterator_tag, int> {
+		const int* p;
+	public:
+		explicit forward_iter(const int* q) : p(q) { }
+		const int& operator*() const { return *p; }
+		forward_iter& operator++() { ++p; return *this; }
+		forward_iter operator++(int) { forward_iter tmp = *this; ++p; return tmp; }
+		bool operator==(const forward_iter& rhs) const { return p == rhs.p; }
+		bool operator!=(const forward_iter& rhs) const { return p != rhs.p; }
+	};
+
+	// A single-pass input iterator: the range cannot be measured up front.
+	class input_iter : public STL::iterator<STL::input_iterator_tag, int> {
+		const int* p;
+	public:
+		explicit input_iter(const int* q) : p(q) { }
+		const int& operator*() const { return *p; }
+		input_iter& operator++() { ++p; return *this; }
+		bool operator==(const input_iter& rhs) const { return p == rhs.p; }
+		bool operator!=(const input_iter& rhs) const { return p != rhs.p; }
+	};
+
+	std::vector<int> source(int n, int from) {
+		std::vector<int> v;
+		for (int i = 0; i < n; ++i)
+			v.push_back(from + i);
+		return v;
+	}
+
+	template <class T, class Iter>
+	void insert_ranges() {
+		const int counts[] = { 0, 1, 3, 8, 40 };
+		for (int n : counts) {
+			for (int spare = 0; spare < 2; ++spare) {
+				for (int at = 0; at < 3; ++at) {
+					STL::vector<T, counting_alloc> v;
+					std::vector<int> want = source(10, 0);
+					for (int i = 0; i < 10; ++i)
+						v.push_back(T(i));
+					// Room for the whole range, or none.
+					if (spare)
+						v.reserve(v.size() + n);
+					const size_t pos = at == 0 ? 0 : at == 1 ? 3 : v.size();
+					const std::vector<int> range = source(n, 100);
+					v.insert(v.begin() + pos, Iter(range.data()), Iter(range.data() + n));
+					want.insert(want.begin() + pos, range.begin(), range.end());
+					CHECK(equals(v, want));
+				}
+			}
+		}
+	}
+
+	template <class T, class Iter>
+	void assign_ranges() {
+		const int counts[] = { 0, 2, 10, 25, 100 };
+		for (int n : counts) {
+			STL::vector<T, counting_alloc> v;
+			for (int i = 0; i < 10; ++i)
+				v.push_back(T(i));
+			v.reserve(20);
+			const std::vector<int> range = source(n, 50);
+			v.assign(Iter(range.data()), Iter(range.data() + n));
+			CHECK(equals(v, range));
+		}
+	}
+
+	template <class T, class Iter>
+	void append_ranges() {
+		STL::vector<T, counting_alloc> v;
+		std::vector<int> want;
+		for (int round = 0; round < 6; ++round) {
+			const std::vector<int> range = source(round * 7, round * 100);
+			v.append(Iter(range.data()), Iter(range.data() + range.size()));
+			want.insert(want.end(), range.begin(), range.end());
+			CHECK(equals(v, want));
+		}
+	}
+
+	// Measured ranges allocate once, however long.
+	template <class T>
+	void single_allocation() {
+		const std::vector<int> range = source(1000, 0);
+		STL::vector<T, counting_alloc> v;
+		v.push_back(T(-1));
+		size_t before = counting_alloc::allocations;
+		v.append(range.data(), range.data() + range.size());
+		CHECK(counting_alloc::allocations == before + 1);
+
+		before = counting_alloc::allocations;
+		v.insert(v.begin() + 1, forward_iter(range.data()), forward_iter(range.data() + range.size()));
+		CHECK(counting_alloc::allocations == before + 1);
+
+		before = counting_alloc::allocations;
+		v.assign(range.data(), range.data() + range.size());
+		CHECK(counting_alloc::allocations == before);
+		CHECK(equals(v, range));
+
+		STL::vector<T, counting_alloc> w;
+		before = counting_alloc::allocations;
+		w.assign(forward_iter(range.data()), forward_iter(range.data() + range.size()));
+		CHECK(counting_alloc::allocations == before + 1);
+		CHECK(w.capacity() == range.size());
+	}
+
+	// Integral arguments mean (n, value), not a range.
+	void integral_arguments() {
+		STL::vector<int, counting_alloc> v;
+		v.insert(v.begin(), 3, 7);
+		CHECK(equals(v, std::vector<int>(3, 7)));
+		v.assign(5, 1);
+		CHECK(equals(v, std::vector<int>(5, 1)));
+	}
+
+	template <class T>
+	void run_all() {
+		const long live = counted::live;
+		insert_ranges<T, const int*>();
+		insert_ranges<T, forward_iter>();
+		insert_ranges<T, input_iter>();
+		assign_ranges<T, const int*>();
+		assign_ranges<T, forward_iter>();
+		assign_ranges<T, input_iter>();
+		append_ranges<T, const int*>();
+		append_ranges<T, forward_iter>();
+		append_ranges<T, input_iter>();
+		single_allocation<T>();
+		CHECK(counted::live == live);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+}
+
+int main() {
+	run_all<int>();
+	run_all<counted>();
+	integral_arguments();
+	CHECK(counting_alloc::live_bytes == 0);
+	return test::result();
+}
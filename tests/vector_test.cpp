@@ -0,0 +1,403 @@
+#include <vector>
+#include "stl_vector.h"
+#include "small_vector.h"
+#include "counted.h"
+#include "check.h"
+
+// One suite, run on vector and on small_vector with an inline capacity
+// both below and above the sizes it uses. Each case also checks that
+// every element and every byte was released at the end.
+
+namespace {
+
+	// Owns a heap int. Its moves and destructions are counted, so a test can
+	// tell a memmove relocation from element-wise moves.
+	template <int Tag>
+	struct owner {
+		static inline long moves = 0;
+		static inline long destroyed = 0;
+		static inline long live = 0;
+		int* p;
+
+		owner(int v) : p(new int(v)) { ++live; }
+		owner(const owner& rhs) : p(new int(*rhs.p)) { ++live; }
+		owner(owner&& rhs) noexcept : p(rhs.p) {
+			rhs.p = nullptr;
+			++moves;
+			++live;
+		}
+		owner& operator=(owner rhs) noexcept {
+			int* tmp = p;
+			p = rhs.p;
+			rhs.p = tmp;
+			return *this;
+		}
+		~owner() {
+			delete p;
+			++destroyed;
+			--live;
+		}
+	};
+
+	using relocatable_owner = owner<0>;
+	using moving_owner = owner<1>;
+}
+
+namespace STL {
+	template <>
+	struct __is_trivially_relocatable<relocatable_owner> {
+		using type = __true_type;
+	};
+}
+
+namespace {
+
+	using test::counted;
+	using test::counting_alloc;
+	using test::equals;
+
+	template <class T> using plain_vector = STL::vector<T, counting_alloc>;
+	template <class T> using small_vector_4 = STL::small_vector<T, 4, counting_alloc>;
+	template <class T> using small_vector_64 = STL::small_vector<T, 64, counting_alloc>;
+
+	std::vector<int> iota(int n, int from = 0) {
+		std::vector<int> v;
+		for (int i = 0; i < n; ++i)
+			v.push_back(from + i);
+		return v;
+	}
+
+	template <template <class> class Vec, class T>
+	void push_and_index() {
+		Vec<T> v;
+		CHECK(v.empty());
+		for (int i = 0; i < 40; ++i)
+			v.push_back(T(i));
+		CHECK(equals(v, iota(40)));
+		CHECK(test::value_of(v.front()) == 0);
+		CHECK(test::value_of(v.back()) == 39);
+		CHECK(v.end() - v.begin() == 40);
+		CHECK(test::value_of(v.emplace_back(99)) == 99);
+		v.pop_back();
+		v.pop_back();
+		CHECK(equals(v, iota(39)));
+	}
+
+	template <template <class> class Vec, class T>
+	void insert_one() {
+		Vec<T> v;
+		std::vector<int> want;
+		for (int i = 0; i < 30; ++i) {
+			const size_t at = i % 3 == 0 ? 0 : i % 3 == 1 ? v.size() / 2 : v.size();
+			CHECK(v.insert(v.begin() + at, T(i)) == v.begin() + at);
+			want.insert(want.begin() + at, i);
+		}
+		CHECK(equals(v, want));
+
+		// An argument that refers into the vector itself.
+		v.insert(v.begin(), v[5]);
+		want.insert(want.begin(), want[5]);
+		CHECK(equals(v, want));
+	}
+
+	template <template <class> class Vec, class T>
+	void insert_fill() {
+		Vec<T> v;
+		std::vector<int> want;
+		const size_t counts[] = { 0, 1, 3, 10, 2, 40 };
+		int value = 0;
+		for (size_t n : counts) {
+			for (size_t at : { size_t(0), v.size() / 2, v.size() }) {
+				v.insert(v.begin() + at, n, T(value));
+				want.insert(want.begin() + at, n, value);
+				++value;
+			}
+			CHECK(equals(v, want));
+		}
+		// With room to spare, so the in-place paths run.
+		v.reserve(v.size() + 100);
+		v.insert(v.begin() + 1, 3, T(-1));
+		want.insert(want.begin() + 1, 3, -1);
+		v.insert(v.begin() + 2, 50, T(-2));
+		want.insert(want.begin() + 2, 50, -2);
+		CHECK(equals(v, want));
+	}
+
+	template <template <class> class Vec, class T>
+	void erase_one() {
+		Vec<T> v;
+		std::vector<int> want = iota(20);
+		for (int i = 0; i < 20; ++i)
+			v.push_back(T(i));
+		CHECK(v.erase(v.begin()) == v.begin());
+		want.erase(want.begin());
+		v.erase(v.begin() + 7);
+		want.erase(want.begin() + 7);
+		v.erase(v.end() - 1);
+		want.pop_back();
+		CHECK(equals(v, want));
+	}
+
+	template <template <class> class Vec, class T>
+	void reserve_resize_clear() {
+		Vec<T> v;
+		for (int i = 0; i < 10; ++i)
+			v.push_back(T(i));
+		v.reserve(100);
+		CHECK(v.capacity() >= 100);
+		CHECK(equals(v, iota(10)));
+		v.reserve(5);
+		CHECK(v.capacity() >= 100);
+
+		v.resize(15, T(7));
+		std::vector<int> want = iota(10);
+		want.resize(15, 7);
+		CHECK(equals(v, want));
+		v.resize(4);
+		CHECK(equals(v, iota(4)));
+		v.resize(6);
+		want = iota(4);
+		want.resize(6, 0);
+		CHECK(equals(v, want));
+
+		v.clear();
+		CHECK(v.empty());
+		v.push_back(T(1));
+		CHECK(equals(v, iota(1, 1)));
+	}
+
+	template <template <class> class Vec, class T>
+	void copy_move_swap() {
+		Vec<T> a, b;
+		for (int i = 0; i < 3; ++i)
+			a.push_back(T(i));
+		for (int i = 0; i < 50; ++i)
+			b.push_back(T(100 + i));
+
+		Vec<T> c(a);
+		CHECK(equals(c, iota(3)));
+		c = b;
+		CHECK(equals(c, iota(50, 100)));
+		c = c;
+		CHECK(equals(c, iota(50, 100)));
+
+		Vec<T> d(std::move(c));
+		CHECK(equals(d, iota(50, 100)));
+		c = std::move(d);
+		CHECK(equals(c, iota(50, 100)));
+
+		a.swap(b);
+		CHECK(equals(a, iota(50, 100)));
+		CHECK(equals(b, iota(3)));
+		b.swap(b);
+		CHECK(equals(b, iota(3)));
+		Vec<T> e;
+		e.swap(b);
+		CHECK(equals(e, iota(3)));
+		CHECK(b.empty());
+	}
+
+	template <template <class> class Vec, class T>
+	void run_case(void (*f)()) {
+		const long live = counted::live;
+		f();
+		CHECK(counted::live == live);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	template <template <class> class Vec, class T>
+	void suite() {
+		run_case<Vec, T>(push_and_index<Vec, T>);
+		run_case<Vec, T>(insert_one<Vec, T>);
+		run_case<Vec, T>(insert_fill<Vec, T>);
+		run_case<Vec, T>(erase_one<Vec, T>);
+		run_case<Vec, T>(reserve_resize_clear<Vec, T>);
+		run_case<Vec, T>(copy_move_swap<Vec, T>);
+	}
+
+	// small_vector only: nothing is allocated until the size passes N.
+	void small_vector_stays_inline() {
+		const size_t before = counting_alloc::allocations;
+		{
+			small_vector_4<counted> v;
+			for (int i = 0; i < 4; ++i)
+				v.push_back(counted(i));
+			CHECK(v.is_inline());
+			CHECK(counting_alloc::allocations == before);
+			v.push_back(counted(4));
+			CHECK(!v.is_inline());
+			CHECK(counting_alloc::allocations == before + 1);
+			CHECK(equals(v, iota(5)));
+
+			small_vector_4<counted> w;
+			w.push_back(counted(9));
+			v.swap(w);
+			CHECK(v.is_inline());
+			CHECK(equals(v, iota(1, 9)));
+			CHECK(equals(w, iota(5)));
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	// The capacities a vector goes through while push_back grows it one
+	// element at a time.
+	template <class T, class Growth>
+	std::vector<size_t> capacities(size_t n) {
+		std::vector<size_t> seen;
+		STL::vector<T, counting_alloc, Growth> v;
+		for (size_t i = 0; i < n; ++i) {
+			v.push_back(T(static_cast<int>(i)));
+			if (seen.empty() || seen.back() != v.capacity())
+				seen.push_back(v.capacity());
+		}
+		return seen;
+	}
+
+	struct bytes24 {
+		int value;
+		char pad[20];
+		bytes24(int v = 0) : value(v) { }
+	};
+
+	// Once the required size reaches MinBytes each step adds a quarter and
+	// ends on a page boundary.
+	template <class T>
+	void check_page_rounded(size_t page, size_t min_bytes, const std::vector<size_t>& seen) {
+		bool doubled = true;
+		bool paged = true;
+		size_t large_steps = 0;
+		for (size_t i = 1; i < seen.size(); ++i) {
+			if ((seen[i - 1] + 1) * sizeof(T) < min_bytes) {
+				doubled = doubled && seen[i] == 2 * seen[i - 1];
+				continue;
+			}
+			++large_steps;
+			const size_t bytes = seen[i] * sizeof(T);
+			const size_t rounded = (bytes + page - 1) / page * page;
+			paged = paged && rounded - bytes < sizeof(T);
+			paged = paged && seen[i] >= seen[i - 1] + seen[i - 1] / 4 && seen[i] < seen[i - 1] + seen[i - 1] / 4 + page / sizeof(T) + 1;
+		}
+		CHECK(doubled);
+		CHECK(paged);
+		CHECK(large_steps >= 3);
+	}
+
+	void growth_policies() {
+		CHECK((capacities<int, STL::__geometric_growth<> >(1000)
+			== std::vector<size_t>{ 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024 }));
+		CHECK((capacities<counted, STL::__geometric_growth<3, 2> >(50)
+			== std::vector<size_t>{ 1, 2, 3, 4, 6, 9, 13, 19, 28, 42, 63 }));
+		CHECK((capacities<int, STL::__geometric_growth<3, 2> >(50)
+			== std::vector<size_t>{ 1, 2, 3, 4, 6, 9, 13, 19, 28, 42, 63 }));
+
+		// Nothing below what was asked for.
+		CHECK(STL::__geometric_growth<>::next(8, 100, 4) == 100);
+		CHECK((STL::__page_rounded_growth<4096, 65536>::next(100000, 200000, 4) == 200704));
+
+		using paged = STL::__page_rounded_growth<4096, 65536>;
+		check_page_rounded<int>(4096, 65536, capacities<int, paged>(200000));
+		check_page_rounded<bytes24>(4096, 65536, capacities<bytes24, paged>(20000));
+		CHECK(counting_alloc::live_bytes == 0);
+		CHECK(counted::live == 0);
+	}
+
+	template <class T>
+	void shrink_and_report() {
+		{
+			plain_vector<T> v;
+			STL::memory_usage usage = v.memory_report();
+			CHECK(usage.used_bytes == 0 && usage.allocated_bytes == 0);
+			CHECK(usage.overhead() == 0.0);
+
+			v.reserve(100);
+			for (int i = 0; i < 75; ++i)
+				v.push_back(T(i));
+			usage = v.memory_report();
+			CHECK(usage.used_bytes == 75 * sizeof(T));
+			CHECK(usage.allocated_bytes == 100 * sizeof(T));
+			CHECK(usage.slack_bytes() == 25 * sizeof(T));
+			CHECK(usage.overhead() == 0.25);
+			CHECK(counting_alloc::live_bytes == static_cast<long>(100 * sizeof(T)));
+
+			v.shrink_to_fit();
+			CHECK(v.capacity() == 75);
+			CHECK(equals(v, iota(75)));
+			usage = v.memory_report();
+			CHECK(usage.slack_bytes() == 0);
+			CHECK(usage.overhead() == 0.0);
+			CHECK(counting_alloc::live_bytes == static_cast<long>(75 * sizeof(T)));
+
+			// Already tight: nothing moves.
+			const T* data = &v[0];
+			v.shrink_to_fit();
+			CHECK(&v[0] == data);
+
+			v.clear();
+			v.shrink_to_fit();
+			CHECK(v.capacity() == 0);
+			CHECK(v.memory_report().allocated_bytes == 0);
+			CHECK(counting_alloc::live_bytes == 0);
+		}
+		CHECK(counted::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+
+	// Growth at the back, growth from an insert in the middle of a full
+	// vector, reserve and shrink_to_fit all relocate a relocatable type with
+	// memmove: no element is moved or destroyed on the way.
+	template <class T>
+	void grow(STL::vector<T, counting_alloc>& v) {
+		for (int i = 0; i < 1024; ++i)
+			v.emplace_back(i);
+		CHECK(v.size() == v.capacity());
+		v.insert(v.begin() + 512, T(-1));
+		v.reserve(4 * v.capacity());
+		v.shrink_to_fit();
+	}
+
+	template <class T>
+	bool owner_values(const STL::vector<T, counting_alloc>& v) {
+		bool ok = v.size() == 1025 && *v[512].p == -1;
+		for (int i = 0; i < 1024; ++i)
+			ok = ok && *v[i < 512 ? i : i + 1].p == i;
+		return ok;
+	}
+
+	void relocatable_growth() {
+		{
+			STL::vector<relocatable_owner, counting_alloc> v;
+			grow(v);
+			CHECK(owner_values(v));
+			// Only the temporary passed to insert was moved from and destroyed.
+			CHECK(relocatable_owner::moves == 1);
+			CHECK(relocatable_owner::destroyed == 1);
+		}
+		CHECK(relocatable_owner::live == 0);
+
+		{
+			STL::vector<moving_owner, counting_alloc> v;
+			grow(v);
+			CHECK(owner_values(v));
+			CHECK(moving_owner::moves > 1000);
+			CHECK(moving_owner::destroyed == moving_owner::moves);
+		}
+		CHECK(moving_owner::live == 0);
+		CHECK(counting_alloc::live_bytes == 0);
+	}
+}
+
+int main() {
+	suite<plain_vector, int>();
+	suite<plain_vector, counted>();
+	suite<small_vector_4, int>();
+	suite<small_vector_4, counted>();
+	suite<small_vector_64, int>();
+	suite<small_vector_64, counted>();
+	small_vector_stays_inline();
+	growth_policies();
+	shrink_and_report<int>();
+	shrink_and_report<counted>();
+	relocatable_growth();
+	return test::result();
+}